@@ -0,0 +1,176 @@
+// 路径名展开微基准
+//
+// 生成两层子目录的合成源码树，测量递归（src/**/*.cpp，单线程与线程池）与
+// 非递归模式的展开延迟，并与 find 列出同样文件的耗时对比。
+// 任一展开测量的 p99 超过阈值时以非零状态退出，可作为回归门禁。
+
+#include "core/glob.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct Options {
+    int iterations = 20;
+    int dirs = 4000;
+    int files = 25;
+    double maxP99Ms = 200.0;
+};
+
+struct Result {
+    std::string measure;
+    double p50Us = 0;
+    double p99Us = 0;
+    size_t matches = 0;
+    bool gated = true;
+};
+
+// root/pNN/qNN/ 下的文件，.cpp 与 .h 各占一半
+bool writeTree(const std::string& root, const Options& options) {
+    const int fanout = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(options.dirs))));
+    int created = 0;
+    for (int p = 0; created < options.dirs; ++p) {
+        const std::string parent = root + "/p" + std::to_string(p);
+        if (mkdir(parent.c_str(), 0755) != 0) return false;
+        for (int q = 0; q < fanout && created < options.dirs; ++q, ++created) {
+            const std::string dir = parent + "/q" + std::to_string(q);
+            if (mkdir(dir.c_str(), 0755) != 0) return false;
+            for (int f = 0; f < options.files; ++f) {
+                const std::string file = dir + "/module_" + std::to_string(f) + (f % 2 ? ".h" : ".cpp");
+                int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd < 0) return false;
+                close(fd);
+            }
+        }
+    }
+    return true;
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// run 执行一次被测操作并返回结果条数
+template <typename Run>
+Result measure(std::string name, int iterations, Run run) {
+    Result result;
+    result.measure = std::move(name);
+    result.matches = run();  // 预热（同时让目录项进入缓存）
+
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(iterations));
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        samples.push_back(elapsedUs(start));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    };
+    result.p50Us = percentile(0.50);
+    result.p99Us = percentile(0.99);
+    return result;
+}
+
+// find 输出的行数
+size_t runFind(const std::string& command) {
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) return 0;
+    size_t lines = 0;
+    char buffer[65536];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        lines += static_cast<size_t>(std::count(buffer, buffer + n, '\n'));
+    }
+    pclose(pipe);
+    return lines;
+}
+
+void usage(const char* argv0) {
+    std::printf("Usage: %s [options]\n"
+                "  --dirs N          叶子目录数（默认 4000）\n"
+                "  --files N         每个目录的文件数（默认 25）\n"
+                "  --iterations N    每项测量的迭代次数（默认 20）\n"
+                "  --max-p99-ms X    每项展开测量的 p99 阈值，超过时退出码为 1（默认 200）\n",
+                argv0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--dirs") options.dirs = std::max(1, std::atoi(next()));
+        else if (arg == "--files") options.files = std::max(1, std::atoi(next()));
+        else if (arg == "--iterations") options.iterations = std::max(1, std::atoi(next()));
+        else if (arg == "--max-p99-ms") options.maxP99Ms = std::atof(next());
+        else {
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    char pattern[] = "/tmp/leizi_glob_bench_XXXXXX";
+    if (!mkdtemp(pattern)) {
+        std::perror("mkdtemp");
+        return 2;
+    }
+    const std::string root = pattern;
+    const std::string cleanup = "rm -rf '" + root + "'";
+
+    std::fprintf(stderr, "creating %d directories x %d files...\n", options.dirs, options.files);
+    if (!writeTree(root, options)) {
+        std::fprintf(stderr, "glob_benchmark: failed to create tree in %s\n", root.c_str());
+        std::system(cleanup.c_str());
+        return 2;
+    }
+
+    const GlobPattern recursive(root + "/**/*.cpp");
+    const GlobPattern fixedDepth(root + "/*/*/*.h");
+    const unsigned threads = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+
+    std::vector<Result> results;
+    results.push_back(measure("glob **/*.cpp (1 thread)", options.iterations,
+                              [&] { return recursive.expand(1).size(); }));
+    results.push_back(measure("glob **/*.cpp (" + std::to_string(threads) + " threads)", options.iterations,
+                              [&] { return recursive.expand().size(); }));
+    results.push_back(measure("glob */*/*.h", options.iterations, [&] { return fixedDepth.expand().size(); }));
+
+    Result find = measure("find -name '*.cpp'", options.iterations,
+                          [&] { return runFind("find '" + root + "' -name '*.cpp'"); });
+    find.gated = false;
+    results.push_back(find);
+
+    std::system(cleanup.c_str());
+
+    bool failed = false;
+    std::printf("%-36s %12s %12s %8s\n", "measure", "p50 (us)", "p99 (us)", "matches");
+    for (const auto& r : results) {
+        bool over = r.gated && r.p99Us > options.maxP99Ms * 1000.0;
+        failed = failed || over;
+        std::printf("%-36s %12.1f %12.1f %8zu%s\n", r.measure.c_str(), r.p50Us, r.p99Us, r.matches,
+                    over ? "  FAIL" : "");
+    }
+    std::printf("\nrecursive glob p50 vs find: %.2fx\n", find.p50Us / std::max(1.0, results[1].p50Us));
+
+    if (failed) {
+        std::printf("\np99 exceeded %.3f ms\n", options.maxP99Ms);
+        return 1;
+    }
+    return 0;
+}
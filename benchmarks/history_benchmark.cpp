@@ -0,0 +1,210 @@
+// 历史搜索微基准
+//
+// 生成指定条数的合成历史文件，测量加载、首次建立三元组索引与建议前缀索引，
+// 常见、少见、不存在与短查询的 p50/p99 延迟，以及输入建议每次按键的延迟。
+// 任一测量的 p99 超过阈值时以非零状态退出，可作为回归门禁。
+
+#include "history/history_record.h"
+#include "history/history_search.h"
+#include "history/history_store.h"
+#include "history/history_suggest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace leizi;
+
+namespace {
+
+struct Options {
+    int iterations = 200;
+    int entries = 1000000;
+    double maxP99Ms = 1.0;
+};
+
+struct Result {
+    std::string measure;
+    double p50Us = 0;
+    double p99Us = 0;
+    size_t matches = 0;
+};
+
+// 合成命令：少量高频命令加上大量带编号的参数，大约一半的记录是重复命令
+std::string syntheticCommand(std::mt19937& rng) {
+    static const char* const templates[] = {
+        "git status", "git diff", "ls -la", "make -j8", "cd ..",
+        "git commit -m 'fix issue #%u'", "vim src/module_%u.cpp", "cd ~/projects/service-%u",
+        "grep -rn handler_%u src/", "docker run --rm image:%u", "ssh build-%u.example.com",
+        "kubectl get pods -n team-%u", "python3 scripts/report.py --day %u", "cargo test case_%u",
+    };
+    constexpr size_t simple = 5;
+    constexpr size_t count = sizeof(templates) / sizeof(templates[0]);
+
+    const size_t pick = rng() % (count * 2);
+    if (pick < simple * 3) {
+        return templates[pick % simple];
+    }
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), templates[simple + rng() % (count - simple)],
+                  static_cast<unsigned>(rng() % 50000));
+    return buf;
+}
+
+bool writeHistory(const std::string& path, int entries) {
+    std::mt19937 rng(42);
+    std::string content(HistoryFormat::MAGIC);
+    content.reserve(static_cast<size_t>(entries) * 64);
+    HistoryRecord record;
+    record.cwd = "/home/user/projects";
+    for (int i = 0; i < entries; ++i) {
+        record.command = syntheticCommand(rng);
+        record.startTime = 1700000000 + i;
+        HistoryFormat::encode(record, content);
+    }
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+    return static_cast<bool>(file);
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// run 执行一次被测操作并返回结果条数
+template <typename Run>
+Result measure(std::string name, int iterations, Run run) {
+    Result result;
+    result.measure = std::move(name);
+    result.matches = run();  // 预热
+
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(iterations));
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        samples.push_back(elapsedUs(start));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    };
+    result.p50Us = percentile(0.50);
+    result.p99Us = percentile(0.99);
+    return result;
+}
+
+void usage(const char* argv0) {
+    std::printf("Usage: %s [options]\n"
+                "  --entries N       历史条数（默认 1000000）\n"
+                "  --iterations N    每个查询的迭代次数（默认 200）\n"
+                "  --max-p99-ms X    每项测量的 p99 阈值，超过时退出码为 1（默认 1）\n",
+                argv0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--entries") options.entries = std::max(1, std::atoi(next()));
+        else if (arg == "--iterations") options.iterations = std::max(1, std::atoi(next()));
+        else if (arg == "--max-p99-ms") options.maxP99Ms = std::atof(next());
+        else {
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    char pattern[] = "/tmp/leizi_history_bench_XXXXXX";
+    int fd = mkstemp(pattern);
+    if (fd < 0) {
+        std::perror("mkstemp");
+        return 2;
+    }
+    close(fd);
+    const std::string path = pattern;
+
+    std::fprintf(stderr, "writing %d entries...\n", options.entries);
+    if (!writeHistory(path, options.entries)) {
+        std::fprintf(stderr, "history_benchmark: failed to write %s\n", path.c_str());
+        unlink(path.c_str());
+        return 2;
+    }
+
+    HistoryStore store;
+    auto start = std::chrono::steady_clock::now();
+    store.load(path);
+    const double loadUs = elapsedUs(start);
+
+    HistorySearch search(store);
+    start = std::chrono::steady_clock::now();
+    search.sync();
+    const double indexUs = elapsedUs(start);
+
+    std::vector<Result> results;
+    for (const std::string query : {"git", "status", "module_4242.cpp", "team-17", "no-such-command", "gi", "cd"}) {
+        results.push_back(measure("search '" + query + "'", options.iterations,
+                                  [&] { return search.search(query, 8).size(); }));
+    }
+
+    // 补充索引之前按 Ctrl-R：索引为空，查询只扫描有限条数的旧记录；
+    // 之后按 shell 的批大小从新到旧补充
+    HistorySearch cold(store);
+    results.push_back(measure("search before backfill", options.iterations,
+                              [&] { return cold.search("module_4242.cpp", 8).size(); }));
+    results.push_back(measure("search backfill batch", options.iterations, [&] {
+        cold.sync(256);
+        return size_t {256};
+    }));
+
+    // 建议索引：空闲时每批补充的耗时就是按键可能等待的上限（与 shell 的批大小一致）
+    HistorySuggest suggest(store);
+    results.push_back(measure("suggest backfill batch", options.iterations, [&] {
+        suggest.sync(256);
+        return size_t {256};
+    }));
+    start = std::chrono::steady_clock::now();
+    suggest.sync(static_cast<size_t>(-1));
+    const double suggestUs = elapsedUs(start);
+
+    // 逐字输入时每次按键的查询
+    for (const std::string typed : {"git commit -m 'fix issue #4", "vim src/module_12", "kubectl get pods -n team-9"}) {
+        size_t length = 0;
+        results.push_back(measure("suggest '" + typed + "'", options.iterations, [&] {
+            length = length % typed.size() + 1;
+            return suggest.suggest(std::string_view(typed).substr(0, length), "/home/user/projects").empty()
+                       ? size_t {0} : size_t {1};
+        }));
+    }
+    unlink(path.c_str());
+
+    std::printf("entries %zu, distinct %zu, load %.1f ms, index %.1f ms, suggest index %.1f ms (%zu commands)\n\n",
+                search.indexedRecords(), search.distinctCommands(), loadUs / 1000.0, indexUs / 1000.0,
+                suggestUs / 1000.0, suggest.distinctCommands());
+
+    bool failed = false;
+    std::printf("%-36s %12s %12s %8s\n", "measure", "p50 (us)", "p99 (us)", "matches");
+    for (const auto& r : results) {
+        bool over = r.p99Us > options.maxP99Ms * 1000.0;
+        failed = failed || over;
+        std::printf("%-36s %12.1f %12.1f %8zu%s\n", r.measure.c_str(), r.p50Us, r.p99Us, r.matches,
+                    over ? "  FAIL" : "");
+    }
+
+    if (failed) {
+        std::printf("\np99 exceeded %.3f ms\n", options.maxP99Ms);
+        return 1;
+    }
+    return 0;
+}
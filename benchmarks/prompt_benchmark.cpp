@@ -0,0 +1,273 @@
+// 提示符生成微基准
+//
+// 在临时目录中用 git 命令构造不同规模的仓库，直接调用
+// PromptGenerator::generate 与 GitIntegration，统计 p50/p99 延迟与每次调用的分配次数。
+// 任一测量的 p99 超过阈值时以非零状态退出，可作为回归门禁。
+
+#include "prompt/git.h"
+#include "prompt/prompt.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// ---- 分配计数 ----
+
+namespace {
+std::atomic<std::uint64_t> g_allocations {0};
+} // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Options {
+    int iterations = 200;
+    int files = 100000;
+    double maxP99Ms = 100.0;
+    std::string only;  // 只运行指定场景
+    bool keep = false;
+};
+
+struct Result {
+    std::string scenario;
+    std::string measure;
+    double p50Us = 0;
+    double p99Us = 0;
+    double allocsPerCall = 0;
+};
+
+bool run(const std::string& dir, const std::string& command) {
+    std::string cmd = "cd '" + dir + "' && " + command + " >/dev/null 2>&1";
+    return std::system(cmd.c_str()) == 0;
+}
+
+bool git(const std::string& dir, const std::string& args) {
+    return run(dir, "git -c user.name=bench -c user.email=bench@example.com -c commit.gpgsign=false " + args);
+}
+
+void writeFiles(const std::string& dir, int count) {
+    // 每个子目录 1000 个文件，避免单目录过大
+    for (int i = 0; i < count; ++i) {
+        std::string sub = dir + "/d" + std::to_string(i / 1000);
+        if (i % 1000 == 0) mkdir(sub.c_str(), 0755);
+        std::ofstream(sub + "/f" + std::to_string(i) + ".txt") << i << "\n";
+    }
+}
+
+// 构造场景仓库；失败时返回 false
+bool setupScenario(const std::string& name, const std::string& dir, const Options& options) {
+    mkdir(dir.c_str(), 0755);
+    if (!git(dir, "init -q -b main .")) return false;
+
+    writeFiles(dir, name == "large" ? options.files : 100);
+    if (!git(dir, "add -A") || !git(dir, "commit -q -m initial")) return false;
+
+    // 上游分支落后两个提交，使 ahead/behind 有实际遍历
+    git(dir, "update-ref refs/remotes/origin/main HEAD");
+    git(dir, "config branch.main.remote origin");
+    git(dir, "config branch.main.merge refs/heads/main");
+    for (int i = 0; i < 2; ++i) {
+        std::ofstream(dir + "/d0/f0.txt", std::ios::app) << "change " << i << "\n";
+        git(dir, "commit -q -am change");
+    }
+
+    if (name == "dirty") {
+        for (int i = 0; i < 20; ++i) {
+            std::ofstream(dir + "/d0/f" + std::to_string(i) + ".txt", std::ios::app) << "dirty\n";
+            std::ofstream(dir + "/untracked" + std::to_string(i) + ".txt") << "new\n";
+        }
+    } else if (name == "detached") {
+        git(dir, "tag v1.0 HEAD~1");
+        git(dir, "checkout -q --detach HEAD~1");
+    }
+    return true;
+}
+
+Result measure(const std::string& scenario, const std::string& name, int iterations,
+               const std::function<void()>& body) {
+    body();  // 预热
+
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(iterations));
+    std::uint64_t allocs = 0;
+
+    for (int i = 0; i < iterations; ++i) {
+        std::uint64_t before = g_allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        allocs += g_allocations.load(std::memory_order_relaxed) - before;
+        samples.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    };
+
+    Result result;
+    result.scenario = scenario;
+    result.measure = name;
+    result.p50Us = percentile(0.50);
+    result.p99Us = percentile(0.99);
+    result.allocsPerCall = static_cast<double>(allocs) / iterations;
+    return result;
+}
+
+bool benchScenario(const std::string& scenario, const std::string& dir, const Options& options,
+                   std::vector<Result>& results) {
+    if (chdir(dir.c_str()) != 0) return false;
+
+    PromptOptions promptOptions;
+    promptOptions.rightPrompt = true;
+    PromptGenerator generator;
+    generator.setOptions(promptOptions);
+
+    CommandStats stats;
+    PromptContext context;
+    context.currentDirectory = dir;
+    context.homeDirectory = getenv("HOME") ? getenv("HOME") : "";
+    context.columns = 120;
+    context.commandNumber = 1;
+    context.lastCommand = &stats;
+
+    // 稳态：两次回车之间什么都没变
+    results.push_back(measure(scenario, "prompt (warm)", options.iterations, [&] {
+        generator.generate(context);
+    }));
+
+    // 冷启动：清空段落缓存与 Git 缓存，包含 git status 子进程
+    results.push_back(measure(scenario, "prompt (cold)", std::max(options.iterations / 10, 5), [&] {
+        GitIntegration::clearCache();
+        generator.invalidate();
+        generator.generate(context);
+    }));
+
+    results.push_back(measure(scenario, "git branch", options.iterations, [] {
+        GitIntegration::getBranch(true);
+    }));
+
+    results.push_back(measure(scenario, "git repo state", options.iterations, [] {
+        GitIntegration::getRepoState(true);
+    }));
+
+    results.push_back(measure(scenario, "git status", std::max(options.iterations / 10, 5), [] {
+        GitIntegration::getStatus(true);
+    }));
+    return true;
+}
+
+void usage(const char* argv0) {
+    std::printf("Usage: %s [options]\n"
+                "  --iterations N    每项测量的迭代次数（默认 200）\n"
+                "  --files N         large 场景的文件数（默认 100000）\n"
+                "  --max-p99-ms X    p99 阈值，超过时退出码为 1（默认 100）\n"
+                "  --scenario NAME   只运行 clean / dirty / large / detached 之一\n"
+                "  --keep            保留生成的临时仓库\n",
+                argv0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--iterations") options.iterations = std::max(1, std::atoi(next()));
+        else if (arg == "--files") options.files = std::max(1, std::atoi(next()));
+        else if (arg == "--max-p99-ms") options.maxP99Ms = std::atof(next());
+        else if (arg == "--scenario") options.only = next();
+        else if (arg == "--keep") options.keep = true;
+        else {
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    if (std::system("git --version >/dev/null 2>&1") != 0) {
+        std::fprintf(stderr, "prompt_benchmark: git not found\n");
+        return 2;
+    }
+
+    char pattern[] = "/tmp/leizi_bench_XXXXXX";
+    const char* root = mkdtemp(pattern);
+    if (!root) {
+        std::perror("mkdtemp");
+        return 2;
+    }
+    const std::string rootDir = root;
+
+    std::vector<Result> results;
+    std::vector<std::string> skipped;  // 准备失败的场景：跳过但要报告，不能当作通过
+    for (const char* scenario : {"clean", "dirty", "large", "detached"}) {
+        if (!options.only.empty() && options.only != scenario) continue;
+
+        std::string dir = rootDir + "/" + scenario;
+        std::fprintf(stderr, "setting up %s...\n", scenario);
+        if (!setupScenario(scenario, dir, options) || !benchScenario(scenario, dir, options, results)) {
+            std::fprintf(stderr, "prompt_benchmark: failed to set up %s\n", scenario);
+            skipped.push_back(scenario);
+        }
+    }
+
+    if (chdir("/") != 0) {
+        // 忽略：只影响清理
+    }
+    if (!options.keep) {
+        run("/", "rm -rf '" + rootDir + "'");
+    } else {
+        std::fprintf(stderr, "repositories kept in %s\n", rootDir.c_str());
+    }
+
+    bool failed = false;
+    std::printf("%-10s %-16s %12s %12s %12s\n", "scenario", "measure", "p50 (us)", "p99 (us)", "allocs/call");
+    for (const auto& r : results) {
+        bool over = r.p99Us > options.maxP99Ms * 1000.0;
+        failed = failed || over;
+        std::printf("%-10s %-16s %12.1f %12.1f %12.1f%s\n", r.scenario.c_str(), r.measure.c_str(),
+                    r.p50Us, r.p99Us, r.allocsPerCall, over ? "  FAIL" : "");
+    }
+
+    for (const auto& scenario : skipped) {
+        std::printf("%-10s %-16s %12s %12s %12s  SKIPPED\n", scenario.c_str(), "setup failed", "-", "-", "-");
+    }
+
+    if (results.empty() || !skipped.empty()) {
+        if (!skipped.empty()) {
+            std::printf("\n%zu scenario(s) could not be set up\n", skipped.size());
+        }
+        return 2;
+    }
+    if (failed) {
+        std::printf("\np99 exceeded %.1f ms\n", options.maxP99Ms);
+        return 1;
+    }
+    return 0;
+}
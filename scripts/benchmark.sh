@@ -48,27 +48,21 @@ else
 fi
 
 # Benchmark 2: Prompt generation time
+# 直接调用 PromptGenerator / GitIntegration，而不是测量整个进程的启动与退出
 echo -e "\n${YELLOW}[2/4] Measuring prompt generation time...${NC}"
-PROMPT_TIMES=()
-for i in {1..10}; do
-    START=$(date +%s%N)
-    # Simulate prompt generation by running version command
-    echo "version" | timeout 2 "$LEIZI_BIN" > /dev/null 2>&1 || true
-    END=$(date +%s%N)
-    ELAPSED=$(( (END - START) / 1000000 ))
-    PROMPT_TIMES+=($ELAPSED)
-done
-
-TOTAL=0
-for time in "${PROMPT_TIMES[@]}"; do
-    TOTAL=$((TOTAL + time))
-done
-AVG_PROMPT=$((TOTAL / ${#PROMPT_TIMES[@]}))
-
-if [ $AVG_PROMPT -lt 100 ]; then
-    echo -e "${GREEN}✓ Prompt generation: ${AVG_PROMPT}ms (target: <100ms)${NC}"
+PROMPT_BENCH="$BUILD_DIR/benchmarks/prompt_benchmark"
+PROMPT_MAX_P99_MS="${PROMPT_MAX_P99_MS:-100}"
+PROMPT_OK=0
+if [ ! -x "$PROMPT_BENCH" ]; then
+    echo -e "${YELLOW}⚠ prompt_benchmark not built; configure with -DBUILD_BENCHMARKS=ON${NC}"
+    PROMPT_SUMMARY="skipped"
+elif "$PROMPT_BENCH" --max-p99-ms "$PROMPT_MAX_P99_MS" ${PROMPT_BENCH_ARGS:-}; then
+    echo -e "${GREEN}✓ Prompt generation p99 within ${PROMPT_MAX_P99_MS}ms${NC}"
+    PROMPT_SUMMARY="p99 < ${PROMPT_MAX_P99_MS}ms"
 else
-    echo -e "${RED}✗ Prompt generation: ${AVG_PROMPT}ms (target: <100ms)${NC}"
+    echo -e "${RED}✗ Prompt generation p99 exceeded ${PROMPT_MAX_P99_MS}ms${NC}"
+    PROMPT_SUMMARY="p99 >= ${PROMPT_MAX_P99_MS}ms"
+    PROMPT_OK=1
 fi
 
 # Benchmark 3: Command execution overhead
@@ -108,11 +102,11 @@ fi
 # Summary
 echo -e "\n${YELLOW}=== Benchmark Summary ===${NC}"
 echo "Startup time:     ${AVG_STARTUP}ms"
-echo "Prompt gen:       ${AVG_PROMPT}ms"
+echo "Prompt gen:       ${PROMPT_SUMMARY}"
 echo "Command exec:     ${AVG_EXEC}ms"
 
 # Overall assessment
-if [ $AVG_STARTUP -lt 50 ] && [ $AVG_PROMPT -lt 100 ]; then
+if [ $AVG_STARTUP -lt 50 ] && [ $PROMPT_OK -eq 0 ]; then
     echo -e "\n${GREEN}✓ All performance targets met!${NC}"
     exit 0
 else
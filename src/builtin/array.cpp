@@ -4,6 +4,15 @@
 
 /**
  * @brief array 命令实现
+ *
+ *     array name=(v1 v2)     创建数组
+ *     array name+=(v3 v4)    追加元素（已有的标量变量成为第一个元素）
+ *     array name[i]=value    替换第 i 个元素（从 1 开始，负数从末尾数起，超出末尾时补空元素）
+ *     array name[i]+=value   在第 i 个元素末尾追加文本
+ *     array map[key]=value   name 是关联数组（typeset -A）时按键赋值
+ *     array name             显示数组
+ *
+ * 数组使用分块存储：追加与单个元素的赋值只复制所在的块。
  */
 class ArrayCommand : public BuiltinCommand {
 public:
@@ -19,58 +28,143 @@ public:
         BuiltinResult result;
 
         if (args.size() < 2) {
-            std::cout << "Usage: array name=(val1 val2 ...) or array name" << std::endl;
+            std::cout << "Usage: array name=(val1 val2 ...), name+=(...), name[i]=value or array name" << std::endl;
             result.exitCode = 1;
             context.lastExitCode = result.exitCode;
             return result;
         }
 
-        std::string assignment = args[1];
-        size_t eq = assignment.find('=');
+        for (size_t i = 1; i < args.size() && result.exitCode == 0; ++i) {
+            result.exitCode = args[i].find('=') != std::string::npos ? assign(args[i], context) : show(args[i], context);
+        }
 
-        if (eq != std::string::npos) {
-            // 创建数组
-            std::string name = assignment.substr(0, eq);
-            std::string values = assignment.substr(eq + 1);
+        context.lastExitCode = result.exitCode;
+        return result;
+    }
 
-            if (values.front() == '(' && values.back() == ')') {
-                values = values.substr(1, values.length() - 2);
-                std::vector<std::string> arrayValues = context.parser.parseCommand(values);
+private:
+    // 数组字面量中的单词：单独的 ${arr[@]} 展开为多个元素
+    static void appendValues(const std::string& literal, StringArray& array, BuiltinContext& context) {
+        std::vector<std::string> words;
+        for (const auto& word : context.parser.parseCommand(literal)) {
+            if (!context.variables.expandArray(word, words)) {
+                words.push_back(context.expandVariables(word));
+            }
+        }
+        for (auto& word : words) {
+            array.push_back(std::move(word));
+        }
+    }
 
-                for (auto& val : arrayValues) {
-                    val = context.expandVariables(val);
-                }
+    static int assign(const std::string& assignment, BuiltinContext& context) {
+        const size_t eq = assignment.find('=');
+        const bool append = eq > 0 && assignment[eq - 1] == '+';
+        std::string name = assignment.substr(0, append ? eq - 1 : eq);
+        std::string value = assignment.substr(eq + 1);
 
-                context.variables.setArray(name, arrayValues);
-                result.exitCode = 0;
+        std::string subscript;
+        if (const size_t open = name.find('['); open != std::string::npos && name.back() == ']') {
+            subscript = name.substr(open + 1, name.size() - open - 2);
+            name.resize(open);
+        }
+        if (name.empty()) {
+            std::cout << "Error: Array syntax should be name=(val1 val2 ...)" << std::endl;
+            return 1;
+        }
+
+        Variable* existing = context.variables.get(name);
+        if (existing && existing->isReadonly) {
+            std::cerr << "leizi: array: " << name << ": readonly variable" << std::endl;
+            return 1;
+        }
+
+        if (!subscript.empty()) {
+            return assignElement(name, subscript, context.expandVariables(value), append, existing, context);
+        }
+
+        if (value.size() < 2 || value.front() != '(' || value.back() != ')') {
+            std::cout << "Error: Array syntax should be name=(val1 val2 ...)" << std::endl;
+            return 1;
+        }
+        const std::string literal = value.substr(1, value.size() - 2);
 
-                std::cout << "Array " << Color::CYAN << name << Color::RESET
-                          << " created with " << Color::YELLOW << arrayValues.size()
-                          << Color::RESET << " elements" << std::endl;
-            } else {
-                std::cout << "Error: Array syntax should be name=(val1 val2 ...)" << std::endl;
-                result.exitCode = 1;
+        if (append && existing) {
+            if (existing->type() != VarType::ARRAY) {
+                *existing = Variable(std::vector<std::string>{existing->toString()});
             }
-        } else {
-            // 显示数组内容
-            if (const auto* var = context.variables.get(args[1]); var && var->type == VarType::ARRAY) {
-                std::cout << Color::CYAN << args[1] << Color::RESET << "=(";
-                for (size_t i = 0; i < var->arrayValue.size(); ++i) {
-                    if (i > 0) std::cout << " ";
-                    std::cout << "\"" << Color::GREEN << var->arrayValue[i]
-                              << Color::RESET << "\"";
-                }
-                std::cout << ")" << std::endl;
-                result.exitCode = 0;
-            } else {
-                std::cout << "Array " << Color::RED << args[1]
-                          << Color::RESET << " not found" << std::endl;
-                result.exitCode = 1;
+            appendValues(literal, existing->arrayValue(), context);
+            return 0;
+        }
+
+        StringArray array;
+        appendValues(literal, array, context);
+        const size_t size = array.size();
+        context.variables.set(name, Variable(std::move(array)));
+        if (!append) {
+            std::cout << "Array " << Color::CYAN << name << Color::RESET
+                      << " created with " << Color::YELLOW << size
+                      << Color::RESET << " elements" << std::endl;
+        }
+        return 0;
+    }
+
+    static int assignElement(const std::string& name, const std::string& subscript, std::string value, bool append,
+                             Variable* existing, BuiltinContext& context) {
+        if (existing && existing->type() == VarType::ASSOC) {
+            StringMap& map = existing->mapValue();
+            std::string key = context.expandVariables(subscript);
+            if (const std::string* current = append ? map.find(key) : nullptr) {
+                value = *current + value;
             }
+            map.set(std::move(key), std::move(value));
+            return 0;
         }
 
-        context.lastExitCode = result.exitCode;
-        return result;
+        std::int64_t index = 0;
+        try {
+            index = std::stoll(context.expandVariables(subscript));
+        } catch (const std::exception&) {
+            index = 0;
+        }
+
+        if (!existing) {
+            existing = &context.variables.set(name, Variable(StringArray()));
+        } else if (existing->type() != VarType::ARRAY) {
+            *existing = Variable(std::vector<std::string>{existing->toString()});
+        }
+        StringArray& array = existing->arrayValue();
+
+        const auto size = static_cast<std::int64_t>(array.size());
+        const std::int64_t position = index > 0 ? index - 1 : size + index;
+        if (index == 0 || position < 0) {
+            std::cerr << "leizi: array: " << name << "[" << subscript << "]: bad array subscript" << std::endl;
+            return 1;
+        }
+        if (position >= size) {
+            array.resize(static_cast<size_t>(position) + 1);
+        }
+        const auto slot = static_cast<size_t>(position);
+        array.set(slot, append ? array[slot] + value : std::move(value));
+        return 0;
+    }
+
+    static int show(const std::string& name, BuiltinContext& context) {
+        const auto* var = context.variables.get(name);
+        if (!var || var->type() != VarType::ARRAY) {
+            std::cout << "Array " << Color::RED << name
+                      << Color::RESET << " not found" << std::endl;
+            return 1;
+        }
+
+        std::cout << Color::CYAN << name << Color::RESET << "=(";
+        size_t i = 0;
+        for (const auto& element : var->arrayValue()) {
+            if (i++ > 0) std::cout << " ";
+            std::cout << "\"" << Color::GREEN << element
+                      << Color::RESET << "\"";
+        }
+        std::cout << ")" << std::endl;
+        return 0;
     }
 };
 
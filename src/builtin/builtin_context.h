@@ -7,6 +7,12 @@
 #include "../utils/variables.h"
 #include "../core/parser.h"
 
+class ArithmeticEngine;
+
+namespace leizi {
+class HistoryStore;
+}
+
 /**
  * @brief 内建命令执行上下文
  *
@@ -16,12 +22,14 @@ struct BuiltinContext {
     // Shell 状态
     VariableManager& variables;
     CommandParser& parser;
-    std::vector<std::string>& commandHistory;
+    const std::vector<std::string>& commandHistory;  // 去重后的命令列表，空字符串为已移走的位置
     std::string& currentDirectory;
     const std::string& homeDirectory;
     int& lastExitCode;
     bool& exitRequested;
     const std::string& historyFile;
+    leizi::HistoryStore* historyStore = nullptr;  // 带元数据的历史记录，可能为空
+    ArithmeticEngine* arithmetic = nullptr;       // 带表达式缓存的算术求值器，可能为空
 
     // 辅助函数
     std::function<std::string(const std::string&)> expandVariables;
@@ -29,7 +37,7 @@ struct BuiltinContext {
     BuiltinContext(
         VariableManager& vars,
         CommandParser& p,
-        std::vector<std::string>& hist,
+        const std::vector<std::string>& hist,
         std::string& currDir,
         const std::string& homeDir,
         int& exitCode,
@@ -15,6 +15,10 @@ extern "C" {
     BuiltinCommand* createHelpCommand();
     BuiltinCommand* createVersionCommand();
     BuiltinCommand* createHighlightCommand();
+    BuiltinCommand* createLetCommand();
+    BuiltinCommand* createMapfileCommand();
+    BuiltinCommand* createReadarrayCommand();
+    BuiltinCommand* createTypesetCommand();
 }
 
 BuiltinManager::BuiltinManager() {
@@ -31,6 +35,10 @@ BuiltinManager::BuiltinManager() {
     registerCommand(createHelpCommand());
     registerCommand(createVersionCommand());
     registerCommand(createHighlightCommand());
+    registerCommand(createLetCommand());
+    registerCommand(createMapfileCommand());
+    registerCommand(createReadarrayCommand());
+    registerCommand(createTypesetCommand());
 }
 
 void BuiltinManager::registerCommand(BuiltinCommand* command) {
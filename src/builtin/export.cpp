@@ -2,6 +2,7 @@
 #include "../utils/colors.h"
 #include <iostream>
 #include <cstdlib>
+#include <cstdint>
 
 /**
  * @brief export 命令实现
@@ -61,21 +62,77 @@ public:
     }
 
     std::string getHelp() const override {
-        return "unset var             Unset variable";
+        return "unset var|var[sub]    Unset variable, array element or map key";
     }
 
     BuiltinResult execute(const std::vector<std::string>& args, BuiltinContext& context) override {
         BuiltinResult result;
+        result.exitCode = 0;
 
         for (size_t i = 1; i < args.size(); ++i) {
-            context.variables.erase(args[i]);
-            unsetenv(args[i].c_str());
+            const int code = unset(args[i], context);
+            if (code != 0) result.exitCode = code;
         }
 
-        result.exitCode = 0;
         context.lastExitCode = result.exitCode;
         return result;
     }
+
+private:
+    static int unset(const std::string& arg, BuiltinContext& context) {
+        std::string name = arg;
+        std::string subscript;
+        const size_t open = arg.find('[');
+        const bool element = open != std::string::npos && arg.back() == ']';
+        if (element) {
+            subscript = arg.substr(open + 1, arg.size() - open - 2);
+            name.resize(open);
+        }
+
+        Variable* existing = context.variables.get(name);
+        if (existing && existing->isReadonly) {
+            std::cerr << "leizi: unset: " << name << ": readonly variable" << std::endl;
+            return 1;
+        }
+        if (!element) {
+            context.variables.erase(name);
+            unsetenv(name.c_str());
+            return 0;
+        }
+        if (!existing) {
+            return 0;
+        }
+
+        // unset map[key] 只删除关联数组中的一个键
+        if (existing->type() == VarType::ASSOC) {
+            existing->mapValue().erase(context.expandVariables(subscript));
+            return 0;
+        }
+        if (existing->type() != VarType::ARRAY) {
+            std::cerr << "leizi: unset: " << name << ": not an array" << std::endl;
+            return 1;
+        }
+
+        // unset arr[n] 删除数组中的一个元素，后面的元素前移；下标从 1 开始，负数从末尾数
+        std::int64_t index = 0;
+        try {
+            index = std::stoll(context.expandVariables(subscript));
+        } catch (const std::exception&) {
+            index = 0;
+        }
+        std::vector<std::string> values = existing->arrayValue().toVector();
+        const auto size = static_cast<std::int64_t>(values.size());
+        const std::int64_t position = index > 0 ? index - 1 : size + index;
+        if (index == 0 || position < 0) {
+            std::cerr << "leizi: unset: " << arg << ": bad array subscript" << std::endl;
+            return 1;
+        }
+        if (position < size) {
+            values.erase(values.begin() + position);
+            existing->arrayValue() = StringArray(std::move(values));
+        }
+        return 0;
+    }
 };
 
 // 全局实例
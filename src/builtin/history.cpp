@@ -1,10 +1,29 @@
 #include "builtin.h"
 #include "../utils/colors.h"
+#include "../history/history_store.h"
+#include "../history/history_archive.h"
+#include <algorithm>
+#include <deque>
 #include <iostream>
 #include <iomanip>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
 
 /**
  * @brief history 命令实现
+ *
+ * history [-v] [--failed] [--here | --dir PATH] [-s TEXT] [--since DATE] [--archive] [n]
+ *   -v        显示开始时间、耗时与退出码
+ *   --failed  只显示退出码非零的命令
+ *   --here    只显示在当前目录执行的命令
+ *   --dir     只显示在指定目录执行的命令
+ *   -s        只显示包含 TEXT 的命令
+ *   --since   只显示某天（YYYY-MM-DD）或 N 天（Nd）以来的命令
+ *   --archive 同时查询归档的旧记录：按时间顺序边解压边输出，
+ *             给出 n 时只输出最后 n 条
+ *
+ * 记录从最新的一条向前读取，编号是倒数位置（-1 为最新），不需要索引整个历史文件。
  */
 class HistoryCommand : public BuiltinCommand {
 public:
@@ -13,33 +32,212 @@ public:
     }
 
     std::string getHelp() const override {
-        return "history [n]           Show command history";
+        return "history [-v] [--failed] [--here|--dir D] [-s TEXT] [--since DATE] [--archive] [n]  Show command history";
     }
 
     BuiltinResult execute(const std::vector<std::string>& args, BuiltinContext& context) override {
         BuiltinResult result;
 
         size_t count = 20; // 默认显示最近20条
-        if (args.size() > 1) {
-            try {
-                count = std::stoul(args[1]);
-            } catch (...) {
-                count = 20;
+        bool countGiven = false;
+        bool verbose = false;
+        bool archive = false;
+        std::string directory;
+        std::string contains;
+        leizi::HistoryArchive::Filter filter;
+
+        for (size_t i = 1; i < args.size(); ++i) {
+            const std::string& arg = args[i];
+            if (arg == "-v" || arg == "--verbose") {
+                verbose = true;
+            } else if (arg == "--failed") {
+                filter.failedOnly = true;
+            } else if (arg == "--here") {
+                directory = context.currentDirectory;
+            } else if (arg == "--dir" && i + 1 < args.size()) {
+                directory = context.expandVariables(args[++i]);
+            } else if ((arg == "-s" || arg == "--search") && i + 1 < args.size()) {
+                contains = args[++i];
+            } else if (arg == "--since" && i + 1 < args.size()) {
+                if (!parseSince(args[++i], filter.since)) {
+                    return usageError(context, "invalid date: " + args[i]);
+                }
+            } else if (arg == "--archive") {
+                archive = true;
+            } else {
+                try {
+                    count = std::stoul(arg);
+                    countGiven = true;
+                } catch (...) {
+                    return usageError(context, "invalid option: " + arg);
+                }
             }
         }
+        filter.cwd = directory;
+        filter.contains = contains;
 
-        size_t start = context.commandHistory.size() > count ?
-                      context.commandHistory.size() - count : 0;
+        if (context.historyStore && archive) {
+            printArchived(context, *context.historyStore, filter, countGiven ? count : 0, verbose);
+        } else if (context.historyStore) {
+            printRecords(*context.historyStore, count, verbose, filter);
+        } else {
+            // 没有历史记录存储时只能列出命令文本；去重留下的空位不占编号
+            const auto& history = context.commandHistory;
+            size_t number = static_cast<size_t>(std::count_if(history.begin(), history.end(),
+                                                              [](const std::string& entry) { return !entry.empty(); }));
+            size_t start = history.size();
+            size_t shown = 0;
+            for (; start > 0 && shown < count; --start) {
+                if (!history[start - 1].empty()) ++shown;
+            }
 
-        for (size_t i = start; i < context.commandHistory.size(); ++i) {
-            std::cout << Color::DIM << std::setw(4) << (i + 1)
-                      << Color::RESET << " " << context.commandHistory[i] << std::endl;
+            number -= shown;
+            for (size_t i = start; i < history.size(); ++i) {
+                if (history[i].empty()) continue;
+                std::cout << Color::DIM << std::setw(4) << ++number
+                          << Color::RESET << " " << history[i] << std::endl;
+            }
         }
 
         result.exitCode = 0;
         context.lastExitCode = result.exitCode;
         return result;
     }
+
+private:
+    static BuiltinResult usageError(BuiltinContext& context, const std::string& message) {
+        std::cerr << "leizi: history: " << message << std::endl;
+        BuiltinResult result;
+        result.exitCode = 2;
+        context.lastExitCode = result.exitCode;
+        return result;
+    }
+
+    // YYYY-MM-DD（本地时间零点）或 Nd（N 天前）
+    static bool parseSince(const std::string& text, std::int64_t& since) {
+        if (text.size() > 1 && text.back() == 'd' &&
+            text.find_first_not_of("0123456789") == text.size() - 1) {
+            since = static_cast<std::int64_t>(std::time(nullptr)) - std::stoll(text) * 24 * 60 * 60;
+            return true;
+        }
+        std::tm tm {};
+        const char* end = strptime(text.c_str(), "%Y-%m-%d", &tm);
+        if (!end || *end != '\0') {
+            return false;
+        }
+        tm.tm_isdst = -1;
+        since = static_cast<std::int64_t>(std::mktime(&tm));
+        return true;
+    }
+
+    // 用 recent() 从最新的记录向前筛选，凑满 count 条即停，不索引整个文件；
+    // 返回匹配记录的倒数位置（0 为最新），按从新到旧排列
+    static std::vector<size_t> recentMatches(const leizi::HistoryStore& store, size_t count,
+                                             const leizi::HistoryArchive::Filter& filter) {
+        std::vector<size_t> matches;
+        leizi::HistoryRecordView record;
+        for (size_t n = 0; matches.size() < count && store.recent(n, record); ++n) {
+            if (filter.matches(record)) {
+                matches.push_back(n);
+            }
+        }
+        return matches;
+    }
+
+    // 按时间顺序输出，编号为倒数位置（-1 为最新的一条）
+    static void printMatches(const leizi::HistoryStore& store, const std::vector<size_t>& matches, bool verbose) {
+        leizi::HistoryRecordView record;
+        for (auto it = matches.rbegin(); it != matches.rend(); ++it) {
+            store.recent(*it, record);
+            printRecord(record, *it + 1, verbose);
+        }
+    }
+
+    static void printRecords(const leizi::HistoryStore& store, size_t count, bool verbose,
+                             const leizi::HistoryArchive::Filter& filter) {
+        printMatches(store, recentMatches(store, count, filter), verbose);
+    }
+
+    // 归档的旧记录在前、历史文件中的记录在后。不限条数时边解压边输出；
+    // 限制条数时历史文件中的匹配不足 count 条才查询归档，只保留归档的最后几条
+    static void printArchived(const BuiltinContext& context, const leizi::HistoryStore& store,
+                              const leizi::HistoryArchive::Filter& filter, size_t count, bool verbose) {
+        const std::vector<size_t> matches = recentMatches(store, count == 0 ? SIZE_MAX : count, filter);
+        const size_t wanted = count == 0 ? 0 : count - matches.size();
+
+        if (count == 0 || wanted > 0) {
+            leizi::HistoryArchive::ScanStats stats;
+            std::deque<leizi::HistoryRecord> last;
+            leizi::HistoryArchive archive(leizi::HistoryArchive::pathFor(context.historyFile));
+            archive.scan(filter, [&](const leizi::HistoryRecordView& record) {
+                if (count == 0) {
+                    printRecord(record, 0, verbose);
+                    return true;
+                }
+                last.push_back(record.toRecord());
+                if (last.size() > wanted) last.pop_front();
+                return true;
+            }, &stats);
+
+            for (const auto& record : last) {
+                printRecord(leizi::HistoryRecordView(record), 0, verbose);
+            }
+            if (verbose) {
+                std::cerr << Color::DIM << "archive: " << stats.segments << " segments, "
+                          << stats.skipped << " skipped";
+                if (stats.unreadable > 0) {
+                    std::cerr << ", " << stats.unreadable << " unreadable";
+                }
+                std::cerr << Color::RESET << std::endl;
+            }
+        }
+        printMatches(store, matches, verbose);
+    }
+
+    // back 为倒数第几条，0 表示没有编号（归档中的记录）
+    static void printRecord(const leizi::HistoryRecordView& record, size_t back, bool verbose) {
+        std::cout << Color::DIM << std::setw(6);
+        if (back > 0) {
+            std::cout << "-" + std::to_string(back);
+        } else {
+            std::cout << "-";
+        }
+        std::cout << Color::RESET << " ";
+        if (verbose) {
+            printMetadata(record);
+        }
+        std::cout << record.command << std::endl;
+    }
+
+    static void printMetadata(const leizi::HistoryRecordView& record) {
+        char timeStr[32] = "-";
+        if (record.startTime > 0) {
+            std::time_t start = static_cast<std::time_t>(record.startTime);
+            std::tm tm {};
+            localtime_r(&start, &tm);
+            std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &tm);
+        }
+
+        std::cout << Color::DIM << std::setw(19) << timeStr << " "
+                  << std::setw(8) << formatDuration(record.durationMs) << Color::RESET << " ";
+        if (record.exitCode != 0) {
+            std::cout << Color::RED << std::setw(4) << record.exitCode << Color::RESET << " ";
+        } else {
+            std::cout << std::setw(4) << 0 << " ";
+        }
+    }
+
+    static std::string formatDuration(std::uint32_t ms) {
+        char buf[32];
+        if (ms < 1000) {
+            std::snprintf(buf, sizeof(buf), "%ums", ms);
+        } else if (ms < 60 * 1000) {
+            std::snprintf(buf, sizeof(buf), "%.1fs", ms / 1000.0);
+        } else {
+            std::snprintf(buf, sizeof(buf), "%um%02us", ms / 60000, (ms / 1000) % 60);
+        }
+        return buf;
+    }
 };
 
 // 全局实例
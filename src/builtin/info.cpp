@@ -46,6 +46,8 @@ public:
         std::cout << "  " << Color::GREEN << "export var=value" << Color::RESET << "     Export environment variable\n";
         std::cout << "  " << Color::GREEN << "unset var" << Color::RESET << "            Unset variable\n";
         std::cout << "  " << Color::GREEN << "array name=(v1 v2)" << Color::RESET << "   Create/display ZSH-style array\n";
+        std::cout << "  " << Color::GREEN << "mapfile [-t] name" << Color::RESET << "    Read stdin lines into array\n";
+        std::cout << "  " << Color::GREEN << "typeset -A map=(k v)" << Color::RESET << " Declare associative array\n";
         std::cout << "  " << Color::GREEN << "history [n]" << Color::RESET << "          Show command history\n";
         std::cout << "  " << Color::GREEN << "jobs" << Color::RESET << "                 List background jobs\n";
         std::cout << "  " << Color::GREEN << "fg [job]" << Color::RESET << "             Bring job to foreground\n";
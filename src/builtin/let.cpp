@@ -0,0 +1,58 @@
+#include "builtin.h"
+#include "../utils/arithmetic.h"
+#include <iostream>
+
+/**
+ * @brief let 命令实现
+ *
+ * 依次求值每个参数中的算术表达式；最后一个表达式的值不为 0 时返回 0。
+ * ((expr)) 由 shell 转换为 let 的同一逻辑执行。
+ */
+class LetCommand : public BuiltinCommand {
+public:
+    std::string getName() const override {
+        return "let";
+    }
+
+    std::string getHelp() const override {
+        return "let expr...           Evaluate arithmetic expressions";
+    }
+
+    BuiltinResult execute(const std::vector<std::string>& args, BuiltinContext& context) override {
+        BuiltinResult result;
+
+        if (args.size() < 2) {
+            std::cerr << "leizi: let: expression expected" << std::endl;
+            result.exitCode = 2;
+            context.lastExitCode = result.exitCode;
+            return result;
+        }
+
+        ArithmeticEngine fallback;
+        ArithmeticEngine& engine = context.arithmetic ? *context.arithmetic : fallback;
+
+        std::int64_t value = 0;
+        for (size_t i = 1; i < args.size(); ++i) {
+            const std::string expression = context.expandVariables(args[i]);
+            std::string error;
+            if (!engine.evaluate(expression, context.variables, value, error)) {
+                std::cerr << "leizi: let: " << expression << ": " << error << std::endl;
+                result.exitCode = 1;
+                context.lastExitCode = result.exitCode;
+                return result;
+            }
+        }
+
+        result.exitCode = value != 0 ? 0 : 1;
+        context.lastExitCode = result.exitCode;
+        return result;
+    }
+};
+
+// 全局实例
+static LetCommand letCommand;
+
+// 工厂函数
+extern "C" BuiltinCommand* createLetCommand() {
+    return &letCommand;
+}
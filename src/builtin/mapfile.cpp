@@ -0,0 +1,133 @@
+#include "builtin.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+/**
+ * @brief mapfile / readarray 命令实现
+ *
+ *     mapfile [-t] [-n count] [-s count] [-d delim] [name]
+ *
+ * 从标准输入逐行读入数组（默认 MAPFILE）：-t 去掉行尾的分隔符，-n 最多读入 count 行，
+ * -s 跳过开头的 count 行，-d 以 delim 的第一个字符代替换行作为分隔符。
+ * 输入按 64 KiB 的块读取，每行直接追加到分块存储的数组中，不经过中间的行列表。
+ */
+class MapfileCommand : public BuiltinCommand {
+public:
+    explicit MapfileCommand(std::string name) : name_(std::move(name)) {}
+
+    std::string getName() const override {
+        return name_;
+    }
+
+    std::string getHelp() const override {
+        return name_ + " [-t] [name] < file    Read lines into an array";
+    }
+
+    BuiltinResult execute(const std::vector<std::string>& args, BuiltinContext& context) override {
+        BuiltinResult result;
+        result.exitCode = run(args, context);
+        context.lastExitCode = result.exitCode;
+        return result;
+    }
+
+private:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    std::string name_;
+
+    int run(const std::vector<std::string>& args, BuiltinContext& context) const {
+        bool strip = false;
+        char delimiter = '\n';
+        size_t limit = 0;  // 0 表示不限
+        size_t skip = 0;
+        std::string arrayName = "MAPFILE";
+
+        for (size_t i = 1; i < args.size(); ++i) {
+            const std::string& arg = args[i];
+            auto count = [&](size_t& value) {
+                if (i + 1 >= args.size()) return false;
+                try {
+                    value = std::stoul(context.expandVariables(args[++i]));
+                } catch (const std::exception&) {
+                    return false;
+                }
+                return true;
+            };
+            if (arg == "-t") {
+                strip = true;
+            } else if (arg == "-d" && i + 1 < args.size()) {
+                const std::string delim = context.expandVariables(args[++i]);
+                delimiter = delim.empty() ? '\0' : delim[0];
+            } else if ((arg == "-n" && count(limit)) || (arg == "-s" && count(skip))) {
+                continue;
+            } else if (!arg.empty() && arg[0] != '-') {
+                arrayName = context.expandVariables(arg);
+            } else {
+                std::cerr << "leizi: " << name_ << ": usage: " << name_
+                          << " [-t] [-n count] [-s count] [-d delim] [name]" << std::endl;
+                return 2;
+            }
+        }
+
+        if (const Variable* existing = context.variables.get(arrayName); existing && existing->isReadonly) {
+            std::cerr << "leizi: " << name_ << ": " << arrayName << ": readonly variable" << std::endl;
+            return 1;
+        }
+
+        StringArray lines;
+        std::string line;
+        size_t seen = 0;
+        auto finish = [&](bool delimited) {
+            if (delimited && !strip) line += delimiter;
+            if (seen++ >= skip) lines.push_back(std::move(line));
+            line.clear();
+            return limit == 0 || lines.size() < limit;
+        };
+
+        char buffer[BUFFER_SIZE];
+        bool more = true;
+        while (more) {
+            const ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "leizi: " << name_ << ": read error: " << std::strerror(errno) << std::endl;
+                return 1;
+            }
+            if (n == 0) break;
+
+            const char* cursor = buffer;
+            const char* end = buffer + n;
+            while (more && cursor < end) {
+                const auto* found = static_cast<const char*>(std::memchr(cursor, delimiter, end - cursor));
+                if (!found) {
+                    line.append(cursor, end);
+                    break;
+                }
+                line.append(cursor, found);
+                cursor = found + 1;
+                more = finish(true);
+            }
+        }
+        if (more && !line.empty()) {
+            finish(false);
+        }
+
+        context.variables.set(arrayName, Variable(std::move(lines)));
+        return 0;
+    }
+};
+
+// 全局实例
+static MapfileCommand mapfileCommand("mapfile");
+static MapfileCommand readarrayCommand("readarray");
+
+// 工厂函数
+extern "C" BuiltinCommand* createMapfileCommand() {
+    return &mapfileCommand;
+}
+
+extern "C" BuiltinCommand* createReadarrayCommand() {
+    return &readarrayCommand;
+}
@@ -0,0 +1,232 @@
+#include "builtin.h"
+#include <iostream>
+
+/**
+ * @brief typeset 命令实现
+ *
+ *     typeset -A name                     声明关联数组（已有的关联数组保持不变）
+ *     typeset -A name=(k1 v1 k2 v2)       以键值对创建关联数组，也接受 ([k1]=v1 [k2]=v2)
+ *     typeset name[key]=value             设置关联数组中的一个键
+ *     typeset -a name=(v1 v2)             声明数组
+ *     typeset [-r] name=value             设置标量变量，-r 同时设为只读
+ *     typeset name                        按可重新输入的形式显示变量
+ *
+ * 关联数组保存在保持插入顺序的开放寻址表中，按键查找不需要外部的 awk。
+ */
+class TypesetCommand : public BuiltinCommand {
+public:
+    std::string getName() const override {
+        return "typeset";
+    }
+
+    std::string getHelp() const override {
+        return "typeset -A name=(k v)  Declare associative arrays and variables";
+    }
+
+    BuiltinResult execute(const std::vector<std::string>& args, BuiltinContext& context) override {
+        BuiltinResult result;
+        result.exitCode = run(args, context);
+        context.lastExitCode = result.exitCode;
+        return result;
+    }
+
+private:
+    struct Options {
+        bool assoc = false;
+        bool array = false;
+        bool readonly = false;
+    };
+
+    static int run(const std::vector<std::string>& args, BuiltinContext& context) {
+        Options options;
+        size_t i = 1;
+        for (; i < args.size() && args[i].size() > 1 && args[i][0] == '-'; ++i) {
+            for (size_t k = 1; k < args[i].size(); ++k) {
+                switch (args[i][k]) {
+                    case 'A': options.assoc = true; break;
+                    case 'a': options.array = true; break;
+                    case 'r': options.readonly = true; break;
+                    default:
+                        std::cerr << "leizi: typeset: -" << args[i][k] << ": invalid option" << std::endl;
+                        std::cerr << "typeset: usage: typeset [-Aar] [name[=value] ...]" << std::endl;
+                        return 2;
+                }
+            }
+        }
+        if (options.assoc && options.array) {
+            std::cerr << "leizi: typeset: -A and -a cannot be combined" << std::endl;
+            return 2;
+        }
+        if (i == args.size()) {
+            std::cerr << "typeset: usage: typeset [-Aar] [name[=value] ...]" << std::endl;
+            return 2;
+        }
+
+        int status = 0;
+        for (; i < args.size(); ++i) {
+            const int code = args[i].find('=') != std::string::npos ? assign(args[i], options, context)
+                                                                    : declare(args[i], options, context);
+            if (code != 0) status = code;
+        }
+        return status;
+    }
+
+    // 数组字面量中的单词：单独的 ${arr[@]} 与 ${(kv)map} 展开为多个单词
+    static std::vector<std::string> literalWords(const std::string& value, BuiltinContext& context) {
+        std::vector<std::string> words;
+        const std::string literal = value.substr(1, value.size() - 2);
+        for (const auto& word : context.parser.parseCommand(literal)) {
+            if (!context.variables.expandArray(word, words)) {
+                words.push_back(context.expandVariables(word));
+            }
+        }
+        return words;
+    }
+
+    // ([k1]=v1 [k2]=v2) 或 (k1 v1 k2 v2) 形式的键值对
+    static bool parsePairs(const std::string& value, BuiltinContext& context, StringMap& map) {
+        const std::string literal = value.substr(1, value.size() - 2);
+        const auto tokens = context.parser.parseCommand(literal);
+        if (!tokens.empty() && tokens.front().front() == '[') {
+            for (const auto& token : tokens) {
+                const size_t close = token.find("]=");
+                if (token.front() != '[' || close == std::string::npos) return false;
+                map.set(context.expandVariables(token.substr(1, close - 1)),
+                        context.expandVariables(token.substr(close + 2)));
+            }
+            return true;
+        }
+
+        std::vector<std::string> words = literalWords(value, context);
+        if (words.size() % 2 != 0) return false;
+        for (size_t k = 0; k < words.size(); k += 2) {
+            map.set(std::move(words[k]), std::move(words[k + 1]));
+        }
+        return true;
+    }
+
+    static bool isLiteral(const std::string& value) {
+        return value.size() >= 2 && value.front() == '(' && value.back() == ')';
+    }
+
+    static int assign(const std::string& assignment, const Options& options, BuiltinContext& context) {
+        const size_t eq = assignment.find('=');
+        std::string name = assignment.substr(0, eq);
+        const std::string value = assignment.substr(eq + 1);
+
+        std::string key;
+        bool keyed = false;
+        if (const size_t open = name.find('['); open != std::string::npos && name.back() == ']') {
+            key = context.expandVariables(name.substr(open + 1, name.size() - open - 2));
+            name.resize(open);
+            keyed = true;
+        }
+        if (name.empty()) {
+            std::cerr << "leizi: typeset: `" << assignment << "': not a valid identifier" << std::endl;
+            return 1;
+        }
+
+        Variable* existing = context.variables.get(name);
+        if (existing && existing->isReadonly) {
+            std::cerr << "leizi: typeset: " << name << ": readonly variable" << std::endl;
+            return 1;
+        }
+
+        if (keyed) {
+            if (!existing && options.assoc) {
+                existing = &context.variables.set(name, Variable(StringMap()));
+            }
+            if (!existing || existing->type() != VarType::ASSOC) {
+                std::cerr << "leizi: typeset: " << name << ": not an associative array" << std::endl;
+                return 1;
+            }
+            existing->mapValue().set(std::move(key), context.expandVariables(value));
+            if (options.readonly) existing->isReadonly = true;
+            return 0;
+        }
+
+        const bool assoc = options.assoc || (existing && existing->type() == VarType::ASSOC && isLiteral(value));
+        if (assoc) {
+            StringMap map;
+            if (!isLiteral(value) || !parsePairs(value, context, map)) {
+                std::cerr << "leizi: typeset: " << name << ": bad set of key/value pairs" << std::endl;
+                return 1;
+            }
+            context.variables.set(name, Variable(std::move(map), options.readonly));
+        } else if (options.array || isLiteral(value)) {
+            if (!isLiteral(value)) {
+                std::cerr << "leizi: typeset: " << name << ": array syntax should be name=(v1 v2 ...)" << std::endl;
+                return 1;
+            }
+            context.variables.set(name, Variable(literalWords(value, context), options.readonly));
+        } else {
+            context.variables.setString(name, context.expandVariables(value), options.readonly);
+        }
+        return 0;
+    }
+
+    static int declare(const std::string& name, const Options& options, BuiltinContext& context) {
+        Variable* existing = context.variables.get(name);
+        if (options.assoc || options.array) {
+            const VarType type = options.assoc ? VarType::ASSOC : VarType::ARRAY;
+            if (existing && existing->isReadonly && existing->type() != type) {
+                std::cerr << "leizi: typeset: " << name << ": readonly variable" << std::endl;
+                return 1;
+            }
+            if (!existing || existing->type() != type) {
+                existing = &context.variables.set(name, options.assoc ? Variable(StringMap()) : Variable(StringArray()));
+            }
+        } else if (!existing) {
+            return 1;
+        }
+
+        if (options.readonly) {
+            existing->isReadonly = true;
+        } else if (!options.assoc && !options.array) {
+            show(name, *existing);
+        }
+        return 0;
+    }
+
+    // 值用单引号括起，其中的单引号写作 '\''
+    static std::string quote(const std::string& value) {
+        std::string quoted = "'";
+        for (char c : value) {
+            if (c == '\'') quoted += "'\\''";
+            else quoted += c;
+        }
+        return quoted + "'";
+    }
+
+    static void show(const std::string& name, const Variable& variable) {
+        std::cout << "typeset " << (variable.isReadonly ? "-r " : "");
+        switch (variable.type()) {
+            case VarType::ASSOC:
+                std::cout << "-A " << name << "=(";
+                for (const auto& entry : variable.mapValue()) {
+                    std::cout << " [" << quote(entry.key) << "]=" << quote(entry.value);
+                }
+                std::cout << " )";
+                break;
+            case VarType::ARRAY:
+                std::cout << "-a " << name << "=(";
+                for (const auto& element : variable.arrayValue()) {
+                    std::cout << " " << quote(element);
+                }
+                std::cout << " )";
+                break;
+            default:
+                std::cout << name << "=" << quote(variable.toString());
+                break;
+        }
+        std::cout << std::endl;
+    }
+};
+
+// 全局实例
+static TypesetCommand typesetCommand;
+
+// 工厂函数
+extern "C" BuiltinCommand* createTypesetCommand() {
+    return &typesetCommand;
+}
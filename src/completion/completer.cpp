@@ -8,6 +8,8 @@
 #include <unistd.h>
 #include <sstream>
 #include <pwd.h>
+#include <string_view>
+#include <unordered_set>
 
 // 全局environ声明 (必须在namespace外)
 extern char** environ;
@@ -188,19 +190,20 @@ std::vector<std::string> HistoryCompleter::getCompletions(const CompletionContex
     }
 
     std::vector<std::string> completions;
+    std::unordered_set<std::string_view> seen;
     const std::string& prefix = ctx.currentToken;
 
-    // 从历史记录中查找匹配的命令
+    // 从历史记录中查找匹配的命令，同一命令名只返回一次（空字符串是去重留下的空位）
     for (auto it = commandHistory.rbegin(); it != commandHistory.rend(); ++it) {
         const std::string& cmd = *it;
         if (cmd.empty()) continue;
 
         // 提取第一个token (命令名)
-        size_t space = cmd.find(' ');
-        std::string cmdName = (space != std::string::npos) ? cmd.substr(0, space) : cmd;
+        std::string_view cmdName(cmd);
+        cmdName = cmdName.substr(0, cmdName.find(' '));
 
-        if (prefix.empty() || cmdName.find(prefix) == 0) {
-            completions.push_back(cmdName);
+        if ((prefix.empty() || cmdName.compare(0, prefix.size(), prefix) == 0) && seen.insert(cmdName).second) {
+            completions.emplace_back(cmdName);
         }
     }
 
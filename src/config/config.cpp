@@ -58,15 +58,23 @@ void ConfigManager::setDefaults() {
     config_["prompt"]["show_user"] = ConfigValue::fromBool(true);
     config_["prompt"]["colors"] = ConfigValue::fromBool(true);
     config_["prompt"]["symbol"] = ConfigValue::fromString("❯");
+    config_["prompt"]["multiline"] = ConfigValue::fromBool(true);
+    config_["prompt"]["right_prompt"] = ConfigValue::fromBool(false);
+    config_["prompt"]["transient"] = ConfigValue::fromBool(false);
+    config_["prompt"]["duration_threshold"] = ConfigValue::fromInt(2000);
 
     // [completion] 默认值
     config_["completion"]["case_sensitive"] = ConfigValue::fromBool(false);
     config_["completion"]["show_hidden"] = ConfigValue::fromBool(false);
+    config_["completion"]["autosuggest"] = ConfigValue::fromBool(true);
+    config_["completion"]["highlight"] = ConfigValue::fromBool(true);
 
     // [history] 默认值
     config_["history"]["size"] = ConfigValue::fromInt(10000);
     config_["history"]["ignore_duplicates"] = ConfigValue::fromBool(true);
     config_["history"]["ignore_space"] = ConfigValue::fromBool(true);
+    config_["history"]["share"] = ConfigValue::fromBool(false);
+    config_["history"]["archive"] = ConfigValue::fromBool(false);
 }
 
 bool ConfigManager::loadConfig(const std::string& configPath) {
@@ -227,16 +235,24 @@ bool ConfigManager::generateDefaultConfig(const std::string& configPath) {
     file << "show_time = true\n";
     file << "show_user = true\n";
     file << "colors = true\n";
-    file << "symbol = \"❯\"\n\n";
+    file << "symbol = \"❯\"\n";
+    file << "multiline = true\n";
+    file << "right_prompt = false\n";
+    file << "transient = false\n";
+    file << "duration_threshold = 2000\n\n";
 
     file << "[completion]\n";
     file << "case_sensitive = false\n";
-    file << "show_hidden = false\n\n";
+    file << "show_hidden = false\n";
+    file << "autosuggest = true\n";
+    file << "highlight = true\n\n";
 
     file << "[history]\n";
     file << "size = 10000\n";
     file << "ignore_duplicates = true\n";
-    file << "ignore_space = true\n\n";
+    file << "ignore_space = true\n";
+    file << "share = false\n";
+    file << "archive = false\n\n";
 
     file << "[aliases]\n";
     file << "ll = \"ls -la\"\n";
@@ -0,0 +1,248 @@
+#include "core/brace.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <limits>
+
+#include "utils/variables.h"
+
+namespace {
+
+constexpr std::uint64_t SATURATED = std::numeric_limits<std::uint64_t>::max();
+
+std::uint64_t saturatingMultiply(std::uint64_t a, std::uint64_t b) {
+    if (a != 0 && b > SATURATED / a) return SATURATED;
+    return a * b;
+}
+
+std::uint64_t saturatingAdd(std::uint64_t a, std::uint64_t b) {
+    return a > SATURATED - b ? SATURATED : a + b;
+}
+
+// 可选符号加十进制数字
+bool parseInteger(std::string_view text, std::int64_t& value) {
+    size_t i = text.size() > 1 && (text[0] == '-' || text[0] == '+') ? 1 : 0;
+    if (i == text.size() || text.size() - i > 18) return false;
+    std::int64_t result = 0;
+    for (size_t j = i; j < text.size(); ++j) {
+        if (!std::isdigit(static_cast<unsigned char>(text[j]))) return false;
+        result = result * 10 + (text[j] - '0');
+    }
+    value = text[0] == '-' ? -result : result;
+    return true;
+}
+
+// 有前导 0 的端点（0 本身除外）要求补 0
+bool zeroPadded(std::string_view text) {
+    if (!text.empty() && (text[0] == '-' || text[0] == '+')) text.remove_prefix(1);
+    return text.size() > 1 && text[0] == '0';
+}
+
+} // namespace
+
+BraceExpansion::BraceExpansion(std::string_view word) {
+    size_t pos = 0;
+    parseSequence(word, pos, false, root_, expands_);
+}
+
+bool BraceExpansion::parseRange(std::string_view body, Node& node) {
+    const size_t dots = body.find("..");
+    if (dots == std::string_view::npos) return false;
+    const std::string_view from = body.substr(0, dots);
+    std::string_view to = body.substr(dots + 2);
+    std::string_view increment;
+    if (const size_t more = to.find(".."); more != std::string_view::npos) {
+        increment = to.substr(more + 2);
+        to = to.substr(0, more);
+    }
+
+    std::int64_t step = 1;
+    if (!increment.empty() && !parseInteger(increment, step)) return false;
+    const std::uint64_t magnitude = step < 0 ? 0 - static_cast<std::uint64_t>(step) : static_cast<std::uint64_t>(step);
+
+    std::int64_t start = 0, end = 0;
+    if (parseInteger(from, start) && parseInteger(to, end)) {
+        if (zeroPadded(from) || zeroPadded(to)) {
+            node.width = static_cast<int>(std::max(from.size(), to.size()));
+        }
+    } else if (from.size() == 1 && to.size() == 1 && !std::isdigit(static_cast<unsigned char>(from[0])) &&
+               !std::isdigit(static_cast<unsigned char>(to[0]))) {
+        start = static_cast<unsigned char>(from[0]);
+        end = static_cast<unsigned char>(to[0]);
+        node.letters = true;
+    } else {
+        return false;
+    }
+
+    // 方向由端点决定，步长只取绝对值
+    const std::uint64_t stride = magnitude == 0 ? 1 : magnitude;
+    const std::uint64_t distance = start <= end ? static_cast<std::uint64_t>(end) - static_cast<std::uint64_t>(start)
+                                                : static_cast<std::uint64_t>(start) - static_cast<std::uint64_t>(end);
+    node.kind = Node::Kind::Range;
+    node.first = start;
+    node.step = static_cast<std::int64_t>(stride) * (start <= end ? 1 : -1);
+    node.length = distance / stride + 1;
+    return true;
+}
+
+bool BraceExpansion::parseSequence(std::string_view word, size_t& pos, bool nested, Sequence& sequence,
+                                   bool& expands) {
+    std::string literal;
+    int literalBraces = 0;  // 未能展开、按原样保留的 '{' 的层数，与之配对的 '}' 也是字面量
+
+    auto flush = [&]() {
+        if (!literal.empty()) {
+            Node node;
+            node.text = std::move(literal);
+            sequence.push_back(std::move(node));
+            literal.clear();
+        }
+    };
+
+    while (pos < word.size()) {
+        const char c = word[pos];
+        if (nested && literalBraces == 0 && (c == ',' || c == '}')) {
+            flush();
+            return true;
+        }
+
+        if (c == '\\' && pos + 1 < word.size()) {
+            literal.append(word, pos, 2);
+            pos += 2;
+        } else if (c == '$' && pos + 1 < word.size() && word[pos + 1] == '{') {
+            // ${...} 是参数展开
+            const size_t close = word.find('}', pos);
+            const size_t end = close == std::string_view::npos ? word.size() : close + 1;
+            literal.append(word, pos, end - pos);
+            pos = end;
+        } else if ((c == '$' && pos + 1 < word.size() && word[pos + 1] == '(') || c == '`') {
+            const size_t close = substitutionEnd(std::string(word), pos);
+            const size_t end = close == std::string::npos ? word.size() : close + 1;
+            literal.append(word, pos, end - pos);
+            pos = end;
+        } else if (c == '{') {
+            Node node;
+            const size_t close = word.find('}', pos);
+            if (close != std::string_view::npos && parseRange(word.substr(pos + 1, close - pos - 1), node)) {
+                flush();
+                sequence.push_back(std::move(node));
+                expands = true;
+                pos = close + 1;
+                continue;
+            }
+
+            // 列表至少要有一个逗号
+            size_t scan = pos + 1;
+            bool innerExpands = false;
+            node.kind = Node::Kind::List;
+            for (;;) {
+                Sequence alternative;
+                if (!parseSequence(word, scan, true, alternative, innerExpands)) break;
+                node.alternatives.push_back(std::move(alternative));
+                if (word[scan] == '}') break;
+                ++scan;  // ','
+            }
+            if (node.alternatives.size() >= 2 && scan < word.size() && word[scan] == '}') {
+                flush();
+                sequence.push_back(std::move(node));
+                expands = true;
+                pos = scan + 1;
+            } else {
+                literal += c;
+                ++literalBraces;
+                ++pos;
+            }
+        } else {
+            if (c == '}' && literalBraces > 0) --literalBraces;
+            literal += c;
+            ++pos;
+        }
+    }
+
+    flush();
+    // 嵌套的部分在单词结束前没有遇到 '}'
+    return !nested;
+}
+
+void BraceExpansion::render(const Sequence& sequence, std::string& word) {
+    for (const Node& node : sequence) {
+        switch (node.kind) {
+            case Node::Kind::Literal:
+                word += node.text;
+                break;
+            case Node::Kind::List:
+                render(node.alternatives[node.index], word);
+                break;
+            case Node::Kind::Range: {
+                const std::int64_t value = static_cast<std::int64_t>(
+                    static_cast<std::uint64_t>(node.first) + node.index * static_cast<std::uint64_t>(node.step));
+                if (node.letters) {
+                    word += static_cast<char>(value);
+                } else {
+                    char buffer[32];
+                    std::snprintf(buffer, sizeof(buffer), "%0*lld", node.width, static_cast<long long>(value));
+                    word += buffer;
+                }
+                break;
+            }
+        }
+    }
+}
+
+bool BraceExpansion::advance(Sequence& sequence) {
+    for (size_t i = sequence.size(); i-- > 0;) {
+        Node& node = sequence[i];
+        if (node.kind == Node::Kind::Range) {
+            if (++node.index < node.length) return true;
+            node.index = 0;
+        } else if (node.kind == Node::Kind::List) {
+            if (advance(node.alternatives[node.index])) return true;
+            if (++node.index < node.alternatives.size()) return true;
+            node.index = 0;
+        }
+    }
+    return false;
+}
+
+void BraceExpansion::reset(Sequence& sequence) {
+    for (Node& node : sequence) {
+        node.index = 0;
+        for (Sequence& alternative : node.alternatives) {
+            reset(alternative);
+        }
+    }
+}
+
+std::uint64_t BraceExpansion::count(const Sequence& sequence) {
+    std::uint64_t total = 1;
+    for (const Node& node : sequence) {
+        if (node.kind == Node::Kind::Range) {
+            total = saturatingMultiply(total, node.length);
+        } else if (node.kind == Node::Kind::List) {
+            std::uint64_t sum = 0;
+            for (const Sequence& alternative : node.alternatives) {
+                sum = saturatingAdd(sum, count(alternative));
+            }
+            total = saturatingMultiply(total, sum);
+        }
+    }
+    return total;
+}
+
+bool BraceExpansion::next(std::string& word) {
+    if (done_) return false;
+    word.clear();
+    render(root_, word);
+    done_ = !advance(root_);
+    return true;
+}
+
+void BraceExpansion::reset() {
+    reset(root_);
+    done_ = false;
+}
+
+std::uint64_t BraceExpansion::count() const {
+    return count(root_);
+}
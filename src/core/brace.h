@@ -0,0 +1,73 @@
+#ifndef LEIZI_CORE_BRACE_H
+#define LEIZI_CORE_BRACE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 一个单词的大括号展开
+ *
+ *     pre{a,b,c}post      列表（可以嵌套：{a,b{1,2}}）
+ *     {1..10} {10..1..3}  整数序列，端点有前导 0 时按最宽的端点补 0
+ *     {a..e} {z..a..2}    字符序列
+ *
+ * 构造时只解析一次，得到由字面量、列表与序列组成的树；next() 像里程表一样
+ * 推进最右侧的部分，每次只生成一个单词，{1..100000000} 也不会一次分配全部结果。
+ * 顺序与 bash 相同：左边的部分变化最慢。${...}、$(...) 与 `...` 中的大括号不展开。
+ */
+class BraceExpansion {
+public:
+    explicit BraceExpansion(std::string_view word);
+
+    /**
+     * @brief 单词中是否有可展开的大括号
+     */
+    bool expands() const { return expands_; }
+
+    /**
+     * @brief 生成下一个单词，全部生成后返回 false
+     */
+    bool next(std::string& word);
+
+    /**
+     * @brief 回到第一个单词
+     */
+    void reset();
+
+    /**
+     * @brief 展开后的单词数（超过 UINT64_MAX 时饱和）
+     */
+    std::uint64_t count() const;
+
+private:
+    struct Node;
+    using Sequence = std::vector<Node>;
+
+    struct Node {
+        enum class Kind { Literal, List, Range };
+        Kind kind = Kind::Literal;
+        std::string text;                   // Literal
+        std::vector<Sequence> alternatives; // List
+        std::int64_t first = 0;             // Range：起点、步长（带方向）与个数
+        std::int64_t step = 1;
+        std::uint64_t length = 0;
+        int width = 0;                      // Range：补 0 后的宽度
+        bool letters = false;               // Range：字符序列
+        std::uint64_t index = 0;            // 当前的选项或序列位置
+    };
+
+    Sequence root_;
+    bool expands_ = false;
+    bool done_ = false;
+
+    static bool parseSequence(std::string_view word, size_t& pos, bool nested, Sequence& sequence, bool& expands);
+    static bool parseRange(std::string_view body, Node& node);
+    static void render(const Sequence& sequence, std::string& word);
+    static bool advance(Sequence& sequence);
+    static void reset(Sequence& sequence);
+    static std::uint64_t count(const Sequence& sequence);
+};
+
+#endif // LEIZI_CORE_BRACE_H
@@ -0,0 +1,69 @@
+#include "core/capture.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <ostream>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+
+// FIONREAD 没有给出提示（或还没有数据）时的读取大小
+constexpr size_t MIN_READ = 4096;
+// 单次扩容上限，避免提示异常时一次分配过多
+constexpr size_t MAX_READ = 1 << 20;
+
+} // namespace
+
+StringOutputBuffer::int_type StringOutputBuffer::overflow(int_type c) {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        target_.push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize StringOutputBuffer::xsputn(const char* data, std::streamsize count) {
+    target_.append(data, static_cast<size_t>(count));
+    return count;
+}
+
+ScopedOutputCapture::ScopedOutputCapture(std::ostream& stream, std::string& target)
+    : stream_(stream), buffer_(target) {
+    stream_.flush();
+    previous_ = stream_.rdbuf(&buffer_);
+}
+
+ScopedOutputCapture::~ScopedOutputCapture() {
+    stream_.rdbuf(previous_);
+}
+
+bool readToEnd(int fd, std::string& buffer) {
+    while (true) {
+        int ready = 0;
+        size_t chunk = MIN_READ;
+        if (ioctl(fd, FIONREAD, &ready) == 0 && ready > 0) {
+            chunk = std::clamp(static_cast<size_t>(ready), MIN_READ, MAX_READ);
+        }
+
+        const size_t used = buffer.size();
+        if (buffer.capacity() < used + chunk) {
+            buffer.reserve(std::max(used + chunk, buffer.capacity() * 2));
+        }
+        buffer.resize(used + chunk);
+        ssize_t n = read(fd, buffer.data() + used, chunk);
+        buffer.resize(used + static_cast<size_t>(std::max<ssize_t>(n, 0)));
+
+        if (n == 0) {
+            return true;
+        }
+        if (n < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+void trimTrailingNewlines(std::string& text) {
+    size_t end = text.size();
+    while (end > 0 && text[end - 1] == '\n') --end;
+    text.resize(end);
+}
@@ -0,0 +1,57 @@
+#ifndef LEIZI_CORE_CAPTURE_H
+#define LEIZI_CORE_CAPTURE_H
+
+#include <iosfwd>
+#include <streambuf>
+#include <string>
+
+/**
+ * @brief 把写入的内容直接追加到字符串的流缓冲区
+ *
+ * 命令替换在进程内执行内建命令时替换 std::cout 的缓冲区，
+ * 输出不经过管道也不需要再复制一次。
+ */
+class StringOutputBuffer : public std::streambuf {
+public:
+    explicit StringOutputBuffer(std::string& target) : target_(target) {}
+
+protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+
+private:
+    std::string& target_;
+};
+
+/**
+ * @brief 在作用域内把流的输出捕获到字符串中，析构时恢复
+ */
+class ScopedOutputCapture {
+public:
+    ScopedOutputCapture(std::ostream& stream, std::string& target);
+    ~ScopedOutputCapture();
+
+    ScopedOutputCapture(const ScopedOutputCapture&) = delete;
+    ScopedOutputCapture& operator=(const ScopedOutputCapture&) = delete;
+
+private:
+    std::ostream& stream_;
+    StringOutputBuffer buffer_;
+    std::streambuf* previous_;
+};
+
+/**
+ * @brief 读取描述符直到 EOF，追加到 buffer
+ *
+ * 每次读取前用 FIONREAD 查询已就绪的字节数来决定扩容大小，
+ * 直接读入字符串尾部，不经过中间缓冲区。
+ * @return 读取出错时返回 false（已读到的内容保留）
+ */
+bool readToEnd(int fd, std::string& buffer);
+
+/**
+ * @brief 原地去掉末尾的换行符（命令替换的语义）
+ */
+void trimTrailingNewlines(std::string& text);
+
+#endif // LEIZI_CORE_CAPTURE_H
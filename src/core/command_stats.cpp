@@ -0,0 +1,68 @@
+#include "core/command_stats.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+namespace {
+std::chrono::microseconds toMicroseconds(const struct timeval& tv) {
+    return std::chrono::seconds(tv.tv_sec) + std::chrono::microseconds(tv.tv_usec);
+}
+} // namespace
+
+void CommandStats::accumulate(const struct rusage& usage) {
+    userTime += toMicroseconds(usage.ru_utime);
+    systemTime += toMicroseconds(usage.ru_stime);
+
+    // Linux 以 KB 为单位，macOS 以字节为单位
+#ifdef __APPLE__
+    long rssKb = usage.ru_maxrss / 1024;
+#else
+    long rssKb = usage.ru_maxrss;
+#endif
+    maxRssKb = std::max(maxRssKb, rssKb);
+    ++processes;
+}
+
+void CommandStats::merge(const CommandStats& other) {
+    userTime += other.userTime;
+    systemTime += other.systemTime;
+    maxRssKb = std::max(maxRssKb, other.maxRssKb);
+    processes += other.processes;
+}
+
+void CommandTimer::start() {
+    stats_ = CommandStats{};
+    stages_.clear();
+    startTime_ = std::chrono::steady_clock::now();
+}
+
+const CommandStats& CommandTimer::stop() {
+    stats_.wallTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime_);
+    return stats_;
+}
+
+pid_t CommandTimer::waitStage(size_t index, pid_t pid, int* status) {
+    if (stages_.size() <= index) stages_.resize(index + 1);
+    CommandStats& stage = stages_[index];
+    const pid_t result = waitWithUsage(pid, status, 0, &stage);
+    stage.wallTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime_);
+    stats_.merge(stage);
+    return result;
+}
+
+pid_t waitWithUsage(pid_t pid, int* status, int options, CommandStats* stats) {
+    struct rusage usage {};
+    pid_t result;
+    do {
+        result = wait4(pid, status, options, &usage);
+    } while (result < 0 && errno == EINTR);
+
+    if (result > 0 && stats && (WIFEXITED(*status) || WIFSIGNALED(*status))) {
+        stats->accumulate(usage);
+    }
+    return result;
+}
@@ -0,0 +1,87 @@
+#ifndef LEIZI_CORE_COMMAND_STATS_H
+#define LEIZI_CORE_COMMAND_STATS_H
+
+#include <chrono>
+#include <sys/types.h>
+#include <vector>
+
+struct rusage;
+
+/**
+ * @brief 单条命令（或整条管道）的耗时与资源占用
+ */
+struct CommandStats {
+    std::chrono::nanoseconds wallTime {0};       // 墙钟时间
+    std::chrono::microseconds userTime {0};      // 用户态 CPU 时间（所有子进程之和）
+    std::chrono::microseconds systemTime {0};    // 内核态 CPU 时间（所有子进程之和）
+    long maxRssKb = 0;                           // 子进程中最大的常驻内存（KB）
+    int processes = 0;                           // 已回收的子进程数
+
+    /**
+     * @brief 累加一个子进程的 rusage：CPU 时间求和，RSS 取最大值
+     */
+    void accumulate(const struct rusage& usage);
+
+    /**
+     * @brief 合并另一组统计（例如管道中的一段）：CPU 时间与进程数求和，RSS 取最大值，墙钟时间不变
+     */
+    void merge(const CommandStats& other);
+
+    std::chrono::microseconds cpuTime() const { return userTime + systemTime; }
+};
+
+/**
+ * @brief 计时器，记录一次命令执行的起止并汇总子进程资源占用
+ *
+ * 管道的每一段由 waitStage() 回收，各段的统计单独保存在 stages() 中，同时汇总到整条管道的 stats()。
+ */
+class CommandTimer {
+public:
+    /**
+     * @brief 开始计时，清空上一次的统计
+     */
+    void start();
+
+    /**
+     * @brief 结束计时，返回本次统计结果
+     */
+    const CommandStats& stop();
+
+    /**
+     * @brief 当前（或上一次）的统计结果
+     */
+    CommandStats& stats() { return stats_; }
+    const CommandStats& stats() const { return stats_; }
+
+    /**
+     * @brief 等待管道中的第 index 段结束（语义同 waitpid(pid, status, 0)）
+     *
+     * 该段的墙钟时间为从 start() 到回收时，rusage 记入该段并累加到 stats()
+     * @return wait4 的返回值
+     */
+    pid_t waitStage(size_t index, pid_t pid, int* status);
+
+    /**
+     * @brief 管道各段的统计，按在管道中的位置；单条命令没有分段时为空
+     */
+    const std::vector<CommandStats>& stages() const { return stages_; }
+
+private:
+    std::chrono::steady_clock::time_point startTime_ {};
+    CommandStats stats_;
+    std::vector<CommandStats> stages_;
+};
+
+/**
+ * @brief 使用 wait4 等待子进程，并把其 rusage 累加到 stats
+ *
+ * 语义与 waitpid 相同；仅当子进程终止时才累加资源占用（停止时 rusage 不完整）
+ * @param pid 子进程 PID
+ * @param status 输出等待状态
+ * @param options waitpid 选项（WNOHANG、WUNTRACED 等）
+ * @param stats 累加目标，可为 nullptr
+ * @return wait4 的返回值
+ */
+pid_t waitWithUsage(pid_t pid, int* status, int options, CommandStats* stats);
+
+#endif // LEIZI_CORE_COMMAND_STATS_H
@@ -0,0 +1,377 @@
+#include "core/glob.h"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+// 递归遍历的最大线程数
+constexpr unsigned MAX_THREADS = 8;
+
+// 一次 getdents64 读取的缓冲区大小
+constexpr size_t DIRENT_BUFFER_SIZE = 32 * 1024;
+
+// [:name:] 字符类
+bool addNamedClass(std::string_view name, std::bitset<256>& set) {
+    int (*predicate)(int) = nullptr;
+    if (name == "alpha") predicate = isalpha;
+    else if (name == "digit") predicate = isdigit;
+    else if (name == "alnum") predicate = isalnum;
+    else if (name == "upper") predicate = isupper;
+    else if (name == "lower") predicate = islower;
+    else if (name == "space") predicate = isspace;
+    else if (name == "blank") predicate = isblank;
+    else if (name == "punct") predicate = ispunct;
+    else if (name == "xdigit") predicate = isxdigit;
+    else if (name == "cntrl") predicate = iscntrl;
+    else if (name == "print") predicate = isprint;
+    else if (name == "graph") predicate = isgraph;
+    else return false;
+
+    for (int c = 0; c < 128; ++c) {
+        if (predicate(c)) set.set(static_cast<size_t>(c));
+    }
+    return true;
+}
+
+// 对目录中的每一项调用 visit(name, d_type)；name 以 NUL 结尾
+template <typename Visit>
+void forEachEntry(int fd, Visit&& visit) {
+#ifdef __linux__
+    alignas(struct dirent64) char buffer[DIRENT_BUFFER_SIZE];
+    for (;;) {
+        const long count = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (count <= 0) break;
+        for (long offset = 0; offset < count;) {
+            const auto* entry = reinterpret_cast<const struct dirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            visit(entry->d_name, entry->d_type);
+        }
+    }
+#else
+    const int copy = dup(fd);
+    DIR* dir = copy >= 0 ? fdopendir(copy) : nullptr;
+    if (!dir) {
+        if (copy >= 0) close(copy);
+        return;
+    }
+    while (const struct dirent* entry = readdir(dir)) {
+        visit(entry->d_name, entry->d_type);
+    }
+    closedir(dir);
+#endif
+}
+
+} // namespace
+
+// ==================== GlobMatcher ====================
+
+GlobMatcher::GlobMatcher(std::string_view pattern) {
+    auto appendLiteral = [&](char c) {
+        if (elements_.empty() || elements_.back().kind != Element::Kind::Literal) {
+            elements_.emplace_back();
+        }
+        elements_.back().text += c;
+        text_ += c;
+    };
+
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        const char c = pattern[i];
+        if (c == '\\' && i + 1 < pattern.size()) {
+            appendLiteral(pattern[++i]);
+        } else if (c == '*') {
+            literal_ = false;
+            if (elements_.empty() || elements_.back().kind != Element::Kind::Star) {
+                Element star;
+                star.kind = Element::Kind::Star;
+                elements_.push_back(std::move(star));
+            }
+        } else if (c == '?') {
+            literal_ = false;
+            Element any;
+            any.kind = Element::Kind::Any;
+            elements_.push_back(std::move(any));
+        } else if (c == '[') {
+            // 字符类；没有闭合的 ']' 时 '[' 是普通字符
+            Element cls;
+            cls.kind = Element::Kind::Class;
+            size_t j = i + 1;
+            bool negate = false;
+            if (j < pattern.size() && (pattern[j] == '!' || pattern[j] == '^')) {
+                negate = true;
+                ++j;
+            }
+            bool closed = false;
+            for (bool first = true; j < pattern.size(); first = false) {
+                if (pattern[j] == ']' && !first) {
+                    closed = true;
+                    break;
+                }
+                if (pattern.compare(j, 2, "[:") == 0) {
+                    const size_t end = pattern.find(":]", j + 2);
+                    if (end != std::string_view::npos && addNamedClass(pattern.substr(j + 2, end - j - 2), cls.set)) {
+                        j = end + 2;
+                        continue;
+                    }
+                }
+                unsigned char low = static_cast<unsigned char>(pattern[j]);
+                if (low == '\\' && j + 1 < pattern.size()) low = static_cast<unsigned char>(pattern[++j]);
+                if (j + 2 < pattern.size() && pattern[j + 1] == '-' && pattern[j + 2] != ']') {
+                    const auto high = static_cast<unsigned char>(pattern[j + 2]);
+                    for (unsigned c2 = low; c2 <= high; ++c2) cls.set.set(c2);
+                    j += 3;
+                } else {
+                    cls.set.set(low);
+                    ++j;
+                }
+            }
+            if (!closed) {
+                appendLiteral(c);
+                continue;
+            }
+            if (negate) cls.set.flip();
+            literal_ = false;
+            elements_.push_back(std::move(cls));
+            i = j;
+        } else {
+            appendLiteral(c);
+        }
+    }
+
+    for (const auto& element : elements_) {
+        if (element.kind == Element::Kind::Literal) minLength_ += element.text.size();
+        else if (element.kind != Element::Kind::Star) ++minLength_;
+    }
+    if (!elements_.empty() && elements_.front().kind == Element::Kind::Literal) {
+        prefix_ = elements_.front().text;
+    }
+    if (!elements_.empty() && elements_.back().kind == Element::Kind::Literal) {
+        suffix_ = elements_.back().text;
+    }
+}
+
+bool GlobMatcher::matches(std::string_view name) const {
+    if (name.size() < minLength_) return false;
+    if (name.compare(0, prefix_.size(), prefix_) != 0) return false;
+    if (name.compare(name.size() - suffix_.size(), suffix_.size(), suffix_) != 0) return false;
+
+    // 每个非 * 元素长度固定，只需在最近的 * 处回溯
+    size_t e = 0, n = 0;
+    size_t starElement = std::string::npos, starName = 0;
+    while (n < name.size()) {
+        if (e < elements_.size()) {
+            const Element& element = elements_[e];
+            switch (element.kind) {
+                case Element::Kind::Star:
+                    starElement = e++;
+                    starName = n;
+                    continue;
+                case Element::Kind::Literal:
+                    if (name.compare(n, element.text.size(), element.text) == 0) {
+                        n += element.text.size();
+                        ++e;
+                        continue;
+                    }
+                    break;
+                case Element::Kind::Any:
+                    ++n;
+                    ++e;
+                    continue;
+                case Element::Kind::Class:
+                    if (element.set.test(static_cast<unsigned char>(name[n]))) {
+                        ++n;
+                        ++e;
+                        continue;
+                    }
+                    break;
+            }
+        }
+        if (starElement == std::string::npos) return false;
+        e = starElement + 1;
+        n = ++starName;
+    }
+    while (e < elements_.size() && elements_[e].kind == Element::Kind::Star) ++e;
+    return e == elements_.size();
+}
+
+// ==================== GlobPattern ====================
+
+GlobPattern::GlobPattern(std::string_view pattern) {
+    if (!pattern.empty() && pattern.front() == '/') root_ = "/";
+    directoriesOnly_ = !pattern.empty() && pattern.back() == '/';
+
+    size_t start = 0;
+    while (start < pattern.size()) {
+        size_t end = pattern.find('/', start);
+        if (end == std::string_view::npos) end = pattern.size();
+        const std::string_view segment = pattern.substr(start, end - start);
+        start = end + 1;
+        if (segment.empty()) continue;
+
+        if (segment == "**") {
+            recursive_ = true;
+            // 连续的 ** 与一个等价
+            if (!segments_.empty() && segments_.back().globstar) continue;
+            static const GlobMatcher any("*");
+            segments_.push_back(Segment{true, any});
+        } else {
+            segments_.push_back(Segment{false, GlobMatcher(segment)});
+        }
+    }
+}
+
+bool GlobPattern::hasMagic(std::string_view word) {
+    return word.find_first_of("*?[") != std::string_view::npos;
+}
+
+std::string GlobPattern::unescape(std::string_view pattern) {
+    std::string word;
+    word.reserve(pattern.size());
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] == '\\' && i + 1 < pattern.size() && std::strchr("*?[\\", pattern[i + 1]) != nullptr) {
+            ++i;
+        }
+        word += pattern[i];
+    }
+    return word;
+}
+
+void GlobPattern::process(Task task, std::vector<Task>& pending, std::vector<std::string>& results) const {
+    // 字面量段只拼接路径，留给后面的 open/stat 检查是否存在
+    while (task.segment < segments_.size() && !segments_[task.segment].globstar &&
+           segments_[task.segment].matcher.isLiteral()) {
+        const std::string& name = segments_[task.segment].matcher.literal();
+        if (task.segment + 1 == segments_.size()) {
+            struct stat st;
+            const std::string path = task.path + name;
+            if (directoriesOnly_ ? stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)
+                                 : lstat(path.c_str(), &st) == 0) {
+                results.push_back(directoriesOnly_ ? path + "/" : path);
+            }
+            return;
+        }
+        task.path += name;
+        task.path += '/';
+        ++task.segment;
+    }
+    if (task.segment >= segments_.size()) return;
+
+    const int fd = open(task.path.empty() ? "." : task.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    const bool globstar = segments_[task.segment].globstar;
+    // ** 与其后的一段在同一次读取中处理：匹配后一段的项是结果，子目录继续递归
+    const size_t matchSegment = globstar ? task.segment + 1 : task.segment;
+    const GlobMatcher* matcher = matchSegment < segments_.size() ? &segments_[matchSegment].matcher : nullptr;
+    const bool last = matchSegment + 1 >= segments_.size();
+
+    auto isDirectory = [fd](const char* name, unsigned char type, bool follow) {
+        if (type == DT_DIR) return true;
+        if (type != DT_UNKNOWN && !(follow && type == DT_LNK)) return false;
+        struct stat st;
+        return fstatat(fd, name, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+    };
+
+    forEachEntry(fd, [&](const char* name, unsigned char type) {
+        const std::string_view entry(name);
+        if (entry == "." || entry == "..") return;
+
+        const bool hidden = entry.front() == '.';
+        const bool matched = matcher ? (!hidden || matcher->matchesHidden()) && matcher->matches(entry) : !hidden;
+        if (matched) {
+            if (!last) {
+                if (isDirectory(name, type, true)) {
+                    pending.push_back(Task{task.path + name + "/", matchSegment + 1});
+                }
+            } else if (!directoriesOnly_) {
+                results.push_back(task.path + name);
+            } else if (isDirectory(name, type, true)) {
+                results.push_back(task.path + name + "/");
+            }
+        }
+        if (globstar && !hidden && isDirectory(name, type, false)) {
+            pending.push_back(Task{task.path + name + "/", task.segment});
+        }
+    });
+    close(fd);
+}
+
+std::vector<std::string> GlobPattern::expand(unsigned threads) const {
+    std::vector<std::string> results;
+    if (segments_.empty()) {
+        return results;
+    }
+
+    std::vector<Task> pending {Task{root_, 0}};
+    if (threads == 0) {
+        threads = std::clamp(std::thread::hardware_concurrency(), 1u, MAX_THREADS);
+    }
+
+    if (!recursive_ || threads == 1) {
+        while (!pending.empty()) {
+            Task task = std::move(pending.back());
+            pending.pop_back();
+            process(std::move(task), pending, results);
+        }
+    } else {
+        // 每个目录一个任务；工作线程取出任务，新任务一次性放回共享栈
+        std::mutex mutex;
+        std::condition_variable ready;
+        size_t active = 0;
+        std::vector<std::vector<std::string>> partial(threads);
+
+        auto worker = [&](unsigned id) {
+            std::vector<Task> produced;
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                ready.wait(lock, [&] { return !pending.empty() || active == 0; });
+                if (pending.empty()) {
+                    ready.notify_all();
+                    return;
+                }
+                Task task = std::move(pending.back());
+                pending.pop_back();
+                ++active;
+                lock.unlock();
+
+                process(std::move(task), produced, partial[id]);
+
+                lock.lock();
+                --active;
+                if (!produced.empty() || active == 0) {
+                    std::move(produced.begin(), produced.end(), std::back_inserter(pending));
+                    produced.clear();
+                    ready.notify_all();
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned id = 1; id < threads; ++id) {
+            pool.emplace_back(worker, id);
+        }
+        worker(0);
+        for (auto& thread : pool) {
+            thread.join();
+        }
+
+        for (auto& part : partial) {
+            std::move(part.begin(), part.end(), std::back_inserter(results));
+        }
+    }
+
+    std::sort(results.begin(), results.end());
+    return results;
+}
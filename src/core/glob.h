@@ -0,0 +1,96 @@
+#ifndef LEIZI_CORE_GLOB_H
+#define LEIZI_CORE_GLOB_H
+
+#include <bitset>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 路径中一段（不含 '/'）的匹配器
+ *
+ * 模式编译为字面量、?、* 与字符类 [...] 组成的序列；匹配时只回溯最后一个 *，
+ * 开头与结尾的字面量先行比较，大多数不匹配的名字只需一次 memcmp。
+ */
+class GlobMatcher {
+public:
+    explicit GlobMatcher(std::string_view pattern);
+
+    bool matches(std::string_view name) const;
+
+    // 模式中没有通配符，即只匹配 literal() 本身
+    bool isLiteral() const { return literal_; }
+    const std::string& literal() const { return text_; }
+
+    // 模式以 '.' 开头，可以匹配隐藏文件
+    bool matchesHidden() const { return !prefix_.empty() && prefix_.front() == '.'; }
+
+private:
+    struct Element {
+        enum class Kind { Literal, Any, Star, Class };
+        Kind kind = Kind::Literal;
+        std::string text;           // Literal
+        std::bitset<256> set;       // Class（已处理取反）
+    };
+
+    std::vector<Element> elements_;
+    std::string text_;      // 字面量模式去掉转义后的文件名
+    std::string prefix_;    // 第一个通配符之前的字面量
+    std::string suffix_;    // 最后一个通配符之后的字面量
+    size_t minLength_ = 0;  // 能匹配的最短名字
+    bool literal_ = true;
+};
+
+/**
+ * @brief 编译后的路径名模式
+ *
+ * 模式按 '/' 拆分为段，每段编译一次。字面量段直接拼接路径，不读取目录；
+ * 通配段在一次 getdents64 中匹配目录项，并用 d_type 判断是否为目录，
+ * 只有文件系统不提供类型或遇到符号链接时才 stat。
+ *
+ * "**" 单独成段时匹配零或多层目录（不进入隐藏目录与指向目录的符号链接）。
+ * 递归遍历时每个子目录是一个任务，由线程池并行处理，结果最后统一排序。
+ * 以 '/' 结尾的模式只匹配目录。没有匹配时返回空列表，由调用方保留原词。
+ */
+class GlobPattern {
+public:
+    explicit GlobPattern(std::string_view pattern);
+
+    /**
+     * @brief 是否含有 * ? [ 通配符
+     */
+    static bool hasMagic(std::string_view word);
+
+    /**
+     * @brief 去掉 * ? [ \ 前的转义反斜杠，得到没有匹配时保留的单词
+     */
+    static std::string unescape(std::string_view pattern);
+
+    /**
+     * @brief 展开为按字节序排序的路径列表
+     * @param threads 递归遍历使用的线程数，0 为自动（不含 "**" 时总是单线程）
+     */
+    std::vector<std::string> expand(unsigned threads = 0) const;
+
+    bool recursive() const { return recursive_; }
+
+private:
+    struct Segment {
+        bool globstar = false;
+        GlobMatcher matcher;
+    };
+
+    struct Task {
+        std::string path;   // 已匹配的前缀（以 '/' 结尾或为空）
+        size_t segment;     // 下一个要匹配的段
+    };
+
+    std::string root_;      // 绝对路径为 "/"，否则为空
+    std::vector<Segment> segments_;
+    bool directoriesOnly_ = false;
+    bool recursive_ = false;
+
+    void process(Task task, std::vector<Task>& pending, std::vector<std::string>& results) const;
+};
+
+#endif // LEIZI_CORE_GLOB_H
@@ -1,5 +1,7 @@
 #include "core/job_control.h"
 
+#include "core/command_stats.h"
+
 #include <algorithm>
 #include <iostream>
 #include <signal.h>
@@ -21,7 +23,7 @@ void JobControl::updateJobStatus() {
     for (auto& job : m_jobs) {
         if (job.status == JobStatus::RUNNING || job.status == JobStatus::STOPPED) {
             int status;
-            pid_t result = waitpid(job.pid, &status, WNOHANG | WUNTRACED);
+            pid_t result = waitWithUsage(job.pid, &status, WNOHANG | WUNTRACED, nullptr);
 
             if (result > 0) {
                 if (WIFEXITED(status) || WIFSIGNALED(status)) {
@@ -103,7 +105,7 @@ bool JobControl::foregroundJob(int jobId) {
 
     // 等待作业完成
     int status;
-    waitpid(it->pid, &status, WUNTRACED);
+    waitWithUsage(it->pid, &status, WUNTRACED, nullptr);
 
     if (WIFEXITED(status) || WIFSIGNALED(status)) {
         m_jobs.erase(it);
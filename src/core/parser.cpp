@@ -1,115 +1,305 @@
 #include "core/parser.h"
 
+#include <algorithm>
 #include <cctype>
 #include <string>
 #include <vector>
 
-std::vector<std::string> CommandParser::parseCommand(const std::string& input) const {
+#include "utils/variables.h"
+
+namespace {
+
+// 分词过程中的 here-doc：操作符与定界符在 tokens 中的位置
+struct PendingHereDoc {
+    size_t operatorIndex = 0;
+    size_t wordIndex = 0;
+    bool hasWord = false;
+    bool quoted = false;
+    bool stripTabs = false;
+};
+
+// 读取从 pos 开始的正文直到定界符行，返回正文并把 pos 移到定界符行之后
+std::string readHereDocBody(const std::string& input, size_t& pos, const std::string& delimiter, bool stripTabs) {
+    std::string body;
+    while (pos < input.length()) {
+        size_t end = input.find('\n', pos);
+        if (end == std::string::npos) end = input.length();
+        size_t start = pos;
+        if (stripTabs) {
+            while (start < end && input[start] == '\t') ++start;
+        }
+        pos = end + 1;
+        if (input.compare(start, end - start, delimiter) == 0) {
+            break;
+        }
+        body.append(input, start, end - start);
+        body += '\n';
+    }
+    return body;
+}
+
+// name=、name+= 或 name[i]= 形式的单词，其后的 (...) 是数组字面量
+bool isArrayAssignment(const std::string& word) {
+    if (word.size() < 2 || word.back() != '=') return false;
+    size_t end = word.size() - 1;
+    if (word[end - 1] == '+') --end;
+    if (end > 0 && word[end - 1] == ']') {
+        end = word.rfind('[', end - 1);
+        if (end == std::string::npos) return false;
+    }
+    return end > 0 && !std::isdigit(static_cast<unsigned char>(word[0])) &&
+           std::all_of(word.begin(), word.begin() + static_cast<std::ptrdiff_t>(end),
+                       [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; });
+}
+
+// 数组字面量中与 open 处的 '(' 配对的 ')'，跳过引号与命令替换；没有闭合时返回 npos
+size_t arrayLiteralEnd(const std::string& input, size_t open) {
+    char quote = 0;
+    for (size_t i = open + 1; i < input.size(); ++i) {
+        const char c = input[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+            else if (c == '\\' && quote == '"') ++i;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+        } else if (c == '\\') {
+            ++i;
+        } else if ((c == '$' && i + 1 < input.size() && input[i + 1] == '(') || c == '`') {
+            i = substitutionEnd(input, i);
+            if (i == std::string::npos) return i;
+        } else if (c == ')') {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+} // namespace
+
+std::vector<std::string> CommandParser::parseCommand(const std::string& input,
+                                                     std::vector<unsigned char>* expansions) const {
+    return tokenize(input, nullptr, expansions);
+}
+
+std::vector<HereDocDelimiter> CommandParser::hereDocDelimiters(const std::string& input) const {
+    std::vector<HereDocDelimiter> unterminated;
+    tokenize(input, &unterminated);
+    return unterminated;
+}
+
+std::vector<std::string> CommandParser::tokenize(const std::string& input, std::vector<HereDocDelimiter>* unterminated,
+                                                 std::vector<unsigned char>* expansions) const {
     std::vector<std::string> tokens;
+    std::vector<unsigned char> flags;  // 与 tokens 对应的 WordExpansion
     std::string current;
+    bool quoted = false;  // current 中含有引号内的字符
+    unsigned char expansion = 0;  // current 中未加引号的 * ? [ {
+    std::vector<size_t> quotedMagic;  // current 中加引号的 * ? [ \ 的位置
     bool inSingleQuote = false;
     bool inDoubleQuote = false;
+    std::vector<PendingHereDoc> hereDocs;
+    size_t resolved = 0;  // hereDocs 中已读取正文的个数
+
+    auto flush = [&]() {
+        if (!current.empty()) {
+            // << 之后的第一个单词是定界符
+            if (!hereDocs.empty() && !hereDocs.back().hasWord) {
+                hereDocs.back().hasWord = true;
+                hereDocs.back().wordIndex = tokens.size();
+                hereDocs.back().quoted = quoted;
+            }
+            // 作为路径名模式使用的记号中，加引号的通配符前加反斜杠，只匹配字面量
+            if (expansions && (expansion & WORD_GLOB) && !quotedMagic.empty()) {
+                std::string pattern;
+                pattern.reserve(current.size() + quotedMagic.size());
+                size_t copied = 0;
+                for (size_t position : quotedMagic) {
+                    pattern.append(current, copied, position - copied);
+                    pattern += '\\';
+                    copied = position;
+                }
+                pattern.append(current, copied, std::string::npos);
+                current = std::move(pattern);
+            }
+            tokens.push_back(current);
+            flags.push_back(expansion);
+            current.clear();
+        }
+        quoted = false;
+        expansion = 0;
+        quotedMagic.clear();
+    };
+
+    // 引号内的字符
+    auto appendQuoted = [&](char ch) {
+        if (ch == '*' || ch == '?' || ch == '[' || ch == '\\') quotedMagic.push_back(current.size());
+        current += ch;
+    };
+
+    auto push = [&](std::string token) {
+        tokens.push_back(std::move(token));
+        flags.push_back(0);
+    };
+
+    // 把定界符记号替换为正文，操作符规范为 << 或 <<'
+    auto resolve = [&](PendingHereDoc& doc, std::string body) {
+        std::string& op = tokens[doc.operatorIndex];
+        op = op.substr(0, op.find('<')) + (doc.quoted ? HEREDOC_LITERAL_OPERATOR : HEREDOC_OPERATOR);
+        tokens[doc.wordIndex] = std::move(body);
+        flags[doc.wordIndex] = 0;
+    };
 
     for (size_t i = 0; i < input.length(); ++i) {
         char c = input[i];
+        char next = i + 1 < input.length() ? input[i + 1] : '\0';
 
         if (inSingleQuote) {
             if (c == '\'') {
                 inSingleQuote = false;
             } else {
-                current += c;
+                appendQuoted(c);
             }
+        } else if (c == '(' && next == '(' && current.empty() && (tokens.empty() || tokens.back() == "|")) {
+            // ((expr)) 命令整体作为一个单词，其中的 < 与 << 是运算符而不是重定向
+            size_t end = arithmeticEnd(input, i);
+            if (end == std::string::npos) end = input.length() - 1;
+            current.append(input, i, end - i + 1);
+            i = end;
+        } else if (c == '(' && !inDoubleQuote && !quoted && isArrayAssignment(current)) {
+            // name=(a "b c") 的括号部分原样保留在同一个单词中，由 array 命令再分词
+            size_t end = arrayLiteralEnd(input, i);
+            if (end == std::string::npos) end = input.length() - 1;
+            current.append(input, i, end - i + 1);
+            i = end;
+        } else if ((c == '$' && next == '(') || c == '`') {
+            // 命令替换整体属于当前单词，留到展开时执行
+            size_t end = substitutionEnd(input, i);
+            if (end == std::string::npos) end = input.length() - 1;
+            current.append(input, i, end - i + 1);
+            i = end;
         } else if (inDoubleQuote) {
             if (c == '"') {
                 inDoubleQuote = false;
             } else if (c == '\\' && i + 1 < input.length()) {
-                char next = input[i + 1];
-                current += next;
+                appendQuoted(next);
                 ++i;
             } else {
-                current += c;
+                appendQuoted(c);
             }
         } else {
             if (c == '\'') {
                 inSingleQuote = true;
+                quoted = true;
             } else if (c == '"') {
                 inDoubleQuote = true;
-            } else if (c == '|' || c == '>' || c == '<') {
-                if (!current.empty()) {
-                    tokens.push_back(current);
+                quoted = true;
+            } else if (c == '|') {
+                flush();
+                push("|");
+            } else if (c == '>' || c == '<') {
+                // 紧挨在操作符前、没有引号的纯数字是描述符前缀（2>、3<&）
+                std::string op;
+                if (!current.empty() && !quoted &&
+                    std::all_of(current.begin(), current.end(),
+                                [](char d) { return std::isdigit(static_cast<unsigned char>(d)); })) {
+                    op = current;
                     current.clear();
                 }
-                if (c == '>') {
-                    if (i + 1 < input.length() && input[i + 1] == '>') {
-                        tokens.emplace_back(">>");
-                        ++i;
+                flush();
+                op += c;
+                if (c == '<' && next == '<') {
+                    const char third = i + 2 < input.length() ? input[i + 2] : '\0';
+                    if (third == '<') {
+                        op += "<<";   // here-string
+                        i += 2;
                     } else {
-                        tokens.emplace_back(">");
+                        PendingHereDoc doc;
+                        doc.operatorIndex = tokens.size();
+                        doc.stripTabs = third == '-';
+                        hereDocs.push_back(doc);
+                        op += doc.stripTabs ? "<-" : "<";
+                        i += doc.stripTabs ? 2 : 1;
                     }
-                } else if (c == '|') {
-                    tokens.emplace_back("|");
-                } else {
-                    tokens.emplace_back("<");
+                } else if ((c == '>' && (next == '>' || next == '&' || next == '|')) ||
+                           (c == '<' && (next == '&' || next == '>'))) {
+                    op += next;
+                    ++i;
                 }
+                push(op);
             } else if (c == '&') {
-                if (!current.empty()) {
-                    tokens.push_back(current);
-                    current.clear();
-                }
-                if (i + 1 < input.length() && input[i + 1] == '>') {
-                    tokens.emplace_back("&>");
-                    ++i;
+                flush();
+                if (next == '>') {
+                    if (i + 2 < input.length() && input[i + 2] == '>') {
+                        push("&>>");
+                        i += 2;
+                    } else {
+                        push("&>");
+                        ++i;
+                    }
                 } else {
                     current += c;
                 }
-            } else if (std::isdigit(static_cast<unsigned char>(c)) && i + 1 < input.length() && input[i + 1] == '>') {
-                if (!current.empty()) {
-                    tokens.push_back(current);
-                    current.clear();
-                }
-                if (c == '2' && i + 2 < input.length() && input[i + 2] == '>') {
-                    tokens.emplace_back("2>>");
-                    i += 2;
-                } else {
-                    tokens.emplace_back("2>");
-                    ++i;
+            } else if (c == '\n' && resolved < hereDocs.size()) {
+                // 行尾：依次读取本行 here-doc 的正文
+                flush();
+                size_t pos = i + 1;
+                for (; resolved < hereDocs.size(); ++resolved) {
+                    PendingHereDoc& doc = hereDocs[resolved];
+                    if (!doc.hasWord) continue;
+                    resolve(doc, readHereDocBody(input, pos, tokens[doc.wordIndex], doc.stripTabs));
                 }
+                i = pos - 1;
             } else if (std::isspace(static_cast<unsigned char>(c))) {
-                if (!current.empty()) {
-                    tokens.push_back(current);
-                    current.clear();
-                }
+                flush();
             } else {
+                if (c == '*' || c == '?' || c == '[') expansion |= WORD_GLOB;
+                if (c == '{') expansion |= WORD_BRACE;
                 current += c;
             }
         }
     }
 
-    if (!current.empty()) {
-        tokens.push_back(current);
-    }
+    flush();
 
+    // 输入在正文之前结束：正文为空，由调用方读取后续行
+    for (; resolved < hereDocs.size(); ++resolved) {
+        PendingHereDoc& doc = hereDocs[resolved];
+        if (!doc.hasWord) continue;
+        if (unterminated) {
+            unterminated->push_back(HereDocDelimiter{tokens[doc.wordIndex], doc.stripTabs});
+        }
+        resolve(doc, std::string());
+    }
+    if (expansions) {
+        *expansions = std::move(flags);
+    }
     return tokens;
 }
 
-std::vector<std::vector<std::string>> CommandParser::parsePipeline(const std::string& input) const {
+std::vector<std::vector<std::string>> CommandParser::parsePipeline(
+    const std::string& input, std::vector<std::vector<unsigned char>>* expansions) const {
     std::vector<std::vector<std::string>> commands;
     std::vector<std::string> currentCmd;
-    auto tokens = parseCommand(input);
+    std::vector<unsigned char> flags, currentFlags;
+    auto tokens = parseCommand(input, &flags);
 
-    for (const auto& token : tokens) {
-        if (token == "|") {
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i] == "|") {
             if (!currentCmd.empty()) {
                 commands.push_back(currentCmd);
                 currentCmd.clear();
+                if (expansions) expansions->push_back(currentFlags);
+                currentFlags.clear();
             }
         } else {
-            currentCmd.push_back(token);
+            currentCmd.push_back(tokens[i]);
+            currentFlags.push_back(flags[i]);
         }
     }
 
     if (!currentCmd.empty()) {
         commands.push_back(currentCmd);
+        if (expansions) expansions->push_back(currentFlags);
     }
 
     return commands;
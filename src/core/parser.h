@@ -3,9 +3,36 @@
 #include <string>
 #include <vector>
 
+// here-doc 分词后是操作符加正文两个记号：正文需要展开时为 "<<"，
+// 定界符带引号（正文按原样使用）时为 "<<'"；<<- 去掉的前导制表符已在分词时处理
+inline constexpr const char* HEREDOC_OPERATOR = "<<";
+inline constexpr const char* HEREDOC_LITERAL_OPERATOR = "<<'";
+
+// 记号中未加引号、需要展开的字符（按位组合）
+enum WordExpansion : unsigned char {
+    WORD_GLOB = 1,     // * ? [：路径名展开
+    WORD_BRACE = 2     // {：大括号展开
+};
+
+// 尚未读到正文的 here-doc 定界符
+struct HereDocDelimiter {
+    std::string word;
+    bool stripTabs = false;   // <<- 忽略正文与定界符行的前导制表符
+};
+
 class CommandParser {
 public:
-    std::vector<std::string> parseCommand(const std::string& input) const;
-    std::vector<std::vector<std::string>> parsePipeline(const std::string& input) const;
-};
+    // expansions 不为空时，与记号一一对应地记录 WordExpansion 标志；
+    // 带 WORD_GLOB 的记号是路径名模式，其中加引号的 * ? [ \ 前加了反斜杠（见 GlobPattern::unescape）
+    std::vector<std::string> parseCommand(const std::string& input,
+                                          std::vector<unsigned char>* expansions = nullptr) const;
+    std::vector<std::vector<std::string>> parsePipeline(
+        const std::string& input, std::vector<std::vector<unsigned char>>* expansions = nullptr) const;
 
+    // 输入中缺少正文的 here-doc（按出现顺序），调用方据此继续读取后续行
+    std::vector<HereDocDelimiter> hereDocDelimiters(const std::string& input) const;
+
+private:
+    std::vector<std::string> tokenize(const std::string& input, std::vector<HereDocDelimiter>* unterminated,
+                                      std::vector<unsigned char>* expansions = nullptr) const;
+};
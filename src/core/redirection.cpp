@@ -0,0 +1,345 @@
+#include "core/redirection.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+#include "core/parser.h"
+
+namespace {
+
+// 新建文件的权限（受 umask 影响）
+constexpr mode_t CREATE_MODE = 0644;
+// 父进程中打开的文件至少放在这个编号之上，避免与用户写的描述符冲突
+constexpr int FIRST_PRIVATE_FD = 10;
+// 允许写在重定向中的最大描述符
+constexpr long MAX_USER_FD = 9999;
+
+// 不超过该长度的输入先尝试整块写入管道缓冲区
+constexpr size_t PIPE_DATA_LIMIT = 64 * 1024;
+
+const char* const OPERATORS[] = {">>", ">|", ">&", "<>", "<&", "&>>", "&>", ">", "<", "<<<", "<<", "<<'"};
+
+// 拆分为描述符前缀与操作符，不是重定向时返回 false
+bool splitOperator(const std::string& token, int& fd, std::string& op) {
+    size_t digits = 0;
+    while (digits < token.size() && token[digits] >= '0' && token[digits] <= '9') ++digits;
+
+    op = token.substr(digits);
+    if (std::find(std::begin(OPERATORS), std::end(OPERATORS), op) == std::end(OPERATORS)) {
+        return false;
+    }
+    if (digits == 0) {
+        fd = -1;
+        return true;
+    }
+    if (op[0] == '&' || digits > 4) {
+        return false;
+    }
+    fd = std::stoi(token.substr(0, digits));
+    return true;
+}
+
+bool parseFd(const std::string& text, int& fd) {
+    if (text.empty() || text.size() > 4 ||
+        !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return false;
+    }
+    const long value = std::stol(text);
+    if (value > MAX_USER_FD) return false;
+    fd = static_cast<int>(value);
+    return true;
+}
+
+bool writeAll(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 读取 data 的描述符：管道缓冲区放得下时直接写入管道（不会阻塞），
+// 否则写入 memfd 并回到开头；没有 memfd 时由写线程填充管道
+int dataDescriptor(const std::string& data) {
+    int fds[2];
+    if (data.size() <= PIPE_DATA_LIMIT) {
+        if (pipe2(fds, O_CLOEXEC) < 0) {
+            return -1;
+        }
+        int capacity = fcntl(fds[1], F_GETPIPE_SZ);
+        if (static_cast<size_t>(capacity > 0 ? capacity : PIPE_BUF) >= data.size()) {
+            bool ok = writeAll(fds[1], data);
+            int saved = errno;
+            close(fds[1]);
+            if (!ok) {
+                close(fds[0]);
+                errno = saved;
+                return -1;
+            }
+            return fds[0];
+        }
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+#ifdef MFD_CLOEXEC
+    int memfd = memfd_create("leizi-heredoc", MFD_CLOEXEC);
+    if (memfd >= 0) {
+        if (!writeAll(memfd, data) || lseek(memfd, 0, SEEK_SET) < 0) {
+            int saved = errno;
+            close(memfd);
+            errno = saved;
+            return -1;
+        }
+        return memfd;
+    }
+#endif
+
+    if (pipe2(fds, O_CLOEXEC) < 0) {
+        return -1;
+    }
+    std::thread([writer = fds[1], data]() {
+        // 读端提前关闭时只让 write 返回 EPIPE，不让 SIGPIPE 结束 shell
+        sigset_t pipeSignal;
+        sigemptyset(&pipeSignal);
+        sigaddset(&pipeSignal, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipeSignal, nullptr);
+        writeAll(writer, data);
+        close(writer);
+    }).detach();
+    return fds[0];
+}
+
+} // namespace
+
+RedirectionPlan::RedirectionPlan(RedirectionPlan&& other) noexcept
+    : actions_(std::move(other.actions_)), opened_(other.opened_) {
+    other.actions_.clear();
+    other.opened_ = false;
+}
+
+RedirectionPlan& RedirectionPlan::operator=(RedirectionPlan&& other) noexcept {
+    if (this != &other) {
+        release();
+        actions_ = std::move(other.actions_);
+        opened_ = other.opened_;
+        other.actions_.clear();
+        other.opened_ = false;
+    }
+    return *this;
+}
+
+bool RedirectionPlan::isOperator(const std::string& token) {
+    int fd = -1;
+    std::string op;
+    return splitOperator(token, fd, op);
+}
+
+void RedirectionPlan::addOpen(int fd, std::string path, int flags) {
+    FdAction action;
+    action.type = FdAction::Type::Open;
+    action.fd = fd;
+    action.path = std::move(path);
+    action.flags = flags;
+    actions_.push_back(std::move(action));
+}
+
+void RedirectionPlan::addData(int fd, std::string data) {
+    FdAction action;
+    action.type = FdAction::Type::Data;
+    action.fd = fd;
+    action.data = std::move(data);
+    actions_.push_back(std::move(action));
+}
+
+void RedirectionPlan::addDup(int fd, int source) {
+    FdAction action;
+    action.type = FdAction::Type::Dup;
+    action.fd = fd;
+    action.source = source;
+    actions_.push_back(std::move(action));
+}
+
+void RedirectionPlan::addClose(int fd) {
+    FdAction action;
+    action.type = FdAction::Type::Close;
+    action.fd = fd;
+    actions_.push_back(std::move(action));
+}
+
+bool RedirectionPlan::parse(std::vector<std::string>& tokens, const Expander& expand, std::string& error) {
+    std::vector<std::string> words;
+    words.reserve(tokens.size());
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        int fd = -1;
+        std::string op;
+        if (!splitOperator(tokens[i], fd, op)) {
+            words.push_back(std::move(tokens[i]));
+            continue;
+        }
+        const bool hereDoc = op == HEREDOC_OPERATOR || op == HEREDOC_LITERAL_OPERATOR;
+        if (i + 1 >= tokens.size() || (!hereDoc && (isOperator(tokens[i + 1]) || tokens[i + 1] == "|"))) {
+            error = "syntax error near unexpected token `" +
+                    (i + 1 < tokens.size() ? tokens[i + 1] : std::string("newline")) + "'";
+            return false;
+        }
+        const std::string& target = tokens[++i];
+
+        // here-doc 的目标是正文，here-string 的目标是单词
+        if (op == HEREDOC_OPERATOR || op == HEREDOC_LITERAL_OPERATOR || op == "<<<") {
+            std::string data = op != HEREDOC_LITERAL_OPERATOR && expand ? expand(target) : target;
+            if (op == "<<<") data += '\n';
+            addData(fd < 0 ? STDIN_FILENO : fd, std::move(data));
+            continue;
+        }
+
+        // 复制与关闭：目标是描述符而不是文件名
+        if (op == ">&" || op == "<&") {
+            if (fd < 0) fd = op == "<&" ? STDIN_FILENO : STDOUT_FILENO;
+            int source = -1;
+            if (target == "-") {
+                addClose(fd);
+                continue;
+            }
+            if (parseFd(target, source)) {
+                addDup(fd, source);
+                continue;
+            }
+            if (target.size() > 1 && target.back() == '-' &&
+                parseFd(target.substr(0, target.size() - 1), source)) {
+                addDup(fd, source);
+                if (source != fd) addClose(source);
+                continue;
+            }
+            // >&文件 等同于 &>文件；其余写法没有意义
+            if (op == "<&" || fd != STDOUT_FILENO || tokens[i - 1] != ">&") {
+                error = target + ": ambiguous redirect";
+                return false;
+            }
+            op = "&>";
+        }
+
+        const std::string path = expand ? expand(target) : target;
+        if (path.empty()) {
+            error = target + ": ambiguous redirect";
+            return false;
+        }
+
+        if (op == "<") {
+            addOpen(fd < 0 ? STDIN_FILENO : fd, path, O_RDONLY);
+        } else if (op == "<>") {
+            addOpen(fd < 0 ? STDIN_FILENO : fd, path, O_RDWR | O_CREAT);
+        } else if (op == ">" || op == ">|") {
+            // 没有 noclobber 选项，>| 与 > 相同
+            addOpen(fd < 0 ? STDOUT_FILENO : fd, path, O_WRONLY | O_CREAT | O_TRUNC);
+        } else if (op == ">>") {
+            addOpen(fd < 0 ? STDOUT_FILENO : fd, path, O_WRONLY | O_CREAT | O_APPEND);
+        } else {
+            addOpen(STDOUT_FILENO, path, O_WRONLY | O_CREAT | (op == "&>>" ? O_APPEND : O_TRUNC));
+            addDup(STDERR_FILENO, STDOUT_FILENO);
+        }
+    }
+
+    tokens = std::move(words);
+    return true;
+}
+
+bool RedirectionPlan::open(std::string& error) {
+    int lowest = FIRST_PRIVATE_FD;
+    for (const auto& action : actions_) {
+        lowest = std::max({lowest, action.fd + 1, action.source + 1});
+    }
+
+    for (auto& action : actions_) {
+        int fd = -1;
+        if (action.type == FdAction::Type::Open) {
+            fd = ::open(action.path.c_str(), action.flags | O_CLOEXEC, CREATE_MODE);
+        } else if (action.type == FdAction::Type::Data) {
+            fd = dataDescriptor(action.data);
+        } else {
+            continue;
+        }
+        if (fd >= 0 && fd < lowest) {
+            int moved = fcntl(fd, F_DUPFD_CLOEXEC, lowest);
+            int saved = errno;
+            ::close(fd);
+            errno = saved;
+            fd = moved;
+        }
+        if (fd < 0) {
+            error = (action.type == FdAction::Type::Open ? action.path : std::string("here-document")) + ": " +
+                    std::strerror(errno);
+            opened_ = true;
+            release();
+            return false;
+        }
+        action.source = fd;
+    }
+    opened_ = true;
+    return true;
+}
+
+bool RedirectionPlan::apply(std::string& error) const {
+    for (const auto& action : actions_) {
+        switch (action.type) {
+            case FdAction::Type::Open:
+            case FdAction::Type::Data:
+            case FdAction::Type::Dup:
+                if (action.source == action.fd) {
+                    // n>&n 只检查描述符是否有效
+                    if (fcntl(action.fd, F_GETFD) < 0) {
+                        error = std::to_string(action.fd) + ": " + std::strerror(errno);
+                        return false;
+                    }
+                } else if (dup2(action.source, action.fd) < 0) {
+                    error = std::to_string(action.source) + ": " + std::strerror(errno);
+                    return false;
+                }
+                break;
+            case FdAction::Type::Close:
+                ::close(action.fd);
+                break;
+        }
+    }
+    return true;
+}
+
+bool RedirectionPlan::addSpawnActions(posix_spawn_file_actions_t* actions) const {
+    for (const auto& action : actions_) {
+        int result = 0;
+        if (action.type == FdAction::Type::Close) {
+            result = posix_spawn_file_actions_addclose(actions, action.fd);
+        } else {
+            result = posix_spawn_file_actions_adddup2(actions, action.source, action.fd);
+        }
+        if (result != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RedirectionPlan::release() {
+    if (!opened_) return;
+    for (auto& action : actions_) {
+        if ((action.type == FdAction::Type::Open || action.type == FdAction::Type::Data) && action.source >= 0) {
+            ::close(action.source);
+            action.source = -1;
+        }
+    }
+    opened_ = false;
+}
@@ -0,0 +1,105 @@
+#ifndef LEIZI_CORE_REDIRECTION_H
+#define LEIZI_CORE_REDIRECTION_H
+
+#include <functional>
+#include <spawn.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 一个文件描述符动作
+ */
+struct FdAction {
+    enum class Type {
+        Open,   // 打开 path 到 fd
+        Data,   // 把 data 作为 fd 的输入（here-doc / here-string）
+        Dup,    // 把 source 复制到 fd
+        Close   // 关闭 fd
+    };
+
+    Type type = Type::Close;
+    int fd = -1;
+    int source = -1;      // Dup 的源描述符；Open/Data 在 open() 之后为已打开的描述符
+    std::string path;     // Open：已展开的文件名
+    int flags = 0;        // Open：open(2) 标志
+    std::string data;     // Data：输入内容（需要时已展开）
+};
+
+/**
+ * @brief 一条命令的重定向计划
+ *
+ * 解析时从参数中取出全部重定向，按出现顺序转换为 FdAction 并展开文件名：
+ *
+ *     [n]< [n]> [n]>| [n]>> [n]<>  文件        打开
+ *     [n]>&m [n]<&m                           复制（m- 复制后关闭 m）
+ *     [n]>&- [n]<&-                           关闭
+ *     &> &>> >&文件                           标准输出与标准错误写入同一文件
+ *     [n]<< 正文  [n]<<< 单词                   here-doc / here-string
+ *
+ * 文件在父进程中打开（close-on-exec，编号高于计划引用的所有描述符），
+ * 错误在创建子进程之前报告；子进程只需按顺序执行一批 dup2/close，
+ * 同一计划也可以转换为 posix_spawn 的文件动作。
+ *
+ * here-doc 的正文（分词时已读入，见 CommandParser）在定界符没有引号时才展开。
+ * 内容不超过一个管道缓冲区时预先写入管道，更大的写入 memfd，
+ * 都不需要额外的进程或临时文件。
+ */
+class RedirectionPlan {
+public:
+    using Expander = std::function<std::string(const std::string&)>;
+
+    RedirectionPlan() = default;
+    ~RedirectionPlan() { release(); }
+
+    RedirectionPlan(RedirectionPlan&& other) noexcept;
+    RedirectionPlan& operator=(RedirectionPlan&& other) noexcept;
+    RedirectionPlan(const RedirectionPlan&) = delete;
+    RedirectionPlan& operator=(const RedirectionPlan&) = delete;
+
+    /**
+     * @brief 是否为重定向操作符（可带描述符前缀）
+     */
+    static bool isOperator(const std::string& token);
+
+    /**
+     * @brief 从 tokens 中移除所有重定向，按顺序追加动作
+     * @param expand 目标文件名的展开函数
+     * @return 语法错误时返回 false，error 为错误说明
+     */
+    bool parse(std::vector<std::string>& tokens, const Expander& expand, std::string& error);
+
+    /**
+     * @brief 在当前（父）进程中打开所有文件
+     * @return 失败时返回 false 并关闭已打开的文件，error 为“文件名: 原因”
+     */
+    bool open(std::string& error);
+
+    /**
+     * @brief 在子进程中按顺序执行 dup2/close（需先 open）
+     */
+    bool apply(std::string& error) const;
+
+    /**
+     * @brief 转换为 posix_spawn 文件动作（需先 open）
+     */
+    bool addSpawnActions(posix_spawn_file_actions_t* actions) const;
+
+    /**
+     * @brief 关闭 open 打开的文件（析构时自动调用）
+     */
+    void release();
+
+    bool empty() const { return actions_.empty(); }
+    const std::vector<FdAction>& actions() const { return actions_; }
+
+private:
+    std::vector<FdAction> actions_;
+    bool opened_ = false;
+
+    void addOpen(int fd, std::string path, int flags);
+    void addData(int fd, std::string data);
+    void addDup(int fd, int source);
+    void addClose(int fd);
+};
+
+#endif // LEIZI_CORE_REDIRECTION_H
@@ -0,0 +1,81 @@
+#ifndef LEIZI_HISTORY_FILE_IO_H
+#define LEIZI_HISTORY_FILE_IO_H
+
+#include <cerrno>
+#include <cstddef>
+#include <string_view>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 历史文件与归档共用的底层文件操作
+namespace leizi {
+namespace fileio {
+
+// 持有 flock 的 RAII 包装
+class FileLock {
+public:
+    FileLock(int fd, int operation) : fd_(fd) {
+        while (flock(fd_, operation) != 0) {
+            if (errno != EINTR) {
+                fd_ = -1;
+                return;
+            }
+        }
+    }
+    ~FileLock() { unlock(); }
+
+    void unlock() {
+        if (fd_ >= 0) {
+            flock(fd_, LOCK_UN);
+            fd_ = -1;
+        }
+    }
+    bool locked() const { return fd_ >= 0; }
+
+private:
+    int fd_;
+};
+
+inline bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 只读映射整个文件，历史文件可能很大，避免读入堆内存
+class MappedFile {
+public:
+    MappedFile(int fd, size_t size) {
+        if (size == 0) return;
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            data_ = static_cast<const char*>(addr);
+            size_ = size;
+        }
+    }
+    ~MappedFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool valid() const { return data_ != nullptr; }
+    std::string_view content() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace fileio
+} // namespace leizi
+
+#endif // LEIZI_HISTORY_FILE_IO_H
@@ -0,0 +1,351 @@
+#include "history/history_archive.h"
+#include "history/file_io.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <optional>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
+#if LEIZI_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace leizi {
+
+using HistoryFormat::getLe;
+using HistoryFormat::putLe;
+
+namespace {
+
+// size + compression + hashes + flags + count + minTime + maxTime + rawSize + bloomSize
+constexpr size_t HEADER_SIZE = 4 + 1 + 1 + 2 + 4 + 8 + 8 + 4 + 4;
+constexpr std::uint8_t BLOOM_HASHES = 7;
+constexpr size_t BLOOM_BITS_PER_KEY = 10;
+constexpr size_t BLOOM_MIN_BITS = 512;
+constexpr size_t INFLATE_CHUNK = 64 * 1024;
+
+std::uint64_t mix(std::uint64_t x) {
+    // splitmix64 的终结函数
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline unsigned char lowerAscii(char c) {
+    const auto u = static_cast<unsigned char>(c);
+    return (u >= 'A' && u <= 'Z') ? static_cast<unsigned char>(u - 'A' + 'a') : u;
+}
+
+// 布隆过滤器的键：命令的三元组（ASCII 小写）与工作目录
+std::uint64_t trigramKey(const char* p) {
+    return mix((static_cast<std::uint64_t>(lowerAscii(p[0])) << 16) |
+               (static_cast<std::uint64_t>(lowerAscii(p[1])) << 8) | lowerAscii(p[2]));
+}
+
+std::uint64_t cwdKey(std::string_view cwd) {
+    return mix(commandDigest(cwd) ^ 0x9e3779b97f4a7c15ULL);
+}
+
+void bloomAdd(std::string& bits, std::uint64_t key, std::uint8_t hashes) {
+    const std::uint64_t total = bits.size() * 8;
+    const std::uint64_t h1 = key & 0xffffffffULL;
+    const std::uint64_t h2 = (key >> 32) | 1;
+    for (std::uint8_t i = 0; i < hashes; ++i) {
+        const std::uint64_t bit = (h1 + i * h2) % total;
+        bits[bit / 8] = static_cast<char>(static_cast<unsigned char>(bits[bit / 8]) | (1u << (bit % 8)));
+    }
+}
+
+bool bloomTest(std::string_view bits, std::uint64_t key, std::uint8_t hashes) {
+    if (bits.empty()) return true;
+    const std::uint64_t total = bits.size() * 8;
+    const std::uint64_t h1 = key & 0xffffffffULL;
+    const std::uint64_t h2 = (key >> 32) | 1;
+    for (std::uint8_t i = 0; i < hashes; ++i) {
+        const std::uint64_t bit = (h1 + i * h2) % total;
+        if (!(static_cast<unsigned char>(bits[bit / 8]) & (1u << (bit % 8)))) return false;
+    }
+    return true;
+}
+
+struct RawSegment {
+    HistoryArchive::Segment meta;
+    std::uint8_t hashes = 0;
+    std::string_view bloom;
+    std::string_view payload;
+    size_t end = 0;  // 下一段的起始位置
+};
+
+// 解析 offset 处的段，不完整或损坏时返回 nullopt
+std::optional<RawSegment> readSegment(std::string_view content, size_t offset) {
+    if (offset > content.size() || content.size() - offset < HEADER_SIZE + 4) return std::nullopt;
+
+    const char* p = content.data() + offset;
+    const auto size = getLe<std::uint32_t>(p);
+    if (size < HEADER_SIZE || content.size() - offset - 4 < size) return std::nullopt;
+    if (getLe<std::uint32_t>(p + size) != size) return std::nullopt;
+
+    RawSegment segment;
+    segment.meta.offset = offset;
+    segment.meta.compression = static_cast<std::uint8_t>(p[4]);
+    segment.hashes = static_cast<std::uint8_t>(p[5]);
+    segment.meta.flags = getLe<std::uint16_t>(p + 6);
+    segment.meta.count = getLe<std::uint32_t>(p + 8);
+    segment.meta.minTime = getLe<std::int64_t>(p + 12);
+    segment.meta.maxTime = getLe<std::int64_t>(p + 20);
+    segment.meta.rawSize = getLe<std::uint32_t>(p + 28);
+    const auto bloomSize = getLe<std::uint32_t>(p + 32);
+    if (bloomSize > size - HEADER_SIZE) return std::nullopt;
+
+    segment.bloom = std::string_view(p + HEADER_SIZE, bloomSize);
+    segment.payload = std::string_view(p + HEADER_SIZE + bloomSize, size - HEADER_SIZE - bloomSize);
+    segment.meta.storedSize = segment.payload.size();
+    segment.end = offset + size + 4;
+    return segment;
+}
+
+bool mayContain(const RawSegment& segment, const HistoryArchive::Filter& filter) {
+    if (filter.since > 0 && segment.meta.maxTime < filter.since) return false;
+    if (filter.failedOnly && !(segment.meta.flags & HistoryArchive::FLAG_HAS_FAILURES)) return false;
+    if (!filter.cwd.empty() && !bloomTest(segment.bloom, cwdKey(filter.cwd), segment.hashes)) return false;
+    for (size_t i = 0; i + 3 <= filter.contains.size(); ++i) {
+        if (!bloomTest(segment.bloom, trigramKey(filter.contains.data() + i), segment.hashes)) return false;
+    }
+    return true;
+}
+
+// 回调 records 中完整的记录，返回已消费的字节数；回调要求停止时 stopped 置为 true
+size_t emitRecords(std::string_view records, const HistoryArchive::Filter& filter,
+                   const std::function<bool(const HistoryRecordView&)>& callback, bool& stopped) {
+    size_t offset = 0;
+    while (size_t size = HistoryFormat::recordSize(records, offset)) {
+        HistoryRecordView record;
+        if (HistoryFormat::decodeView(records, offset, record) && filter.matches(record) && !callback(record)) {
+            stopped = true;
+            return offset + size;
+        }
+        offset += size;
+    }
+    return offset;
+}
+
+#if LEIZI_HAVE_ZLIB
+// 边解压边回调，内存占用与段大小无关
+bool inflateSegment(std::string_view payload, const HistoryArchive::Filter& filter,
+                    const std::function<bool(const HistoryRecordView&)>& callback, bool& stopped) {
+    z_stream stream {};
+    if (inflateInit(&stream) != Z_OK) return false;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload.data()));
+    stream.avail_in = static_cast<uInt>(payload.size());
+
+    std::string buffer;
+    bool ok = true;
+    while (!stopped) {
+        const size_t used = buffer.size();
+        buffer.resize(used + INFLATE_CHUNK);
+        stream.next_out = reinterpret_cast<Bytef*>(buffer.data() + used);
+        stream.avail_out = static_cast<uInt>(INFLATE_CHUNK);
+
+        const int rc = inflate(&stream, Z_NO_FLUSH);
+        buffer.resize(used + INFLATE_CHUNK - stream.avail_out);
+        if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) {
+            ok = false;
+            break;
+        }
+
+        buffer.erase(0, emitRecords(buffer, filter, callback, stopped));
+        if (rc == Z_STREAM_END) break;
+        if (rc == Z_BUF_ERROR && stream.avail_in == 0) {
+            ok = false;  // 数据被截断
+            break;
+        }
+    }
+    inflateEnd(&stream);
+    return ok;
+}
+#endif
+
+// 有效段的结束位置，之后的字节是写到一半的残留
+size_t validLength(std::string_view content) {
+    size_t offset = HistoryArchive::MAGIC.size();
+    while (auto segment = readSegment(content, offset)) {
+        offset = segment->end;
+    }
+    return offset;
+}
+
+} // namespace
+
+bool HistoryArchive::Filter::matches(const HistoryRecordView& record) const {
+    if (failedOnly && record.exitCode == 0) return false;
+    if (since > 0 && record.startTime < since) return false;
+    if (!cwd.empty() && record.cwd != cwd) return false;
+    if (!contains.empty() && record.command.find(contains) == std::string_view::npos) return false;
+    return true;
+}
+
+bool HistoryArchive::appendSegment(std::string_view records) {
+    // 统计与布隆过滤器
+    std::uint32_t count = 0;
+    std::int64_t minTime = 0;
+    std::int64_t maxTime = 0;
+    std::uint16_t flags = 0;
+    std::unordered_set<std::uint64_t> keys;
+    size_t offset = 0;
+    while (size_t size = HistoryFormat::recordSize(records, offset)) {
+        HistoryRecordView record;
+        if (!HistoryFormat::decodeView(records, offset, record)) break;
+        minTime = count == 0 ? record.startTime : std::min(minTime, record.startTime);
+        maxTime = count == 0 ? record.startTime : std::max(maxTime, record.startTime);
+        if (record.exitCode != 0) flags |= FLAG_HAS_FAILURES;
+        for (size_t i = 0; i + 3 <= record.command.size(); ++i) {
+            keys.insert(trigramKey(record.command.data() + i));
+        }
+        keys.insert(cwdKey(record.cwd));
+        ++count;
+        offset += size;
+    }
+    if (count == 0 || offset != records.size()) {
+        return false;
+    }
+
+    std::string bloom((std::max(BLOOM_MIN_BITS, keys.size() * BLOOM_BITS_PER_KEY) + 7) / 8, '\0');
+    for (std::uint64_t key : keys) {
+        bloomAdd(bloom, key, BLOOM_HASHES);
+    }
+
+    std::uint8_t compression = COMPRESSION_NONE;
+    std::string compressed;
+#if LEIZI_HAVE_ZLIB
+    uLongf length = compressBound(static_cast<uLong>(records.size()));
+    compressed.resize(length);
+    if (compress2(reinterpret_cast<Bytef*>(compressed.data()), &length,
+                  reinterpret_cast<const Bytef*>(records.data()), static_cast<uLong>(records.size()),
+                  Z_BEST_COMPRESSION) == Z_OK && length < records.size()) {
+        compressed.resize(length);
+        compression = COMPRESSION_ZLIB;
+    }
+#endif
+    const std::string_view payload = compression == COMPRESSION_NONE ? records : std::string_view(compressed);
+
+    const auto size = static_cast<std::uint32_t>(HEADER_SIZE + bloom.size() + payload.size());
+    std::string segment;
+    segment.reserve(size + 4);
+    putLe(segment, size);
+    segment += static_cast<char>(compression);
+    segment += static_cast<char>(BLOOM_HASHES);
+    putLe(segment, flags);
+    putLe(segment, count);
+    putLe(segment, minTime);
+    putLe(segment, maxTime);
+    putLe(segment, static_cast<std::uint32_t>(records.size()));
+    putLe(segment, static_cast<std::uint32_t>(bloom.size()));
+    segment += bloom;
+    segment += payload;
+    putLe(segment, size);
+
+    int fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+
+    bool ok = false;
+    fileio::FileLock lock(fd, LOCK_EX);
+    struct stat st {};
+    if (lock.locked() && fstat(fd, &st) == 0) {
+        size_t end = static_cast<size_t>(st.st_size);
+        bool valid = true;
+        if (end == 0) {
+            valid = fileio::writeAll(fd, MAGIC.data(), MAGIC.size());
+            end = MAGIC.size();
+        } else {
+            // 上次写到一半的段被截掉，否则之后追加的段都无法读取
+            fileio::MappedFile map(fd, end);
+            const std::string_view content = map.content();
+            valid = map.valid() && content.substr(0, MAGIC.size()) == MAGIC;
+            if (valid) {
+                const size_t good = validLength(content);
+                if (good != end) {
+                    valid = ftruncate(fd, static_cast<off_t>(good)) == 0;
+                    end = good;
+                }
+            }
+        }
+        ok = valid && lseek(fd, static_cast<off_t>(end), SEEK_SET) >= 0 &&
+             fileio::writeAll(fd, segment.data(), segment.size()) && fsync(fd) == 0;
+    }
+    lock.unlock();
+    ::close(fd);
+    return ok;
+}
+
+std::vector<HistoryArchive::Segment> HistoryArchive::segments() const {
+    std::vector<Segment> result;
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return result;
+
+    struct stat st {};
+    if (fstat(fd, &st) == 0) {
+        fileio::MappedFile map(fd, static_cast<size_t>(st.st_size));
+        const std::string_view content = map.content();
+        if (map.valid() && content.substr(0, MAGIC.size()) == MAGIC) {
+            size_t offset = MAGIC.size();
+            while (auto segment = readSegment(content, offset)) {
+                result.push_back(segment->meta);
+                offset = segment->end;
+            }
+        }
+    }
+    ::close(fd);
+    return result;
+}
+
+bool HistoryArchive::scan(const Filter& filter, const std::function<bool(const HistoryRecordView&)>& callback,
+                          ScanStats* stats) const {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    fileio::MappedFile map(fd, static_cast<size_t>(st.st_size));
+    ::close(fd);
+    const std::string_view content = map.content();
+    if (!map.valid() || content.substr(0, MAGIC.size()) != MAGIC) return false;
+
+    ScanStats local;
+    bool stopped = false;
+    for (size_t offset = MAGIC.size(); !stopped;) {
+        auto segment = readSegment(content, offset);
+        if (!segment) break;
+        offset = segment->end;
+        ++local.segments;
+
+        if (!mayContain(*segment, filter)) {
+            ++local.skipped;
+            continue;
+        }
+
+        if (segment->meta.compression == COMPRESSION_NONE) {
+            emitRecords(segment->payload, filter, callback, stopped);
+            continue;
+        }
+#if LEIZI_HAVE_ZLIB
+        if (segment->meta.compression == COMPRESSION_ZLIB &&
+            inflateSegment(segment->payload, filter, callback, stopped)) {
+            continue;
+        }
+#endif
+        ++local.unreadable;
+    }
+
+    if (stats) *stats = local;
+    return true;
+}
+
+} // namespace leizi
@@ -0,0 +1,108 @@
+#ifndef LEIZI_HISTORY_HISTORY_ARCHIVE_H
+#define LEIZI_HISTORY_HISTORY_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "history/history_record.h"
+
+namespace leizi {
+
+/**
+ * @brief 历史归档（冷数据层）
+ *
+ * 历史文件压缩时被挤出的旧记录以段为单位追加到归档文件中。每段保存
+ * 记录条数、最早/最晚开始时间与一个布隆过滤器（命令的三元组与工作目录），
+ * 记录本身用 zlib 压缩（编译时没有 zlib 则不压缩）。
+ * 查询先用时间范围与布隆过滤器排除不可能匹配的段，剩下的段边解压边回调，
+ * 不需要把整段解压到内存。
+ *
+ * 文件格式：8 字节魔数，随后是首尾都带长度的段（小端）：
+ *
+ *     u32 size | u8 compression | u8 hashes | u16 flags | u32 count
+ *              | i64 minTime | i64 maxTime | u32 rawSize | u32 bloomSize
+ *              | bloom | payload | u32 size
+ *
+ * flags 的最低位表示段内有退出码非零的命令。
+ * payload 解压后是按历史文件格式编码的记录序列（不含魔数）。
+ */
+class HistoryArchive {
+public:
+    /**
+     * @brief 一段的元数据
+     */
+    struct Segment {
+        size_t offset = 0;             // 段在归档文件中的起始位置
+        std::uint8_t compression = 0;  // 0 不压缩，1 zlib
+        std::uint16_t flags = 0;
+        std::uint32_t count = 0;
+        std::int64_t minTime = 0;
+        std::int64_t maxTime = 0;
+        std::uint32_t rawSize = 0;     // 解压后的字节数
+        size_t storedSize = 0;         // 文件中的 payload 字节数
+    };
+
+    /**
+     * @brief 查询条件，空字段表示不限制
+     */
+    struct Filter {
+        std::string_view contains;    // 命令包含的子串（区分大小写）
+        std::string_view cwd;         // 工作目录
+        std::int64_t since = 0;       // 开始时间下限（Unix 秒）
+        bool failedOnly = false;
+
+        bool matches(const HistoryRecordView& record) const;
+    };
+
+    /**
+     * @brief 查询统计
+     */
+    struct ScanStats {
+        size_t segments = 0;
+        size_t skipped = 0;       // 未解压直接跳过的段
+        size_t unreadable = 0;    // 压缩方式不受支持或数据损坏的段
+    };
+
+    static constexpr std::string_view MAGIC {"LZARCH1\n", 8};
+    static constexpr std::uint8_t COMPRESSION_NONE = 0;
+    static constexpr std::uint8_t COMPRESSION_ZLIB = 1;
+    static constexpr std::uint16_t FLAG_HAS_FAILURES = 1;
+
+    explicit HistoryArchive(std::string path) : path_(std::move(path)) {}
+
+    /**
+     * @brief 历史文件对应的归档路径
+     */
+    static std::string pathFor(const std::string& historyPath) { return historyPath + ".archive"; }
+
+    const std::string& path() const { return path_; }
+
+    /**
+     * @brief 把编码好的记录序列（历史文件格式，不含魔数）追加为一段
+     *
+     * 调用方负责互斥（历史文件压缩时持有排他锁）。写入后 fsync。
+     */
+    bool appendSegment(std::string_view records);
+
+    /**
+     * @brief 按时间顺序遍历满足条件的记录，回调返回 false 时停止
+     */
+    bool scan(const Filter& filter, const std::function<bool(const HistoryRecordView&)>& callback,
+              ScanStats* stats = nullptr) const;
+
+    /**
+     * @brief 读取所有段的元数据（只读段头）
+     */
+    std::vector<Segment> segments() const;
+
+private:
+    std::string path_;
+};
+
+} // namespace leizi
+
+#endif // LEIZI_HISTORY_HISTORY_ARCHIVE_H
@@ -0,0 +1,218 @@
+#include "history/history_file.h"
+#include "history/file_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <string>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace leizi {
+
+namespace {
+
+using fileio::FileLock;
+using fileio::MappedFile;
+using fileio::writeAll;
+
+// 写入临时文件后原子替换，调用方须持有原文件的排他锁
+bool replaceFile(const std::string& path, std::string_view content) {
+    std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+    int tmp = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (tmp < 0) return false;
+
+    bool ok = writeAll(tmp, content.data(), content.size()) && fsync(tmp) == 0;
+    ::close(tmp);
+    if (ok && rename(tmpPath.c_str(), path.c_str()) == 0) {
+        return true;
+    }
+    unlink(tmpPath.c_str());
+    return false;
+}
+
+} // namespace
+
+HistoryFile::HistoryFile(std::string path) : path_(std::move(path)) {
+    open();
+}
+
+HistoryFile::~HistoryFile() {
+    wait();
+    close();
+}
+
+bool HistoryFile::open() {
+    // 新文件写入魔数，旧的纯文本文件转换为二进制格式；
+    // 转换会替换文件，所以替换后重新打开
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+        if (fd_ < 0) return false;
+
+        FileLock lock(fd_, LOCK_EX);
+        if (!lock.locked()) return false;
+        if (replacedOnDisk()) {
+            lock.unlock();
+            close();
+            continue;
+        }
+
+        struct stat st {};
+        if (fstat(fd_, &st) != 0) return false;
+        if (st.st_size == 0) {
+            return writeAll(fd_, HistoryFormat::MAGIC.data(), HistoryFormat::MAGIC.size());
+        }
+
+        int readFd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (readFd < 0) return false;
+        MappedFile map(readFd, static_cast<size_t>(st.st_size));
+        ::close(readFd);
+        if (!map.valid()) return false;
+
+        const std::string_view content = map.content();
+        if (HistoryFormat::isBinary(content)) {
+            // 尾部完整时无需扫描；否则截掉崩溃时写了一半的记录，
+            // 不然之后追加的记录都无法读取
+            if (content.size() == HistoryFormat::MAGIC.size() ||
+                HistoryFormat::previousRecord(content, content.size())) {
+                return true;
+            }
+            size_t valid = HistoryFormat::validLength(content);
+            return ftruncate(fd_, static_cast<off_t>(valid)) == 0;
+        }
+
+        std::string converted(HistoryFormat::MAGIC);
+        for (const auto& record : HistoryFormat::parse(content)) {
+            HistoryFormat::encode(record, converted);
+        }
+        bool replaced = replaceFile(path_, converted);
+        lock.unlock();
+        close();
+        if (!replaced) return false;
+    }
+    return false;
+}
+
+void HistoryFile::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool HistoryFile::replacedOnDisk() const {
+    struct stat opened {};
+    struct stat onDisk {};
+    if (fstat(fd_, &opened) != 0 || stat(path_.c_str(), &onDisk) != 0) {
+        return true;
+    }
+    return opened.st_ino != onDisk.st_ino || opened.st_dev != onDisk.st_dev;
+}
+
+bool HistoryFile::append(const HistoryRecord& record) {
+    std::string encoded;
+    HistoryFormat::encode(record, encoded);
+
+    // 压缩会用新文件替换旧文件：拿到锁后若发现已被替换，重新打开再写
+    bool written = false;
+    for (int attempt = 0; attempt < 3 && !written; ++attempt) {
+        if (fd_ < 0 && !open()) return false;
+
+        FileLock lock(fd_, LOCK_SH);
+        if (!lock.locked()) return false;
+        if (replacedOnDisk()) {
+            lock.unlock();
+            close();
+            continue;
+        }
+        written = writeAll(fd_, encoded.data(), encoded.size());
+        break;
+    }
+
+    if (written && ++appendsSinceCheck_ >= COMPACT_CHECK_INTERVAL) {
+        maybeCompact();
+    }
+    return written;
+}
+
+void HistoryFile::setArchive(const std::string& archivePath, size_t minSegmentRecords) {
+    archive_ = std::make_unique<HistoryArchive>(archivePath);
+    archiveMinRecords_ = std::max<size_t>(1, minSegmentRecords);
+}
+
+void HistoryFile::maybeCompact() {
+    appendsSinceCheck_ = 0;
+    if (compacting_.exchange(true)) {
+        return;
+    }
+    if (compactor_.joinable()) {
+        compactor_.join();
+    }
+
+    const size_t limit = maxEntries_;
+    compactor_ = std::thread([this, limit] {
+        compact(limit);
+        compacting_ = false;
+    });
+}
+
+void HistoryFile::wait() {
+    if (compactor_.joinable()) {
+        compactor_.join();
+    }
+}
+
+bool HistoryFile::compact(size_t maxEntries) {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    // 持有排他锁直到 rename 完成，期间的追加会等待并随后写入新文件
+    FileLock lock(fd, LOCK_EX);
+    struct stat st {};
+    if (!lock.locked() || fstat(fd, &st) != 0) {
+        lock.unlock();
+        ::close(fd);
+        return false;
+    }
+
+    bool compacted = false;
+    MappedFile map(fd, static_cast<size_t>(st.st_size));
+    const std::string_view content = map.content();
+    if (map.valid() && HistoryFormat::isBinary(content)) {
+        // 从尾部向前数出要保留的记录，不必扫描整个文件
+        size_t keepFrom = content.size();
+        size_t kept = 0;
+        while (kept < maxEntries) {
+            auto start = HistoryFormat::previousRecord(content, keepFrom);
+            if (!start) break;
+            keepFrom = *start;
+            ++kept;
+        }
+
+        bool overflow = kept == maxEntries && HistoryFormat::previousRecord(content, keepFrom);
+        if (overflow && archive_) {
+            // 旧记录积累到一段的大小才归档；归档写入失败时保留原文件，不丢记录
+            size_t excess = 0;
+            for (size_t end = keepFrom; excess < archiveMinRecords_; ++excess) {
+                auto start = HistoryFormat::previousRecord(content, end);
+                if (!start) break;
+                end = *start;
+            }
+            const size_t magic = HistoryFormat::MAGIC.size();
+            overflow = excess >= archiveMinRecords_ &&
+                       archive_->appendSegment(content.substr(magic, keepFrom - magic));
+        }
+        if (overflow) {
+            std::string tail(HistoryFormat::MAGIC);
+            tail.append(content.substr(keepFrom));
+            compacted = replaceFile(path_, tail);
+        }
+    }
+
+    lock.unlock();
+    ::close(fd);
+    return compacted;
+}
+
+} // namespace leizi
@@ -0,0 +1,90 @@
+#ifndef LEIZI_HISTORY_HISTORY_FILE_H
+#define LEIZI_HISTORY_HISTORY_FILE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+
+#include "history/history_archive.h"
+#include "history/history_record.h"
+
+namespace leizi {
+
+/**
+ * @brief 只追加的历史文件写入器
+ *
+ * 每条命令执行完成时以 O_APPEND 方式一次 write 写入一条记录，
+ * 崩溃或 kill -9 最多丢失正在写的一条（下次打开时截掉不完整的尾部）。
+ * 打开旧的纯文本历史文件时会先转换为二进制格式。
+ * 多个 shell 同时追加时各自持有共享锁；压缩在后台线程中持有排他锁，
+ * 写入临时文件后 rename 覆盖原文件，追加方发现 inode 变化后重新打开。
+ * 设置了归档时，被挤出的旧记录先写入归档再替换文件。
+ */
+class HistoryFile {
+public:
+    explicit HistoryFile(std::string path);
+    ~HistoryFile();
+
+    HistoryFile(const HistoryFile&) = delete;
+    HistoryFile& operator=(const HistoryFile&) = delete;
+
+    const std::string& path() const { return path_; }
+
+    /**
+     * @brief 追加一条历史记录
+     * @return 写入失败时返回 false
+     */
+    bool append(const HistoryRecord& record);
+
+    /**
+     * @brief 设置保留的最大条数（[history] size）
+     */
+    void setMaxEntries(size_t maxEntries) { maxEntries_ = maxEntries; }
+    size_t maxEntries() const { return maxEntries_; }
+
+    /**
+     * @brief 压缩时把挤出的旧记录写入归档（[history] archive），而不是丢弃
+     * @param minSegmentRecords 至少积累这么多条旧记录才压缩，避免产生过小的段
+     */
+    void setArchive(const std::string& archivePath, size_t minSegmentRecords = ARCHIVE_SEGMENT_RECORDS);
+
+    /**
+     * @brief 在后台线程中检查并压缩文件，已有压缩在进行时直接返回
+     */
+    void maybeCompact();
+
+    /**
+     * @brief 同步压缩：条数超过 maxEntries 时只保留最新的 maxEntries 条
+     * @return 实际发生压缩时返回 true
+     */
+    bool compact(size_t maxEntries);
+
+    /**
+     * @brief 等待后台压缩结束
+     */
+    void wait();
+
+    static constexpr size_t COMPACT_CHECK_INTERVAL = 64;  // 每追加多少条检查一次
+    static constexpr size_t ARCHIVE_SEGMENT_RECORDS = 4096;
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    size_t maxEntries_ = 10000;
+    size_t appendsSinceCheck_ = 0;
+    std::thread compactor_;
+    std::atomic<bool> compacting_ {false};
+    std::unique_ptr<HistoryArchive> archive_;
+    size_t archiveMinRecords_ = ARCHIVE_SEGMENT_RECORDS;
+
+    bool open();
+    void close();
+    bool replacedOnDisk() const;
+};
+
+} // namespace leizi
+
+#endif // LEIZI_HISTORY_HISTORY_FILE_H
@@ -0,0 +1,66 @@
+#include "history/history_list.h"
+
+#include "history/history_record.h"
+
+namespace leizi {
+
+namespace {
+
+// 空位数超过该值且超过一半时压缩
+constexpr size_t COMPACT_MIN_TOMBSTONES = 64;
+
+} // namespace
+
+bool HistoryList::ignored(const std::string& command) const {
+    return command.empty() || (ignoreSpace_ && command.front() == ' ');
+}
+
+HistoryList::AddResult HistoryList::add(const std::string& command) {
+    if (ignored(command)) {
+        return AddResult::Ignored;
+    }
+
+    const std::uint64_t digest = commandDigest(command);
+    auto found = slots_.find(digest);
+    bool moved = false;
+    if (found != slots_.end() && ignoreDuplicates_ && entries_[found->second] == command) {
+        entries_[found->second].clear();
+        ++tombstones_;
+        moved = true;
+    }
+
+    // 摘要冲突（不同命令）时新位置覆盖旧映射，旧命令只是不再参与去重
+    slots_[digest] = entries_.size();
+    entries_.push_back(command);
+
+    if (tombstones_ > COMPACT_MIN_TOMBSTONES && tombstones_ * 2 > entries_.size()) {
+        compact();
+    }
+    return moved ? AddResult::Moved : AddResult::Added;
+}
+
+void HistoryList::compact() {
+    size_t out = 0;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].empty()) continue;
+        if (out != i) {
+            entries_[out] = std::move(entries_[i]);
+        }
+        ++out;
+    }
+    entries_.resize(out);
+    tombstones_ = 0;
+
+    slots_.clear();
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        slots_[commandDigest(entries_[i])] = i;
+    }
+}
+
+void HistoryList::clear() {
+    entries_.clear();
+    slots_.clear();
+    tombstones_ = 0;
+}
+
+} // namespace leizi
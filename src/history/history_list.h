@@ -0,0 +1,62 @@
+#ifndef LEIZI_HISTORY_HISTORY_LIST_H
+#define LEIZI_HISTORY_HISTORY_LIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace leizi {
+
+/**
+ * @brief 去重的命令列表（readline 导航与补全使用）
+ *
+ * 按 [history] ignore_duplicates 与 ignore_space 过滤：以空格开头的命令不记录，
+ * 重复的命令移到末尾而不是再存一份。命令摘要映射到所在位置，
+ * 移动时把旧位置置为空字符串（墓碑），空位过多时整体压缩，均摊 O(1)。
+ */
+class HistoryList {
+public:
+    enum class AddResult {
+        Added,    // 新命令
+        Moved,    // 重复命令，已从原位置移到末尾
+        Ignored   // 被 ignore_space 过滤或为空
+    };
+
+    void setIgnoreDuplicates(bool ignore) { ignoreDuplicates_ = ignore; }
+    void setIgnoreSpace(bool ignore) { ignoreSpace_ = ignore; }
+    bool ignoreSpace() const { return ignoreSpace_; }
+
+    /**
+     * @brief 命令是否会被 ignore_space 过滤
+     */
+    bool ignored(const std::string& command) const;
+
+    AddResult add(const std::string& command);
+
+    /**
+     * @brief 按时间顺序排列的命令，空字符串是已移走的位置，遍历时跳过
+     */
+    const std::vector<std::string>& entries() const { return entries_; }
+
+    /**
+     * @brief 有效命令数（不含空位）
+     */
+    size_t size() const { return entries_.size() - tombstones_; }
+
+    void clear();
+
+private:
+    std::vector<std::string> entries_;
+    std::unordered_map<std::uint64_t, size_t> slots_;  // 命令摘要 -> 最近的位置
+    size_t tombstones_ = 0;
+    bool ignoreDuplicates_ = true;
+    bool ignoreSpace_ = true;
+
+    void compact();
+};
+
+} // namespace leizi
+
+#endif // LEIZI_HISTORY_HISTORY_LIST_H
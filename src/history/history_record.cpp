@@ -0,0 +1,134 @@
+#include "history/history_record.h"
+
+namespace leizi {
+
+std::uint64_t commandDigest(std::string_view command) {
+    std::uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : command) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+namespace HistoryFormat {
+
+bool isBinary(std::string_view content) {
+    return content.size() >= MAGIC.size() && content.substr(0, MAGIC.size()) == MAGIC;
+}
+
+void encode(const HistoryRecord& record, std::string& out) {
+    const auto payload = static_cast<std::uint32_t>(FIXED_PAYLOAD + record.cwd.size() + record.command.size());
+
+    out.reserve(out.size() + payload + 2 * LENGTH_SIZE);
+    putLe(out, payload);
+    putLe(out, record.startTime);
+    putLe(out, record.durationMs);
+    putLe(out, record.exitCode);
+    putLe(out, record.sessionId);
+    putLe(out, static_cast<std::uint32_t>(record.cwd.size()));
+    out += record.cwd;
+    putLe(out, static_cast<std::uint32_t>(record.command.size()));
+    out += record.command;
+    putLe(out, payload);
+}
+
+size_t recordSize(std::string_view content, size_t offset) {
+    if (offset > content.size() || content.size() - offset < 2 * LENGTH_SIZE + FIXED_PAYLOAD) return 0;
+
+    const char* p = content.data() + offset;
+    const auto payload = getLe<std::uint32_t>(p);
+    if (payload < FIXED_PAYLOAD || payload > MAX_PAYLOAD) return 0;
+    if (content.size() - offset < payload + 2 * LENGTH_SIZE) return 0;
+    if (getLe<std::uint32_t>(p + LENGTH_SIZE + payload) != payload) return 0;
+    return payload + 2 * LENGTH_SIZE;
+}
+
+size_t validLength(std::string_view content, std::vector<size_t>* offsets) {
+    if (!isBinary(content)) return 0;
+
+    size_t offset = MAGIC.size();
+    while (size_t size = recordSize(content, offset)) {
+        if (offsets) offsets->push_back(offset);
+        offset += size;
+    }
+    return offset;
+}
+
+bool decodeView(std::string_view content, size_t offset, HistoryRecordView& view) {
+    if (recordSize(content, offset) == 0) return false;
+
+    const char* p = content.data() + offset;
+    const auto payload = getLe<std::uint32_t>(p);
+    const char* field = p + LENGTH_SIZE;
+
+    const auto cwdLen = getLe<std::uint32_t>(field + 24);
+    if (cwdLen > payload - FIXED_PAYLOAD) return false;
+    const char* cmdLenField = field + 28 + cwdLen;
+    const auto cmdLen = getLe<std::uint32_t>(cmdLenField);
+    if (FIXED_PAYLOAD + cwdLen + cmdLen != payload) return false;
+
+    view.startTime = getLe<std::int64_t>(field);
+    view.durationMs = getLe<std::uint32_t>(field + 8);
+    view.exitCode = getLe<std::int32_t>(field + 12);
+    view.sessionId = getLe<std::uint64_t>(field + 16);
+    view.cwd = std::string_view(field + 28, cwdLen);
+    view.command = std::string_view(cmdLenField + 4, cmdLen);
+    return true;
+}
+
+bool decode(std::string_view content, size_t& offset, HistoryRecord& record) {
+    HistoryRecordView view;
+    if (!decodeView(content, offset, view)) return false;
+
+    record = view.toRecord();
+    offset += recordSize(content, offset);
+    return true;
+}
+
+std::optional<size_t> previousRecord(std::string_view content, size_t end) {
+    if (end > content.size() || end < MAGIC.size() + 2 * LENGTH_SIZE + FIXED_PAYLOAD) return std::nullopt;
+
+    const auto payload = getLe<std::uint32_t>(content.data() + end - LENGTH_SIZE);
+    if (payload < FIXED_PAYLOAD || payload > MAX_PAYLOAD) return std::nullopt;
+
+    const size_t size = payload + 2 * LENGTH_SIZE;
+    if (end - MAGIC.size() < size) return std::nullopt;
+
+    const size_t start = end - size;
+    if (recordSize(content, start) != size) return std::nullopt;
+    return start;
+}
+
+std::vector<HistoryRecord> parse(std::string_view content, std::vector<size_t>* offsets) {
+    std::vector<HistoryRecord> records;
+
+    if (isBinary(content)) {
+        size_t offset = MAGIC.size();
+        HistoryRecord record;
+        while (offset < content.size()) {
+            size_t start = offset;
+            if (!decode(content, offset, record)) break;
+            if (offsets) offsets->push_back(start);
+            records.push_back(std::move(record));
+        }
+        return records;
+    }
+
+    // 旧格式：每行一条命令，没有元数据
+    for (size_t pos = 0; pos < content.size();) {
+        size_t eol = content.find('\n', pos);
+        size_t end = eol == std::string_view::npos ? content.size() : eol;
+        if (end > pos) {
+            if (offsets) offsets->push_back(pos);
+            HistoryRecord record;
+            record.command.assign(content.data() + pos, end - pos);
+            records.push_back(std::move(record));
+        }
+        pos = end + 1;
+    }
+    return records;
+}
+
+} // namespace HistoryFormat
+} // namespace leizi
@@ -0,0 +1,143 @@
+#ifndef LEIZI_HISTORY_HISTORY_RECORD_H
+#define LEIZI_HISTORY_HISTORY_RECORD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace leizi {
+
+/**
+ * @brief 一条历史记录
+ */
+struct HistoryRecord {
+    std::string command;
+    std::int64_t startTime = 0;     // 开始时间（Unix 秒），旧格式导入的记录为 0
+    std::uint32_t durationMs = 0;   // 耗时（毫秒）
+    std::int32_t exitCode = 0;      // 退出码
+    std::uint64_t sessionId = 0;    // 所属 shell 会话
+    std::string cwd;                // 执行时的工作目录
+};
+
+/**
+ * @brief 历史记录的只读视图，字符串指向映射的文件或内存中的记录
+ */
+struct HistoryRecordView {
+    std::string_view command;
+    std::int64_t startTime = 0;
+    std::uint32_t durationMs = 0;
+    std::int32_t exitCode = 0;
+    std::uint64_t sessionId = 0;
+    std::string_view cwd;
+
+    HistoryRecordView() = default;
+    HistoryRecordView(const HistoryRecord& record)
+        : command(record.command), startTime(record.startTime), durationMs(record.durationMs),
+          exitCode(record.exitCode), sessionId(record.sessionId), cwd(record.cwd) {}
+
+    HistoryRecord toRecord() const {
+        return HistoryRecord{std::string(command), startTime, durationMs, exitCode, sessionId, std::string(cwd)};
+    }
+};
+
+/**
+ * @brief 命令文本的 64 位摘要（FNV-1a），用于去重与索引
+ */
+std::uint64_t commandDigest(std::string_view command);
+
+/**
+ * @brief 历史文件格式
+ *
+ * 文件以 8 字节魔数开头，随后是首尾都带长度的记录（小端）：
+ *
+ *     u32 len | i64 start | u32 duration | i32 exit | u64 session
+ *             | u32 cwdLen | cwd | u32 cmdLen | cmd | u32 len
+ *
+ * 尾部长度使文件可以从末尾向前扫描。没有魔数的文件按旧的纯文本格式（每行一条）读取。
+ */
+namespace HistoryFormat {
+
+inline constexpr std::string_view MAGIC {"LZHIST1\n", 8};
+inline constexpr size_t LENGTH_SIZE = 4;
+// 固定字段：start + duration + exit + session + cwdLen + cmdLen
+inline constexpr size_t FIXED_PAYLOAD = 8 + 4 + 4 + 8 + 4 + 4;
+// 超过该长度的记录视为损坏
+inline constexpr std::uint32_t MAX_PAYLOAD = 1u << 24;
+
+/**
+ * @brief 小端整数的写入与读取（历史文件与归档段共用）
+ */
+template <typename T>
+void putLe(std::string& out, T value) {
+    using U = std::make_unsigned_t<T>;
+    U bits = static_cast<U>(value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out += static_cast<char>((bits >> (8 * i)) & 0xff);
+    }
+}
+
+template <typename T>
+T getLe(const char* p) {
+    using U = std::make_unsigned_t<T>;
+    U bits = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        bits |= static_cast<U>(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    return static_cast<T>(bits);
+}
+
+/**
+ * @brief 是否为二进制格式（以魔数开头）
+ */
+bool isBinary(std::string_view content);
+
+/**
+ * @brief 把记录编码后追加到 out
+ */
+void encode(const HistoryRecord& record, std::string& out);
+
+/**
+ * @brief 解码 offset 处的记录，成功时 offset 前进到下一条记录
+ * @return 数据不完整或损坏时返回 false，offset 不变
+ */
+bool decode(std::string_view content, size_t& offset, HistoryRecord& record);
+
+/**
+ * @brief 解码 offset 处的记录为视图（不复制字符串）
+ */
+bool decodeView(std::string_view content, size_t offset, HistoryRecordView& view);
+
+/**
+ * @brief 返回 end 之前最后一条完整记录的起始偏移（利用尾部长度向前定位）
+ * @return 定位失败（到达文件头或数据损坏）时返回 nullopt
+ */
+std::optional<size_t> previousRecord(std::string_view content, size_t end);
+
+/**
+ * @brief 返回 offset 处完整记录的总长度（含首尾长度字段），不完整或损坏时返回 0
+ */
+size_t recordSize(std::string_view content, size_t offset);
+
+/**
+ * @brief 二进制内容中完整记录的结束位置，之后的字节是写到一半的残留
+ * @param offsets 可选，输出每条记录的起始偏移
+ */
+size_t validLength(std::string_view content, std::vector<size_t>* offsets = nullptr);
+
+/**
+ * @brief 解析整个历史文件（二进制或旧的纯文本格式）
+ *
+ * 二进制格式遇到损坏或不完整的记录（例如写到一半时崩溃）时停止
+ * @param offsets 可选，输出每条记录在 content 中的起始偏移
+ */
+std::vector<HistoryRecord> parse(std::string_view content, std::vector<size_t>* offsets = nullptr);
+
+} // namespace HistoryFormat
+
+} // namespace leizi
+
+#endif // LEIZI_HISTORY_HISTORY_RECORD_H
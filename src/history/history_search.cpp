@@ -0,0 +1,278 @@
+#include "history/history_search.h"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+
+namespace leizi {
+
+namespace {
+
+constexpr size_t GRAM = 3;
+// 补充索引期间每次查询最多扫描的未索引记录数
+constexpr size_t SCAN_LIMIT = 4096;
+
+inline unsigned char lowerAscii(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+}
+
+// 文本中所有不同的三元组，已排序
+void trigrams(std::string_view text, std::vector<std::uint32_t>& out) {
+    out.clear();
+    if (text.size() < GRAM) return;
+    for (size_t i = 0; i + GRAM <= text.size(); ++i) {
+        out.push_back((static_cast<std::uint32_t>(lowerAscii(text[i])) << 16) |
+                      (static_cast<std::uint32_t>(lowerAscii(text[i + 1])) << 8) |
+                      lowerAscii(text[i + 2]));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+size_t findMatch(std::string_view text, std::string_view query, bool caseSensitive) {
+    if (caseSensitive) {
+        return text.find(query);
+    }
+    auto it = std::search(text.begin(), text.end(), query.begin(), query.end(),
+                          [](char a, char b) {
+                              return lowerAscii(static_cast<unsigned char>(a)) ==
+                                     lowerAscii(static_cast<unsigned char>(b));
+                          });
+    return it == text.end() ? std::string_view::npos : static_cast<size_t>(it - text.begin());
+}
+
+// 排序档位：0 以查询开头，1 在词首匹配，2 其它位置
+int matchTier(std::string_view command, size_t position) {
+    if (position == 0) return 0;
+    const unsigned char before = static_cast<unsigned char>(command[position - 1]);
+    const bool word = (before >= '0' && before <= '9') || (before >= 'a' && before <= 'z') ||
+                      (before >= 'A' && before <= 'Z') || before == '_' || before >= 0x80;
+    return word ? 2 : 1;
+}
+
+// 把 candidates 与已排序的 list 求交集
+void intersect(std::vector<std::uint32_t>& candidates, const std::vector<std::uint32_t>& list) {
+    auto out = candidates.begin();
+    if (list.size() > candidates.size() * 16) {
+        // 长度悬殊时逐个二分查找
+        auto from = list.begin();
+        for (std::uint32_t id : candidates) {
+            from = std::lower_bound(from, list.end(), id);
+            if (from == list.end()) break;
+            if (*from == id) *out++ = id;
+        }
+    } else {
+        auto other = list.begin();
+        for (std::uint32_t id : candidates) {
+            while (other != list.end() && *other < id) ++other;
+            if (other == list.end()) break;
+            if (*other == id) *out++ = id;
+        }
+    }
+    candidates.erase(out, candidates.end());
+}
+
+void rank(std::vector<HistoryMatch>& matches) {
+    std::stable_sort(matches.begin(), matches.end(), [](const HistoryMatch& a, const HistoryMatch& b) {
+        return matchTier(a.command, a.position) < matchTier(b.command, b.position);
+    });
+}
+
+} // namespace
+
+void HistorySearch::reset() {
+    started_ = true;
+    generation_ = store_.generation();
+    appendedSeen_ = 0;
+    backfilled_ = 0;
+    backfillDone_ = false;
+    entries_.clear();
+    byDigest_.clear();
+    postings_.clear();
+}
+
+bool HistorySearch::sync(size_t backfill) {
+    if (!started_ || generation_ != store_.generation()) {
+        reset();
+    }
+
+    // 新增记录：recent(n) 在 n 小于新增数时不触及文件
+    HistoryRecordView view;
+    const size_t appended = store_.appendedCount();
+    for (; appendedSeen_ < appended; ++appendedSeen_) {
+        store_.recent(appended - 1 - appendedSeen_, view);
+        index(view.command, static_cast<std::int32_t>(appendedSeen_ + 1));
+    }
+
+    // 文件记录从新到旧补充；多看一条以便知道是否已经补完
+    for (size_t done = 0; !backfillDone_; ++done) {
+        if (!store_.recent(appended + backfilled_, view)) {
+            backfillDone_ = true;
+            break;
+        }
+        if (done == backfill) break;
+        ++backfilled_;
+        index(view.command, -static_cast<std::int32_t>(backfilled_));
+    }
+    return !backfillDone_;
+}
+
+size_t HistorySearch::back(std::int32_t sequence) const {
+    const size_t appended = store_.appendedCount();
+    return sequence > 0 ? appended - static_cast<size_t>(sequence)
+                        : appended + static_cast<size_t>(-static_cast<std::int64_t>(sequence)) - 1;
+}
+
+void HistorySearch::index(std::string_view command, std::int32_t sequence) {
+    if (command.empty()) return;
+
+    const std::uint64_t hash = commandDigest(command);
+    auto found = byDigest_.find(hash);
+    if (found != byDigest_.end()) {
+        Entry& entry = entries_[found->second];
+        HistoryRecordView existing;
+        if (store_.recent(back(entry.sequence), existing) && existing.command == command) {
+            entry.sequence = std::max(entry.sequence, sequence);
+            ++entry.uses;
+            return;
+        }
+    }
+
+    const auto id = static_cast<std::uint32_t>(entries_.size());
+    entries_.push_back(Entry{sequence, 1});
+    if (found == byDigest_.end()) {
+        // 摘要冲突时不覆盖已有命令，新命令只是不参与去重
+        byDigest_.emplace(hash, id);
+    }
+
+    static thread_local std::vector<std::uint32_t> grams;
+    trigrams(command, grams);
+    for (std::uint32_t gram : grams) {
+        postings_[gram].push_back(id);
+    }
+}
+
+std::vector<HistoryMatch> HistorySearch::search(std::string_view query, size_t limit) {
+    // 只加入新增的记录，旧记录由调用方在空闲时补充
+    sync(0);
+    if (limit == 0) return {};
+
+    const bool caseSensitive = std::any_of(query.begin(), query.end(),
+                                           [](char c) { return c >= 'A' && c <= 'Z'; });
+    if (query.size() < GRAM) {
+        return scanRecent(query, limit, caseSensitive);
+    }
+
+    std::vector<HistoryMatch> matches;
+    searchIndex(query, limit, caseSensitive, matches);
+    // 未索引的记录都比已索引的旧，索引中的匹配不足时才需要它们
+    if (!backfillDone_ && matches.size() < limit) {
+        scanUnindexed(query, limit, caseSensitive, matches);
+    }
+    rank(matches);
+    return matches;
+}
+
+void HistorySearch::searchIndex(std::string_view query, size_t limit, bool caseSensitive,
+                                std::vector<HistoryMatch>& matches) const {
+    std::vector<std::uint32_t> grams;
+    trigrams(query, grams);
+    std::vector<const std::vector<std::uint32_t>*> lists;
+    lists.reserve(grams.size());
+    for (std::uint32_t gram : grams) {
+        auto it = postings_.find(gram);
+        if (it == postings_.end()) return;
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+    std::vector<std::uint32_t> intersection;
+    const std::vector<std::uint32_t>* candidates = lists.front();
+    if (lists.size() > 1) {
+        intersection = *lists.front();
+        for (size_t i = 1; i < lists.size() && !intersection.empty(); ++i) {
+            intersect(intersection, *lists[i]);
+        }
+        candidates = &intersection;
+    }
+
+    // 只保留最近使用的 keep 个候选，按从新到旧校验（三元组都出现并不代表子串匹配）；
+    // 校验淘汰过多时扩大 keep 重来
+    using Candidate = std::pair<std::int32_t, std::uint32_t>;  // (最近序号, 命令编号)
+    std::vector<Candidate> top;
+    HistoryRecordView view;
+    for (size_t keep = limit * 2;; keep *= 4) {
+        top.clear();
+        matches.clear();
+        for (std::uint32_t id : *candidates) {
+            const std::int32_t sequence = entries_[id].sequence;
+            if (top.size() < keep) {
+                top.emplace_back(sequence, id);
+                std::push_heap(top.begin(), top.end(), std::greater<>());
+            } else if (sequence > top.front().first) {
+                std::pop_heap(top.begin(), top.end(), std::greater<>());
+                top.back() = Candidate(sequence, id);
+                std::push_heap(top.begin(), top.end(), std::greater<>());
+            }
+        }
+        std::sort(top.begin(), top.end(), std::greater<>());
+
+        for (const auto& [sequence, id] : top) {
+            const size_t n = back(sequence);
+            store_.recent(n, view);
+            const size_t position = findMatch(view.command, query, caseSensitive);
+            if (position == std::string_view::npos) continue;
+            matches.push_back(HistoryMatch{n, view.command, position, entries_[id].uses});
+            if (matches.size() == limit) break;
+        }
+        if (matches.size() == limit || top.size() == candidates->size()) break;
+    }
+}
+
+// 从最旧的已索引记录向前最多扫描 SCAN_LIMIT 条，补足 limit 条匹配
+void HistorySearch::scanUnindexed(std::string_view query, size_t limit, bool caseSensitive,
+                                  std::vector<HistoryMatch>& matches) const {
+    std::unordered_set<std::string_view> seen;
+    for (const auto& match : matches) {
+        seen.insert(match.command);
+    }
+
+    HistoryRecordView view;
+    const size_t first = store_.appendedCount() + backfilled_;
+    for (size_t n = first; n - first < SCAN_LIMIT && matches.size() < limit && store_.recent(n, view); ++n) {
+        if (view.command.empty()) continue;
+        const size_t position = findMatch(view.command, query, caseSensitive);
+        if (position == std::string_view::npos || !seen.insert(view.command).second) continue;
+
+        std::uint32_t uses = 1;
+        auto found = byDigest_.find(commandDigest(view.command));
+        if (found != byDigest_.end()) {
+            uses = entries_[found->second].uses;
+        }
+        matches.push_back(HistoryMatch{n, view.command, position, uses});
+    }
+}
+
+// 短查询无法使用三元组，从最新的记录向前扫描；短查询通常很快就能凑满 limit 条
+std::vector<HistoryMatch> HistorySearch::scanRecent(std::string_view query, size_t limit, bool caseSensitive) {
+    std::vector<HistoryMatch> matches;
+    std::unordered_set<std::string_view> seen;
+
+    HistoryRecordView view;
+    for (size_t n = 0; matches.size() < limit && store_.recent(n, view); ++n) {
+        if (view.command.empty()) continue;
+        const size_t position = findMatch(view.command, query, caseSensitive);
+        if (position == std::string_view::npos || !seen.insert(view.command).second) continue;
+
+        std::uint32_t uses = 1;
+        auto found = byDigest_.find(commandDigest(view.command));
+        if (found != byDigest_.end()) {
+            uses = entries_[found->second].uses;
+        }
+        matches.push_back(HistoryMatch{n, view.command, position, uses});
+    }
+    rank(matches);
+    return matches;
+}
+
+} // namespace leizi
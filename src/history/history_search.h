@@ -0,0 +1,90 @@
+#ifndef LEIZI_HISTORY_HISTORY_SEARCH_H
+#define LEIZI_HISTORY_HISTORY_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "history/history_store.h"
+
+namespace leizi {
+
+/**
+ * @brief 一条搜索结果
+ */
+struct HistoryMatch {
+    size_t index = 0;           // 最近一次出现的倒数位置（0 为最新），同 HistoryStore::recent
+    std::string_view command;   // 在下一次修改存储之前有效
+    size_t position = 0;        // 匹配在命令中的起始位置
+    std::uint32_t uses = 0;     // 该命令出现的次数
+};
+
+/**
+ * @brief 历史子串搜索
+ *
+ * 对去重后的命令建立三元组（3 字节，ASCII 小写）倒排索引，
+ * 倒排表按命令加入索引的顺序递增，查询时取各三元组倒排表的交集后
+ * 按最近使用时间逐个校验。
+ *
+ * 与 HistorySuggest 相同，新记录在 sync 时加入，加载时已有的文件记录通过
+ * HistoryStore::recent 从新到旧分批补充，不调用 size()，不索引整个文件。
+ * 查询只补上新增的记录；补充尚未完成时，索引中的匹配不足 limit 条才
+ * 向前扫描有限条数的未索引记录。查询含大写字母时区分大小写，否则不区分。
+ */
+class HistorySearch {
+public:
+    explicit HistorySearch(const HistoryStore& store) : store_(store) {}
+
+    /**
+     * @brief 加入新增的记录，并从新到旧补充最多 backfill 条文件记录
+     * @return 仍有文件记录未索引时返回 true
+     */
+    bool sync(size_t backfill = SIZE_MAX);
+
+    /**
+     * @brief 查找包含 query 的命令，同一命令只返回一次
+     *
+     * 在最近的 limit 条匹配中，以 query 开头的命令排在最前，其次是在词首匹配的命令，
+     * 同一档内按最近使用时间排序。query 为空时返回最近的命令。
+     */
+    std::vector<HistoryMatch> search(std::string_view query, size_t limit);
+
+    /**
+     * @brief 已索引的记录数与不同命令数
+     */
+    size_t indexedRecords() const { return appendedSeen_ + backfilled_; }
+    size_t distinctCommands() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        std::int32_t sequence;  // 最近一次出现的序号，越大越新
+        std::uint32_t uses;
+    };
+
+    const HistoryStore& store_;
+    bool started_ = false;
+    std::uint64_t generation_ = 0;
+    size_t appendedSeen_ = 0;    // 已索引的新增记录数
+    size_t backfilled_ = 0;      // 已补充的文件记录数（从新到旧）
+    bool backfillDone_ = false;
+
+    std::vector<Entry> entries_;                                     // 去重后的命令
+    std::unordered_map<std::uint64_t, std::uint32_t> byDigest_;      // 命令摘要 -> 命令编号
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> postings_;  // 三元组 -> 命令编号
+
+    void reset();
+    // 新增记录的序号从 1 递增，文件记录从 -1 向旧递减；换算为 recent() 的倒数位置
+    size_t back(std::int32_t sequence) const;
+    void index(std::string_view command, std::int32_t sequence);
+    void searchIndex(std::string_view query, size_t limit, bool caseSensitive,
+                     std::vector<HistoryMatch>& matches) const;
+    void scanUnindexed(std::string_view query, size_t limit, bool caseSensitive,
+                       std::vector<HistoryMatch>& matches) const;
+    std::vector<HistoryMatch> scanRecent(std::string_view query, size_t limit, bool caseSensitive);
+};
+
+} // namespace leizi
+
+#endif // LEIZI_HISTORY_HISTORY_SEARCH_H
@@ -0,0 +1,246 @@
+#include "history/history_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace leizi {
+
+namespace {
+
+bool sameRecord(const HistoryRecordView& view, const HistoryRecord& record) {
+    return view.startTime == record.startTime && view.sessionId == record.sessionId &&
+           view.durationMs == record.durationMs && view.exitCode == record.exitCode &&
+           view.command == record.command && view.cwd == record.cwd;
+}
+
+} // namespace
+
+HistoryStore::~HistoryStore() {
+    unmap();
+}
+
+void HistoryStore::unmap() {
+    if (map_) {
+        munmap(const_cast<char*>(map_), mapSize_);
+        map_ = nullptr;
+        mapSize_ = 0;
+    }
+    tailOffsets_.clear();
+    scanEnd_ = 0;
+    fullyIndexed_ = true;
+}
+
+void HistoryStore::clear() {
+    unmap();
+    records_.clear();
+    ++generation_;
+    path_.clear();
+    fileDev_ = 0;
+    fileIno_ = 0;
+    fileEnd_ = 0;
+    lastSeen_.reset();
+}
+
+bool HistoryStore::load(const std::string& path) {
+    clear();
+    path_ = path;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        fileDev_ = st.st_dev;
+        fileIno_ = st.st_ino;
+        return st.st_size == 0;
+    }
+    fileDev_ = st.st_dev;
+    fileIno_ = st.st_ino;
+
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    map_ = static_cast<const char*>(addr);
+    mapSize_ = static_cast<size_t>(st.st_size);
+    fileEnd_ = mapSize_;
+
+    if (!HistoryFormat::isBinary(mapped())) {
+        // 旧格式没有长度字段，无法从尾部定位，一次性解析
+        records_ = HistoryFormat::parse(mapped());
+        unmap();
+        if (!records_.empty()) {
+            lastSeen_ = records_.back();
+        }
+        return true;
+    }
+
+    scanEnd_ = mapSize_;
+    fullyIndexed_ = false;
+    // 文件尾部可能有写到一半的记录：此时退回到一次正向扫描
+    if (mapSize_ > HistoryFormat::MAGIC.size() && !HistoryFormat::previousRecord(mapped(), mapSize_)) {
+        std::vector<size_t> offsets;
+        fileEnd_ = HistoryFormat::validLength(mapped(), &offsets);
+        tailOffsets_.assign(offsets.rbegin(), offsets.rend());
+        fullyIndexed_ = true;
+    }
+
+    HistoryRecordView last;
+    if (recent(records_.size(), last)) {
+        lastSeen_ = last.toRecord();
+    }
+    return true;
+}
+
+void HistoryStore::indexBackward(size_t count) const {
+    while (!fullyIndexed_ && tailOffsets_.size() < count) {
+        auto start = HistoryFormat::previousRecord(mapped(), scanEnd_);
+        if (!start) {
+            fullyIndexed_ = true;
+            break;
+        }
+        tailOffsets_.push_back(*start);
+        scanEnd_ = *start;
+    }
+}
+
+void HistoryStore::add(HistoryRecord record) {
+    records_.push_back(std::move(record));
+}
+
+size_t HistoryStore::size() const {
+    indexBackward(static_cast<size_t>(-1));
+    return tailOffsets_.size() + records_.size();
+}
+
+bool HistoryStore::empty() const {
+    if (!records_.empty()) return false;
+    indexBackward(1);
+    return tailOffsets_.empty();
+}
+
+HistoryRecordView HistoryStore::at(size_t index) const {
+    indexBackward(static_cast<size_t>(-1));
+    const size_t mappedCount = tailOffsets_.size();
+    if (index >= mappedCount) {
+        return HistoryRecordView(records_[index - mappedCount]);
+    }
+
+    HistoryRecordView view;
+    HistoryFormat::decodeView(mapped(), tailOffsets_[mappedCount - 1 - index], view);
+    return view;
+}
+
+bool HistoryStore::recent(size_t n, HistoryRecordView& view) const {
+    if (n < records_.size()) {
+        view = HistoryRecordView(records_[records_.size() - 1 - n]);
+        return true;
+    }
+
+    const size_t fileIndex = n - records_.size();
+    indexBackward(fileIndex + 1);
+    if (fileIndex >= tailOffsets_.size()) {
+        return false;
+    }
+    return HistoryFormat::decodeView(mapped(), tailOffsets_[fileIndex], view);
+}
+
+size_t HistoryStore::importAppended(std::uint64_t skipSession) {
+    if (path_.empty()) {
+        return 0;
+    }
+
+    // 常见情况：文件没有变化，只需一次 stat
+    struct stat st {};
+    if (::stat(path_.c_str(), &st) != 0) {
+        return 0;
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    const bool replaced = st.st_dev != fileDev_ || st.st_ino != fileIno_ || size < fileEnd_;
+    if (!replaced && size == fileEnd_) {
+        return 0;
+    }
+
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return 0;
+    }
+    const auto mapLength = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, mapLength, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return 0;
+    }
+    const std::string_view content(static_cast<const char*>(addr), mapLength);
+    fileDev_ = st.st_dev;
+    fileIno_ = st.st_ino;
+
+    if (!HistoryFormat::isBinary(content)) {
+        munmap(addr, mapLength);
+        fileEnd_ = mapLength;
+        return 0;
+    }
+
+    size_t offset = replaced ? HistoryFormat::MAGIC.size() : fileEnd_;
+    if (replaced && lastSeen_) {
+        // 压缩丢弃最旧的记录并去重：从新文件尾部向前找到上次读到的最后一条。
+        // 它可能已被去重删掉，所以同时记下开始时间比它晚的最早一条，找不到时从那里导入；
+        // 遇到开始时间更早的记录就停止
+        size_t end = mapLength;
+        if (!HistoryFormat::previousRecord(content, end)) {
+            end = HistoryFormat::validLength(content);
+        }
+        offset = end;
+        for (auto start = HistoryFormat::previousRecord(content, end); start;
+             start = HistoryFormat::previousRecord(content, *start)) {
+            HistoryRecordView view;
+            if (!HistoryFormat::decodeView(content, *start, view)) {
+                break;
+            }
+            if (sameRecord(view, *lastSeen_)) {
+                offset = *start + HistoryFormat::recordSize(content, *start);
+                break;
+            }
+            if (view.startTime < lastSeen_->startTime) {
+                break;
+            }
+            if (view.startTime > lastSeen_->startTime) {
+                offset = *start;
+            }
+        }
+    }
+
+    size_t imported = 0;
+    std::optional<size_t> lastOffset;
+    while (size_t length = HistoryFormat::recordSize(content, offset)) {
+        HistoryRecordView view;
+        HistoryFormat::decodeView(content, offset, view);
+        if (view.sessionId != skipSession) {
+            records_.push_back(view.toRecord());
+            ++imported;
+        }
+        lastOffset = offset;
+        offset += length;
+    }
+    if (lastOffset) {
+        HistoryRecordView view;
+        HistoryFormat::decodeView(content, *lastOffset, view);
+        lastSeen_ = view.toRecord();
+    }
+    fileEnd_ = offset;
+
+    munmap(addr, mapLength);
+    return imported;
+}
+
+} // namespace leizi
@@ -0,0 +1,118 @@
+#ifndef LEIZI_HISTORY_HISTORY_STORE_H
+#define LEIZI_HISTORY_HISTORY_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+#include "history/history_record.h"
+
+namespace leizi {
+
+/**
+ * @brief 历史记录存储
+ *
+ * 启动时只 mmap 历史文件，不解析内容；记录偏移索引利用尾部长度字段
+ * 从文件末尾向前按需建立。读取最近的记录只触及文件尾部的页面，
+ * 百万条历史的启动时间与常驻内存都与历史规模无关。
+ * 旧的纯文本格式文件在加载时整体解析到内存中。
+ *
+ * 记录按时间顺序编号，0 为最旧的一条；加载之后新增的记录保存在内存中，排在文件记录之后。
+ * 返回的视图在下一次 add/load/clear 之前有效。
+ */
+class HistoryStore {
+public:
+    HistoryStore() = default;
+    ~HistoryStore();
+
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    /**
+     * @brief 映射历史文件，文件不存在时为空
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief 追加一条记录
+     */
+    void add(HistoryRecord record);
+
+    /**
+     * @brief 记录总数（首次调用时向前索引整个文件，只读取长度字段）
+     */
+    size_t size() const;
+    bool empty() const;
+
+    /**
+     * @brief 加载之后新增（含导入）的记录数，不触发文件索引
+     */
+    size_t appendedCount() const { return records_.size(); }
+
+    /**
+     * @brief 按时间顺序编号访问记录
+     */
+    HistoryRecordView at(size_t index) const;
+
+    /**
+     * @brief 访问倒数第 n 条记录（0 为最新），只索引到所需位置
+     * @return n 超出记录数时返回 false
+     */
+    bool recent(size_t n, HistoryRecordView& view) const;
+
+    /**
+     * @brief 清空所有记录并解除映射（不影响文件）
+     */
+    void clear();
+
+    /**
+     * @brief 导入其它会话在加载之后追加到文件中的记录
+     *
+     * 只读取上次导入位置之后新增的字节；文件被压缩替换时从新文件尾部向前
+     * 找到上次读到的最后一条记录，从其后继续，它已被去重删掉时导入开始时间
+     * 比它晚的记录。sessionId 为 skipSession 的记录
+     * （本会话自己写入的）被跳过。导入的记录追加在内存记录之后。
+     * @return 导入的记录数
+     */
+    size_t importAppended(std::uint64_t skipSession);
+
+    /**
+     * @brief 每次 load/clear 后递增，索引据此判断记录编号是否失效
+     */
+    std::uint64_t generation() const { return generation_; }
+
+private:
+    const char* map_ = nullptr;
+    size_t mapSize_ = 0;
+
+    // 文件记录的偏移，按从新到旧排列
+    mutable std::vector<size_t> tailOffsets_;
+    mutable size_t scanEnd_ = 0;          // 尚未索引部分的结束位置
+    mutable bool fullyIndexed_ = true;
+
+    std::vector<HistoryRecord> records_;  // 加载后新增的记录
+    std::uint64_t generation_ = 0;
+
+    // 增量导入：文件身份、已读到的位置与读到的最后一条记录
+    std::string path_;
+    dev_t fileDev_ = 0;
+    ino_t fileIno_ = 0;
+    size_t fileEnd_ = 0;
+    std::optional<HistoryRecord> lastSeen_;
+
+    std::string_view mapped() const { return std::string_view(map_, mapSize_); }
+
+    /**
+     * @brief 向前索引，直到至少有 count 条文件记录或到达文件头
+     */
+    void indexBackward(size_t count) const;
+    void unmap();
+};
+
+} // namespace leizi
+
+#endif // LEIZI_HISTORY_HISTORY_STORE_H
@@ -0,0 +1,179 @@
+#include "history/history_suggest.h"
+
+#include <algorithm>
+
+#include "history/history_record.h"
+
+namespace leizi {
+
+void HistorySuggest::reset() {
+    entries_.clear();
+    byDigest_.clear();
+    nodes_.clear();
+    nodes_.emplace_back();
+    appendedSeen_ = 0;
+    backfilled_ = 0;
+    backfillDone_ = false;
+}
+
+bool HistorySuggest::sync(size_t backfill) {
+    if (!started_ || generation_ != store_.generation()) {
+        reset();
+        started_ = true;
+        generation_ = store_.generation();
+    }
+
+    // 新增记录：recent(n) 在 n 小于新增数时不触及文件
+    HistoryRecordView view;
+    const size_t appended = store_.appendedCount();
+    for (; appendedSeen_ < appended; ++appendedSeen_) {
+        store_.recent(appended - 1 - appendedSeen_, view);
+        record(view.command, view.cwd, static_cast<std::int64_t>(appendedSeen_) + 1);
+    }
+
+    // 文件记录从新到旧补充；多看一条以便知道是否已经补完
+    for (size_t done = 0; !backfillDone_; ++done) {
+        if (!store_.recent(appended + backfilled_, view)) {
+            backfillDone_ = true;
+            break;
+        }
+        if (done == backfill) break;
+        ++backfilled_;
+        record(view.command, view.cwd, -static_cast<std::int64_t>(backfilled_));
+    }
+    return !backfillDone_;
+}
+
+void HistorySuggest::record(std::string_view command, std::string_view cwd, std::int64_t sequence) {
+    // 多行命令无法在输入行内显示
+    if (command.empty() || command.find('\n') != std::string_view::npos) {
+        return;
+    }
+
+    const std::uint64_t digest = commandDigest(command);
+    auto found = byDigest_.find(digest);
+    if (found != byDigest_.end() && entries_[found->second].command == command) {
+        Entry& entry = entries_[found->second];
+        // 补充索引的旧记录不覆盖已有的较新记录
+        if (sequence <= entry.sequence) {
+            return;
+        }
+        entry.sequence = sequence;
+        entry.cwdDigest = commandDigest(cwd);
+        insertPath(found->second);
+        return;
+    }
+
+    const auto id = static_cast<std::uint32_t>(entries_.size());
+    entries_.push_back(Entry{std::string(command), sequence, commandDigest(cwd)});
+    // 摘要冲突（不同命令）时新命令覆盖映射，旧命令仍留在树中
+    byDigest_[digest] = id;
+    insertPath(id);
+}
+
+std::uint32_t HistorySuggest::findChild(const Node& node, char c) const {
+    for (std::uint32_t child : node.children) {
+        if (nodes_[child].label.front() == c) return child;
+    }
+    return 0;
+}
+
+void HistorySuggest::promote(Node& node, std::uint32_t entry) {
+    auto begin = node.best.begin();
+    auto end = begin + node.bestCount;
+    auto existing = std::find(begin, end, entry);
+    if (existing != end) {
+        std::copy(existing + 1, end, existing);
+        --end;
+        --node.bestCount;
+    }
+
+    const std::int64_t sequence = entries_[entry].sequence;
+    auto at = std::find_if(begin, end, [&](std::uint32_t id) { return entries_[id].sequence < sequence; });
+    if (at == end && node.bestCount == CANDIDATES) {
+        return;
+    }
+    if (node.bestCount == CANDIDATES) {
+        --end;
+    } else {
+        ++node.bestCount;
+    }
+    std::copy_backward(at, end, end + 1);
+    *at = entry;
+}
+
+void HistorySuggest::insertPath(std::uint32_t entry) {
+    // 节点池可能扩容，只保存下标
+    std::string_view rest = entries_[entry].command;
+    std::uint32_t current = 0;
+    promote(nodes_[current], entry);
+
+    while (!rest.empty()) {
+        std::uint32_t child = findChild(nodes_[current], rest.front());
+        if (child == 0) {
+            Node leaf;
+            leaf.label = std::string(rest);
+            nodes_.push_back(std::move(leaf));
+            child = static_cast<std::uint32_t>(nodes_.size() - 1);
+            nodes_[current].children.push_back(child);
+            promote(nodes_[child], entry);
+            return;
+        }
+
+        const std::string& label = nodes_[child].label;
+        const size_t limit = std::min(label.size(), rest.size());
+        size_t common = 1;
+        while (common < limit && label[common] == rest[common]) ++common;
+
+        if (common < label.size()) {
+            // 拆分边：中间节点继承原子节点的候选
+            Node middle;
+            middle.label = label.substr(0, common);
+            middle.children.push_back(child);
+            middle.best = nodes_[child].best;
+            middle.bestCount = nodes_[child].bestCount;
+            nodes_[child].label.erase(0, common);
+
+            nodes_.push_back(std::move(middle));
+            const auto split = static_cast<std::uint32_t>(nodes_.size() - 1);
+            auto& siblings = nodes_[current].children;
+            *std::find(siblings.begin(), siblings.end(), child) = split;
+            child = split;
+        }
+
+        promote(nodes_[child], entry);
+        rest.remove_prefix(common);
+        current = child;
+    }
+}
+
+std::string_view HistorySuggest::suggest(std::string_view prefix, std::string_view cwd) const {
+    if (prefix.empty() || nodes_.empty()) {
+        return {};
+    }
+
+    std::uint32_t current = 0;
+    std::string_view rest = prefix;
+    while (!rest.empty()) {
+        const std::uint32_t child = findChild(nodes_[current], rest.front());
+        if (child == 0) return {};
+        const std::string& label = nodes_[child].label;
+        const size_t length = std::min(label.size(), rest.size());
+        if (rest.compare(0, length, label, 0, length) != 0) return {};
+        rest.remove_prefix(length);
+        current = child;
+    }
+
+    const Node& node = nodes_[current];
+    const std::uint64_t here = commandDigest(cwd);
+    std::string_view fallback;
+    for (std::uint8_t i = 0; i < node.bestCount; ++i) {
+        const Entry& entry = entries_[node.best[i]];
+        if (entry.command.size() <= prefix.size()) continue;
+        if (entry.cwdDigest == here) return entry.command;
+        if (fallback.empty()) fallback = entry.command;
+    }
+    return fallback;
+}
+
+} // namespace leizi
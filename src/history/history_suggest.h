@@ -0,0 +1,80 @@
+#ifndef LEIZI_HISTORY_HISTORY_SUGGEST_H
+#define LEIZI_HISTORY_HISTORY_SUGGEST_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "history/history_store.h"
+
+namespace leizi {
+
+/**
+ * @brief 基于历史的输入建议（fish 风格）
+ *
+ * 去重后的命令组成一棵基数树，每个节点保存子树中最近使用的 CANDIDATES 条命令。
+ * 查询只沿输入前缀走到对应节点，再在候选中优先选择上次在当前目录执行的命令，
+ * 耗时只与输入长度有关，与历史规模无关。
+ *
+ * 新记录在 sync 时加入；加载时已有的旧记录从新到旧分批补充索引，
+ * 可以放在空闲时（readline 的事件钩子）进行，不拖慢启动。
+ */
+class HistorySuggest {
+public:
+    static constexpr size_t CANDIDATES = 8;
+
+    explicit HistorySuggest(const HistoryStore& store) : store_(store) {}
+
+    /**
+     * @brief 索引新增的记录，并从新到旧补充最多 backfill 条旧记录
+     * @return 还有尚未索引的旧记录时返回 true
+     */
+    bool sync(size_t backfill);
+
+    /**
+     * @brief 以 prefix 开头、比 prefix 更长的最佳命令
+     * @return 没有建议时返回空；结果在下一次 sync 之前有效
+     */
+    std::string_view suggest(std::string_view prefix, std::string_view cwd) const;
+
+    size_t distinctCommands() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        std::string command;
+        std::int64_t sequence;    // 越大越新：加载后新增的记录为正，文件中的旧记录为负
+        std::uint64_t cwdDigest;  // 最近一次执行时的工作目录
+    };
+
+    struct Node {
+        std::string label;                  // 从父节点到本节点的边
+        std::vector<std::uint32_t> children;
+        std::array<std::uint32_t, CANDIDATES> best {};  // 按 sequence 从新到旧
+        std::uint8_t bestCount = 0;
+    };
+
+    const HistoryStore& store_;
+    std::uint64_t generation_ = 0;
+    bool started_ = false;
+    size_t appendedSeen_ = 0;     // 已索引的新增记录数
+    size_t backfilled_ = 0;       // 已补充索引的文件记录数（从最新一条算起）
+    bool backfillDone_ = false;
+
+    std::vector<Entry> entries_;
+    std::unordered_map<std::uint64_t, std::uint32_t> byDigest_;
+    std::vector<Node> nodes_;     // nodes_[0] 为根
+
+    void reset();
+    void record(std::string_view command, std::string_view cwd, std::int64_t sequence);
+    void insertPath(std::uint32_t entry);
+    void promote(Node& node, std::uint32_t entry);
+    std::uint32_t findChild(const Node& node, char c) const;
+};
+
+} // namespace leizi
+
+#endif // LEIZI_HISTORY_HISTORY_SUGGEST_H
@@ -21,6 +21,7 @@
 #include <memory>
 #include <sstream>
 #include <algorithm>
+#include <numeric>
 #include <cctype>
 #include <cstdlib>
 #include <unistd.h>
@@ -34,6 +35,13 @@
 #include <optional>
 #include <signal.h>
 #include <fcntl.h>
+#include <sys/ioctl.h>
+#include <ctime>
+#include <random>
+#include <poll.h>
+#include <spawn.h>
+#include <cerrno>
+#include <cstring>
 
 // 版本信息
 #define LEIZI_VERSION_MAJOR 1
@@ -63,12 +71,23 @@
 
 #include "utils/colors.h"
 #include "utils/variables.h"
+#include "utils/arithmetic.h"
 #include "prompt/prompt.h"
 #include "core/parser.h"
+#include "core/command_stats.h"
+#include "core/redirection.h"
+#include "core/capture.h"
+#include "core/glob.h"
+#include "core/brace.h"
 #include "builtin/builtin_manager.h"
 #include "completion/completer.h"
 #include "config/config.h"
 #include "syntax/highlighter.h"
+#include "history/history_file.h"
+#include "history/history_store.h"
+#include "history/history_search.h"
+#include "history/history_suggest.h"
+#include "history/history_list.h"
 
 using namespace leizi;
 
@@ -88,6 +107,305 @@ static void signalHandler(int signal) {
     }
 }
 
+#if HAVE_READLINE
+// Ctrl-R 历史搜索（由 LeiziShell 设置索引）
+static HistorySearch* g_historySearch = nullptr;
+
+// 输入行装饰：语法高亮与历史建议（由 LeiziShell 设置，为空表示关闭）
+static SyntaxHighlighter* g_lineHighlighter = nullptr;
+static HistorySuggest* g_historySuggest = nullptr;
+static const std::string* g_suggestDirectory = nullptr;
+static bool g_suggestionHidden = false;
+
+namespace {
+
+constexpr size_t SEARCH_LIST_SIZE = 8;
+
+// 输入中是否还有待读的字节，用于区分单独的 ESC 与方向键序列
+bool inputPending(int timeoutMs) {
+    struct pollfd pfd {};
+    pfd.fd = fileno(rl_instream ? rl_instream : stdin);
+    pfd.events = POLLIN;
+    return poll(&pfd, 1, timeoutMs) > 0;
+}
+
+int searchColumns() {
+    struct winsize ws {};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+        return ws.ws_col;
+    }
+    return 80;
+}
+
+// 截断为单行显示，不在 UTF-8 字符中间截断
+std::string displayLine(std::string_view text, size_t width) {
+    std::string line;
+    size_t shown = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if ((c & 0xC0) != 0x80) {
+            if (shown == width) break;
+            ++shown;
+        }
+        line += (c == '\n' || c == '\t') ? ' ' : static_cast<char>(c);
+    }
+    return line;
+}
+
+size_t displayWidth(std::string_view text) {
+    return static_cast<size_t>(std::count_if(text.begin(), text.end(),
+                                             [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; }));
+}
+
+// 在当前行绘制搜索栏，下方列出排好序的候选，光标停在查询末尾
+void drawSearch(const std::string& query, const std::vector<HistoryMatch>& matches, size_t selected) {
+    const size_t columns = static_cast<size_t>(searchColumns());
+    const std::string label = matches.empty() && !query.empty() ? "(failed reverse-search)`" : "(reverse-search)`";
+
+    std::string out = "\r\033[J" + Color::DIM + label + Color::RESET + query + Color::DIM + "'" + Color::RESET;
+    for (size_t i = 0; i < matches.size(); ++i) {
+        out += "\r\n";
+        out += i == selected ? Color::BOLD + Color::CYAN + "❯ " : "  ";
+        out += displayLine(matches[i].command, columns > 3 ? columns - 3 : 1);
+        out += Color::RESET;
+    }
+    if (!matches.empty()) {
+        out += "\033[" + std::to_string(matches.size()) + "A";
+    }
+    const size_t cursor = displayWidth(label) + displayWidth(query);
+    out += "\r";
+    if (cursor > 0) {
+        out += "\033[" + std::to_string(std::min(cursor, columns - 1)) + "C";
+    }
+    fputs(out.c_str(), rl_outstream ? rl_outstream : stdout);
+    fflush(rl_outstream ? rl_outstream : stdout);
+}
+
+// 清除搜索界面，由 readline 在原位置重绘提示符与输入行
+void finishSearch(const std::string& line) {
+    fputs("\r\033[J", rl_outstream ? rl_outstream : stdout);
+    rl_replace_line(line.c_str(), 0);
+    rl_point = rl_end;
+    rl_on_new_line();
+    rl_redisplay();
+}
+
+void popUtf8(std::string& text) {
+    while (!text.empty()) {
+        const unsigned char c = static_cast<unsigned char>(text.back());
+        text.pop_back();
+        if ((c & 0xC0) != 0x80) break;
+    }
+}
+
+/**
+ * 替代 readline 的线性反向搜索：以当前输入为初始查询，列出排好序的匹配。
+ * Enter 执行，Tab/→ 放入输入行继续编辑，Ctrl-R/↓ 与 Ctrl-P/↑ 切换候选，Esc/Ctrl-G 取消。
+ */
+int reverseSearch(int, int) {
+    if (!g_historySearch) {
+        return 0;
+    }
+
+    const std::string original(rl_line_buffer, static_cast<size_t>(rl_end));
+    std::string query = original;
+    size_t selected = 0;
+
+    // 先让 readline 清掉可能折行的输入，搜索栏只占提示符最后一行
+    rl_replace_line("", 0);
+    rl_redisplay();
+
+    auto matches = g_historySearch->search(query, SEARCH_LIST_SIZE);
+    auto selection = [&]() { return matches.empty() ? query : std::string(matches[selected].command); };
+
+    while (true) {
+        drawSearch(query, matches, selected);
+        int c = rl_read_key();
+
+        if (c == 27 && inputPending(30)) {
+            // 方向键：ESC [ A / ESC O A
+            int next = rl_read_key();
+            if (next == '[' || next == 'O') {
+                next = rl_read_key();
+            }
+            if (next == 'A') c = 16;
+            else if (next == 'B') c = 14;
+            else if (next == 'C' || next == 'D') c = '\t';
+            else continue;
+        }
+
+        if (c == '\r' || c == '\n') {
+            finishSearch(selection());
+            rl_newline(1, c);
+            return 0;
+        }
+        if (c == '\t' || c == 5 || c == 6) {           // Tab、Ctrl-E、Ctrl-F
+            finishSearch(selection());
+            return 0;
+        }
+        if (c < 0 || c == 27 || c == 7 || c == 3) {    // EOF、Esc、Ctrl-G、Ctrl-C
+            finishSearch(original);
+            return 0;
+        }
+        if (c == 18 || c == 14) {                      // Ctrl-R、Ctrl-N：更旧的候选
+            if (!matches.empty()) selected = (selected + 1) % matches.size();
+            continue;
+        }
+        if (c == 16 || c == 19) {                      // Ctrl-P、Ctrl-S：更新的候选
+            if (!matches.empty()) selected = (selected + matches.size() - 1) % matches.size();
+            continue;
+        }
+
+        if (c == 127 || c == 8) {
+            popUtf8(query);
+        } else if (c == 21) {                          // Ctrl-U
+            query.clear();
+        } else if (c >= 32) {
+            query += static_cast<char>(c);
+        } else {
+            // 其它控制键：接受当前候选，再交给 readline 处理
+            finishSearch(selection());
+            rl_execute_next(c);
+            return 0;
+        }
+        matches = g_historySearch->search(query, SEARCH_LIST_SIZE);
+        selected = 0;
+    }
+}
+
+// 启动时索引的最近记录数；之后在等待输入时分批补充，有按键时最多等待一批
+constexpr size_t SUGGEST_STARTUP_RECORDS = 10000;
+constexpr size_t SUGGEST_BACKFILL_BATCH = 256;
+constexpr auto SUGGEST_BACKFILL_SLICE = std::chrono::milliseconds(50);
+// Ctrl-R 的三元组索引从新到旧分批补充，每批约 0.2 毫秒
+constexpr size_t SEARCH_BACKFILL_BATCH = 256;
+
+// 提示符最后一行的显示宽度（跳过 \001..\002 与 ANSI 转义序列）
+size_t promptWidth(const char* prompt) {
+    if (!prompt) return 0;
+    std::string_view text(prompt);
+    const size_t newline = text.rfind('\n');
+    if (newline != std::string_view::npos) {
+        text.remove_prefix(newline + 1);
+    }
+
+    size_t width = 0;
+    bool ignored = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (c == '\001') {
+            ignored = true;
+        } else if (c == '\002') {
+            ignored = false;
+        } else if (c == '\033') {
+            // CSI 序列到终止字母为止
+            if (i + 1 < text.size() && text[i + 1] == '[') {
+                i += 2;
+                while (i < text.size() && !(text[i] >= '@' && text[i] <= '~')) ++i;
+            }
+        } else if (!ignored && (static_cast<unsigned char>(c) & 0xC0) != 0x80) {
+            ++width;
+        }
+    }
+    return width;
+}
+
+// 当前输入对应的建议后缀，光标不在行尾时不显示
+std::string_view suggestionSuffix() {
+    if (!g_historySuggest || g_suggestionHidden || rl_end == 0 || rl_point != rl_end) {
+        return {};
+    }
+    const std::string_view line(rl_line_buffer, static_cast<size_t>(rl_end));
+    const std::string_view command = g_historySuggest->suggest(line, *g_suggestDirectory);
+    return command.empty() ? command : command.substr(line.size());
+}
+
+// readline 重绘钩子：先按原样绘制，输入只占一行时再用高亮后的文本覆盖，
+// 并在行尾用灰色显示建议。可见字符不变，readline 记录的屏幕内容仍然有效
+void decoratedRedisplay() {
+    rl_redisplay();
+
+    const std::string_view line(rl_line_buffer, static_cast<size_t>(rl_end));
+    if (std::any_of(line.begin(), line.end(),
+                    [](char c) { return static_cast<unsigned char>(c) < 0x20 || c == 0x7f; })) {
+        return;  // 控制字符由 readline 显示为 ^X，宽度对不上
+    }
+
+    const size_t columns = static_cast<size_t>(searchColumns());
+    const size_t start = promptWidth(rl_display_prompt);
+    const size_t lineWidth = displayWidth(line);
+    if (start + lineWidth + 1 >= columns) {
+        return;  // 跨行时交给 readline 原样显示
+    }
+
+    const size_t point = displayWidth(line.substr(0, static_cast<size_t>(rl_point)));
+    std::string out;
+    if (point > 0) {
+        out += "\033[" + std::to_string(point) + "D";
+    }
+    out += g_lineHighlighter ? g_lineHighlighter->highlight(std::string(line)) : std::string(line);
+
+    size_t cursor = lineWidth;
+    const std::string_view suffix = suggestionSuffix();
+    if (!suffix.empty()) {
+        const std::string shown = displayLine(suffix, columns - start - lineWidth - 1);
+        out += Color::BRIGHT_BLACK + shown + Color::RESET;
+        cursor += displayWidth(shown);
+    }
+    // 清掉上一次绘制留下的建议
+    out += "\033[K";
+    if (cursor > point) {
+        out += "\033[" + std::to_string(cursor - point) + "D";
+    }
+
+    FILE* stream = rl_outstream ? rl_outstream : stdout;
+    fputs(out.c_str(), stream);
+    fflush(stream);
+}
+
+int resetLineDecoration() {
+    g_suggestionHidden = false;
+    return 0;
+}
+
+// 回车：先去掉建议再提交，避免灰色文本留在屏幕上
+int acceptLine(int count, int key) {
+    g_suggestionHidden = true;
+    (*rl_redisplay_function)();
+    return rl_newline(count, key);
+}
+
+// 右方向键 / Ctrl-F：光标在行尾时接受建议，否则照常右移
+int acceptSuggestion(int count, int key) {
+    const std::string_view suffix = suggestionSuffix();
+    if (suffix.empty()) {
+        return rl_forward_char(count, key);
+    }
+    rl_insert_text(std::string(suffix).c_str());
+    rl_point = rl_end;
+    return 0;
+}
+
+// 等待输入时分批补充 Ctrl-R 与建议的索引，一有输入就让出；全部索引后不再轮询
+int backfillIndexes() {
+    const auto deadline = std::chrono::steady_clock::now() + SUGGEST_BACKFILL_SLICE;
+    while (true) {
+        const bool search = g_historySearch && g_historySearch->sync(SEARCH_BACKFILL_BATCH);
+        const bool suggest = g_historySuggest && g_historySuggest->sync(SUGGEST_BACKFILL_BATCH);
+        if (!search && !suggest) {
+            rl_event_hook = nullptr;
+            break;
+        }
+        if (inputPending(0) || std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+#endif
+
 // 作业状态枚举
 enum class JobStatus {
     RUNNING,    // 正在运行
@@ -119,12 +437,21 @@ private:
     std::unique_ptr<SmartCompleter> completer;  // 智能补全器
     ConfigManager configManager;    // 配置管理器
     std::unique_ptr<SyntaxHighlighter> highlighter;  // 语法高亮器
-    std::vector<std::string> commandHistory;
+    HistoryList commandHistory;      // 去重后的命令列表（readline 导航与补全）
     std::string currentDirectory;
     std::string homeDirectory;
     int lastExitCode = 0;
+    CommandTimer commandTimer;       // 上一条命令的耗时与资源占用
+    std::uint64_t commandNumber = 0; // 已执行的命令数，用于提示符缓存
     bool exitRequested = false;
     std::string historyFile;
+    std::unique_ptr<HistoryFile> historyWriter;  // 执行时逐条追加历史
+    HistoryStore historyStore;                   // 带时间、耗时、退出码与目录的历史记录
+    HistorySearch historySearch {historyStore};  // Ctrl-R 使用的三元组索引
+    HistorySuggest historySuggest {historyStore};  // 输入建议使用的前缀索引
+    ArithmeticEngine arithmetic;                 // $(( )) 与 let 共用的表达式缓存
+    std::uint64_t sessionId = 0;                 // 本会话的标识，写入每条历史记录
+    bool shareHistory = false;                   // [history] share：导入其它会话的命令
 
     // 作业控制相关
     std::vector<Job> jobs;           // 作业列表
@@ -146,40 +473,174 @@ private:
         return input;
     }
 
-    // 加载命令历史
+    // 加载命令历史（兼容旧的纯文本格式）。
+    // 历史文件只做映射，readline 导航与命令列表只取尾部最新的 [history] size 条
     void loadHistory() {
         historyFile = homeDirectory + "/.leizi_history";
-        std::ifstream file(historyFile);
-        std::string line;
+        historyStore.load(historyFile);
 
-        while (std::getline(file, line) && commandHistory.size() < 1000) {
-            if (!line.empty()) {
-                commandHistory.push_back(line);
-                #if HAVE_READLINE
-                add_history(line.c_str());
-                #endif
+        HistoryRecordView view;
+        const size_t limit = historySize();
+        size_t tail = 0;
+        while (tail < limit && historyStore.recent(tail, view)) {
+            ++tail;
+        }
+        for (size_t n = tail; n > 0; --n) {
+            historyStore.recent(n - 1, view);
+            rememberCommand(std::string(view.command));
+        }
+
+        std::random_device random;
+        sessionId = (static_cast<std::uint64_t>(random()) << 32) ^ random() ^ static_cast<std::uint64_t>(getpid());
+
+        historyWriter = std::make_unique<HistoryFile>(historyFile);
+    }
+
+    // [history] size：历史文件保留的条数，也是启动时载入命令列表的条数
+    size_t historySize() const {
+        return static_cast<size_t>(std::max(1, configManager.getInt("history", "size").value_or(10000)));
+    }
+
+    // 加入去重的命令列表，并同步 readline 的历史
+    void rememberCommand(const std::string& command) {
+        HistoryList::AddResult result = commandHistory.add(command);
+        if (result == HistoryList::AddResult::Ignored) {
+            return;
+        }
+        #if HAVE_READLINE
+        if (result == HistoryList::AddResult::Moved) {
+            // readline 的历史是数组，只能线性删除；重复的命令通常就在末尾附近
+            for (int i = history_length - 1; i >= 0; --i) {
+                HIST_ENTRY* entry = history_get(history_base + i);
+                if (entry && command == entry->line) {
+                    free_history_entry(remove_history(i));
+                    break;
+                }
             }
         }
+        add_history(command.c_str());
+        #endif
     }
 
-    // 保存命令历史
-    void saveHistory() {
-        std::ofstream file(historyFile);
-        size_t start = commandHistory.size() > 1000 ? commandHistory.size() - 1000 : 0;
+    // 执行一条命令并记录历史：命令列表立即更新，带耗时与退出码的记录在完成后写入文件。
+    // 以空格开头的命令在 ignore_space 打开时不记录
+    void executeAndRecord(const std::string& input) {
+        if (commandHistory.ignored(input)) {
+            executeInput(input);
+            return;
+        }
+        rememberCommand(input);
+
+        HistoryRecord record;
+        record.command = input;
+        record.cwd = currentDirectory;
+        record.sessionId = sessionId;
+        record.startTime = static_cast<std::int64_t>(std::time(nullptr));
+
+        executeInput(input);
+
+        record.durationMs = static_cast<std::uint32_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(commandTimer.stats().wallTime).count());
+        record.exitCode = lastExitCode;
+        if (historyWriter) {
+            historyWriter->append(record);
+        }
+        historyStore.add(std::move(record));
+    }
+
+    // 共享历史：显示提示符前导入其它会话新追加的命令
+    void importSharedHistory() {
+        if (!shareHistory) {
+            return;
+        }
+        size_t imported = historyStore.importAppended(sessionId);
+        HistoryRecordView view;
+        for (size_t n = imported; n > 0; --n) {
+            historyStore.recent(n - 1, view);
+            rememberCommand(std::string(view.command));
+        }
+    }
+
+    #if HAVE_READLINE
+    // 按 [completion] 配置安装高亮与建议的重绘钩子（仅交互终端）
+    void setupLineDecoration() {
+        if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+            return;
+        }
+        const bool highlight = configManager.getBool("completion", "highlight").value_or(true);
+        const bool suggest = configManager.getBool("completion", "autosuggest").value_or(true);
+        if (!highlight && !suggest) {
+            return;
+        }
 
-        for (size_t i = start; i < commandHistory.size(); ++i) {
-            file << commandHistory[i] << "\n";
+        g_lineHighlighter = highlight ? highlighter.get() : nullptr;
+        if (suggest) {
+            // 启动时只索引最近的记录，其余在等待输入时补充
+            g_historySuggest = &historySuggest;
+            g_suggestDirectory = &currentDirectory;
+            if (historySuggest.sync(SUGGEST_STARTUP_RECORDS)) {
+                rl_event_hook = backfillIndexes;
+            }
+            rl_bind_keyseq("\\e[C", acceptSuggestion);
+            rl_bind_keyseq("\\eOC", acceptSuggestion);
+            rl_bind_keyseq("\\C-f", acceptSuggestion);
+            rl_bind_key('\r', acceptLine);
+            rl_bind_key('\n', acceptLine);
+            rl_startup_hook = resetLineDecoration;
         }
+        rl_redisplay_function = decoratedRedisplay;
     }
+    #endif
 
-    std::string generatePrompt() const {
+    const std::string& generatePrompt() {
         PromptContext context;
         context.currentDirectory = currentDirectory;
         context.homeDirectory = homeDirectory;
         context.lastExitCode = lastExitCode;
+        context.columns = terminalColumns();
+        context.commandNumber = commandNumber;
+        context.lastCommand = &commandTimer.stats();
         return promptGenerator.generate(context);
     }
 
+    // 获取终端宽度，非终端时返回 0
+    static int terminalColumns() {
+        struct winsize ws {};
+        if (isatty(STDOUT_FILENO) && ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+            return ws.ws_col;
+        }
+        return 0;
+    }
+
+    // 瞬态提示符：命令提交后把上一个提示符折叠为简短标记
+    void collapsePrompt(const std::string& input) {
+        if (!promptGenerator.options().transient || !isatty(STDOUT_FILENO)) {
+            return;
+        }
+        std::string redraw = promptGenerator.transientLine(input);
+        if (!redraw.empty()) {
+            std::cout << redraw << std::flush;
+        }
+    }
+
+    // 根据 [prompt] 配置设置提示符段落
+    void applyPromptConfig() {
+        PromptOptions options;
+        options.showUser = configManager.getBool("prompt", "show_user").value_or(true);
+        options.showGit = configManager.getBool("prompt", "show_git").value_or(true);
+        options.showTime = configManager.getBool("prompt", "show_time").value_or(true);
+        options.symbol = configManager.getString("prompt", "symbol").value_or("❯");
+        options.multiline = configManager.getBool("prompt", "multiline").value_or(true);
+        options.rightPrompt = configManager.getBool("prompt", "right_prompt").value_or(false);
+        options.transient = configManager.getBool("prompt", "transient").value_or(false);
+        options.transientSymbol = configManager.getString("prompt", "transient_symbol").value_or(options.symbol);
+        options.durationThresholdMs = configManager.getInt("prompt", "duration_threshold").value_or(2000);
+        #if HAVE_READLINE
+        options.readlineMarkers = true;
+        #endif
+        promptGenerator.setOptions(options);
+    }
+
     // 自动补全功能 (使用SmartCompleter)
     std::vector<std::string> getCompletions(const std::string& input) const {
         if (!completer) {
@@ -189,7 +650,7 @@ private:
     }
 
     // 变量展开
-    std::string expandVariables(const std::string& str) const {
+    std::string expandVariables(const std::string& str) {
         return variables.expand(str, [&](const std::string& varName) -> std::optional<std::string> {
             if (varName == "?") {
                 return std::to_string(lastExitCode);
@@ -207,9 +668,297 @@ private:
                 return std::string(env);
             }
             return std::nullopt;
+        }, [this](const std::string& command) { return substituteCommand(command); },
+        [this](const std::string& expression) {
+            std::int64_t value = 0;
+            return evaluateArithmetic(expandVariables(expression), value) ? std::to_string(value) : std::string();
         });
     }
 
+    // 求值算术表达式，出错时输出错误并把 $? 设为 1
+    bool evaluateArithmetic(const std::string& expression, std::int64_t& value) {
+        std::string error;
+        if (!arithmetic.evaluate(expression, variables, value, error)) {
+            std::cerr << "leizi: " << expression << ": " << error << std::endl;
+            lastExitCode = 1;
+            return false;
+        }
+        return true;
+    }
+
+    // ((expr)) 复合命令：值不为 0 时退出码为 0
+    bool executeArithmeticCommand(const std::string& input) {
+        const size_t first = input.find_first_not_of(" \t");
+        const size_t last = input.find_last_not_of(" \t\n");
+        if (first == std::string::npos || input.compare(first, 2, "((") != 0 || last < first + 3 ||
+            input.compare(last - 1, 2, "))") != 0) {
+            return false;
+        }
+        std::int64_t value = 0;
+        if (evaluateArithmetic(expandVariables(input.substr(first + 2, last - 1 - (first + 2))), value)) {
+            lastExitCode = value != 0 ? 0 : 1;
+        }
+        return true;
+    }
+
+    // 展开外部命令的参数；单独的 ${arr[@]} 或 ${arr[i,j]} 展开为多个参数，元素直接从数组复制
+    std::vector<std::string> expandArguments(const std::vector<std::string>& args) {
+        std::vector<std::string> expanded;
+        expanded.reserve(args.size());
+        for (const auto& arg : args) {
+            if (!variables.expandArray(arg, expanded)) {
+                expanded.push_back(expandVariables(arg));
+            }
+        }
+        return expanded;
+    }
+
+    // 参数总长度的上限：ARG_MAX 减去环境变量占用的部分
+    static size_t argumentBudget() {
+        long limit = sysconf(_SC_ARG_MAX);
+        size_t budget = limit > 0 ? static_cast<size_t>(limit) : 128 * 1024;
+        for (char** env = environ; *env != nullptr; ++env) {
+            const size_t used = strlen(*env) + 1 + sizeof(char*);
+            budget = budget > used ? budget - used : 0;
+        }
+        return budget;
+    }
+
+    // 解析管道并按 bash 的顺序展开未加引号的大括号与通配符（重定向目标除外）。
+    // 大括号展开逐个生成单词，累计长度超过 ARG_MAX 时立即停止并报错，不会先生成完整的列表。
+    // 含通配符的单词在这里完成全部展开并标记（见 expandPathname），其余单词留给执行时展开
+    bool parseAndExpand(const std::string& input, std::vector<std::vector<std::string>>& pipeline) {
+        std::vector<std::vector<unsigned char>> expansions;
+        pipeline = commandParser.parsePipeline(input, &expansions);
+        const size_t budget = argumentBudget();
+
+        for (size_t stage = 0; stage < pipeline.size(); ++stage) {
+            auto& args = pipeline[stage];
+            const auto& flags = expansions[stage];
+            if (std::all_of(flags.begin(), flags.end(), [](unsigned char f) { return f == 0; })) {
+                continue;
+            }
+
+            std::vector<std::string> words;
+            words.reserve(args.size());
+            size_t used = 0;
+            bool overflow = false;
+            auto add = [&](std::string word) {
+                used += word.size() + 1 + sizeof(char*);
+                overflow = overflow || used > budget;
+                if (!overflow) words.push_back(std::move(word));
+            };
+            const auto expand = [this](const std::string& word) { return expandVariables(word); };
+            auto addGlobbed = [&](std::string word, bool glob) {
+                if (glob) {
+                    expandPathname(word, expand, add);
+                } else {
+                    add(std::move(word));
+                }
+            };
+
+            for (size_t i = 0; i < args.size() && !overflow; ++i) {
+                const bool glob = flags[i] & WORD_GLOB;
+                if (i > 0 && RedirectionPlan::isOperator(args[i - 1])) {
+                    // 重定向目标不做路径名展开，去掉分词时加的模式转义
+                    add(glob ? GlobPattern::unescape(args[i]) : std::move(args[i]));
+                    continue;
+                }
+                if (flags[i] == 0) {
+                    add(std::move(args[i]));
+                    continue;
+                }
+                if (flags[i] & WORD_BRACE) {
+                    BraceExpansion braces(args[i]);
+                    if (braces.expands()) {
+                        std::string word;
+                        while (!overflow && braces.next(word)) addGlobbed(word, glob);
+                        continue;
+                    }
+                }
+                addGlobbed(std::move(args[i]), glob);
+            }
+
+            if (overflow) {
+                std::cerr << "leizi: " << (words.empty() ? args[0] : words[0]) << ": argument list too long"
+                          << std::endl;
+                lastExitCode = 126;
+                pipeline.clear();
+                return false;
+            }
+            args = std::move(words);
+        }
+        return true;
+    }
+
+    // 可以在 shell 进程内执行的内建命令：没有副作用，替换结果与在子 shell 中执行相同
+    static bool isCapturableBuiltin(const std::string& name) {
+        return name == "echo" || name == "pwd";
+    }
+
+    // 命令替换 $(...) / `...`：返回标准输出并去掉末尾换行，$? 为命令的退出码。
+    // 纯内建命令在进程内执行，单个外部命令用 posix_spawn 直接把标准输出接到管道，
+    // 其余（管道、其它内建命令）在 fork 出的子 shell 中执行
+    std::string substituteCommand(const std::string& command) {
+        std::string output;
+        std::vector<std::vector<std::string>> pipeline;
+        if (!parseAndExpand(command, pipeline) || pipeline.empty()) {
+            return output;
+        }
+
+        std::vector<std::string>& args = pipeline[0];
+        const bool single = pipeline.size() == 1 && !configManager.getAlias(args[0]);
+        if (single && isCapturableBuiltin(args[0]) &&
+            std::none_of(args.begin(), args.end(), RedirectionPlan::isOperator)) {
+            {
+                ScopedOutputCapture capture(std::cout, output);
+                executeBuiltin(args);
+            }
+            trimTrailingNewlines(output);
+            return output;
+        }
+
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) < 0) {
+            perror("leizi: pipe");
+            lastExitCode = 1;
+            return output;
+        }
+
+        pid_t pid = -1;
+        if (single && !builtinManager.isBuiltin(args[0]) && args[0] != "jobs" && args[0] != "fg" && args[0] != "bg") {
+            RedirectionPlan plan;
+            if (!prepareRedirections(args, plan) || args.empty()) {
+                close(fds[0]);
+                close(fds[1]);
+                return output;
+            }
+            std::vector<std::string> expandedArgs = expandArguments(args);
+            std::vector<char*> argv;
+            for (auto& arg : expandedArgs) {
+                argv.push_back(arg.data());
+            }
+            argv.push_back(nullptr);
+
+            int spawnError = 0;
+            pid = spawnCommand(argv, plan, spawnError, fds[1]);
+            if (spawnError == ENOENT) {
+                std::cerr << "leizi: " << argv[0] << ": command not found" << std::endl;
+                lastExitCode = 127;
+                close(fds[0]);
+                close(fds[1]);
+                return output;
+            }
+        }
+
+        if (pid < 0) {
+            std::cout.flush();
+            pid = fork();
+            if (pid == 0) {
+                signal(SIGINT, SIG_DFL);
+                signal(SIGTSTP, SIG_DFL);
+                dup2(fds[1], STDOUT_FILENO);
+                close(fds[0]);
+                close(fds[1]);
+                executePipeline(pipeline);
+                std::cout.flush();
+                exit(lastExitCode);
+            }
+        }
+        close(fds[1]);
+        if (pid < 0) {
+            perror("leizi: fork");
+            close(fds[0]);
+            lastExitCode = 1;
+            return output;
+        }
+
+        readToEnd(fds[0], output);
+        close(fds[0]);
+
+        int status = 0;
+        waitWithUsage(pid, &status, 0, &commandTimer.stats());
+        if (WIFEXITED(status)) {
+            lastExitCode = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+            lastExitCode = 128 + WTERMSIG(status);
+        }
+        trimTrailingNewlines(output);
+        return output;
+    }
+
+    // 读取 here-doc 正文直到各自的定界符行，追加到输入之后（历史中保存完整的多行命令）
+    void readHereDocuments(std::string& input) {
+        for (const auto& delimiter : commandParser.hereDocDelimiters(input)) {
+            while (true) {
+                std::string line;
+                #if HAVE_READLINE
+                char* raw = readline("> ");
+                if (!raw) break;
+                line = raw;
+                free(raw);
+                #else
+                std::cout << "> " << std::flush;
+                if (!std::getline(std::cin, line)) break;
+                #endif
+
+                input += '\n';
+                input += line;
+                size_t start = 0;
+                if (delimiter.stripTabs) {
+                    while (start < line.size() && line[start] == '\t') ++start;
+                }
+                if (line.compare(start, std::string::npos, delimiter.word) == 0) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // 解析并执行一行输入，记录耗时与资源占用
+    void executeInput(const std::string& input) {
+        commandTimer.start();
+
+        // 解析和执行命令（支持管道）
+        if (!executeArithmeticCommand(input)) {
+            std::vector<std::vector<std::string>> pipeline;
+            if (parseAndExpand(input, pipeline)) {
+                executePipeline(pipeline);
+            }
+        }
+
+        publishCommandStats(commandTimer.stop());
+        ++commandNumber;
+    }
+
+    // 通过 $LEIZI_CMD_* 变量暴露上一条命令的统计；$LEIZI_CMD_STAGE_* 数组按管道各段列出，
+    // 单条命令时只有一个元素
+    void publishCommandStats(const CommandStats& stats) {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        auto ms = [](auto duration) {
+            return static_cast<std::int64_t>(duration_cast<milliseconds>(duration).count());
+        };
+        variables.setInteger("LEIZI_CMD_DURATION", ms(stats.wallTime));
+        variables.setInteger("LEIZI_CMD_USER_TIME", ms(stats.userTime));
+        variables.setInteger("LEIZI_CMD_SYS_TIME", ms(stats.systemTime));
+        variables.setInteger("LEIZI_CMD_MAX_RSS", static_cast<std::int64_t>(stats.maxRssKb));
+
+        const auto& stages = commandTimer.stages();
+        const std::vector<CommandStats> single{stats};
+        StringArray duration, user, system, rss;
+        for (const auto& stage : stages.empty() ? single : stages) {
+            duration.push_back(std::to_string(ms(stage.wallTime)));
+            user.push_back(std::to_string(ms(stage.userTime)));
+            system.push_back(std::to_string(ms(stage.systemTime)));
+            rss.push_back(std::to_string(stage.maxRssKb));
+        }
+        variables.set("LEIZI_CMD_STAGE_DURATION", Variable(std::move(duration)));
+        variables.set("LEIZI_CMD_STAGE_USER_TIME", Variable(std::move(user)));
+        variables.set("LEIZI_CMD_STAGE_SYS_TIME", Variable(std::move(system)));
+        variables.set("LEIZI_CMD_STAGE_MAX_RSS", Variable(std::move(rss)));
+    }
+
     // ==================== 作业控制相关方法 ====================
 
     // 更新作业状态
@@ -217,7 +966,7 @@ private:
         for (auto& job : jobs) {
             if (job.status == JobStatus::RUNNING || job.status == JobStatus::STOPPED) {
                 int status;
-                pid_t result = waitpid(job.pid, &status, WNOHANG | WUNTRACED);
+                pid_t result = waitWithUsage(job.pid, &status, WNOHANG | WUNTRACED, nullptr);
 
                 if (result > 0) {
                     if (WIFEXITED(status) || WIFSIGNALED(status)) {
@@ -306,7 +1055,7 @@ private:
 
         // 等待作业完成
         int status;
-        waitpid(it->pid, &status, WUNTRACED);
+        waitWithUsage(it->pid, &status, WUNTRACED, &commandTimer.stats());
 
         if (WIFEXITED(status) || WIFSIGNALED(status)) {
             jobs.erase(it);
@@ -371,10 +1120,10 @@ private:
 
     // 创建内建命令执行上下文
     BuiltinContext createBuiltinContext() {
-        return BuiltinContext(
+        BuiltinContext context(
             variables,
             commandParser,
-            commandHistory,
+            commandHistory.entries(),
             currentDirectory,
             homeDirectory,
             lastExitCode,
@@ -382,6 +1131,9 @@ private:
             historyFile,
             [this](const std::string& str) { return expandVariables(str); }
         );
+        context.historyStore = &historyStore;
+        context.arithmetic = &arithmetic;
+        return context;
     }
 
     // 执行内建命令（支持重定向的版本）
@@ -396,27 +1148,40 @@ private:
         }
 
         // 这些命令必须在当前进程中执行
-        if (cmd == "cd" || cmd == "export" || cmd == "unset" || cmd == "array" || cmd == "exit") {
+        if (cmd == "cd" || cmd == "export" || cmd == "unset" || cmd == "array" || cmd == "typeset" ||
+            cmd == "exit") {
             return executeBuiltin(args);
         }
 
+        // mapfile 要修改当前 shell 的变量：重定向临时应用到当前进程，执行后恢复
+        if (cmd == "mapfile" || cmd == "readarray") {
+            RedirectionPlan plan;
+            if (prepareRedirections(args, plan)) {
+                executeBuiltinInPlace(args, plan);
+            }
+            return true;
+        }
+
         // 其他内建命令可以在子进程中执行以支持重定向
         // 解析重定向
-        Redirection redir = parseRedirection(args);
+        RedirectionPlan plan;
+        if (!prepareRedirections(args, plan)) {
+            return true;
+        }
 
         // 如果有重定向，在子进程中执行
-        if (redir.type != Redirection::NONE) {
+        if (!plan.empty()) {
             pid_t pid = fork();
             if (pid == 0) {
                 // 子进程
                 signal(SIGINT, SIG_DFL);
-                applyRedirection(redir);
+                applyRedirections(plan);
                 executeBuiltin(args);
                 exit(lastExitCode);
             } else if (pid > 0) {
                 // 父进程
                 int status;
-                waitpid(pid, &status, 0);
+                waitWithUsage(pid, &status, 0, &commandTimer.stats());
                 if (WIFEXITED(status)) {
                     lastExitCode = WEXITSTATUS(status);
                 }
@@ -529,136 +1294,92 @@ private:
         return false;
     }
 
-    // I/O 重定向结构
-    struct Redirection {
-        enum Type {
-            NONE = 0,
-            OUTPUT = 1,        // >
-            OUTPUT_APPEND = 2, // >>
-            INPUT = 3,         // <
-            ERROR = 4,         // 2>
-            ERROR_APPEND = 5,  // 2>>
-            BOTH = 6          // &>
-        };
-
-        Type type = NONE;
-        std::string filename;
-    };
-
-    // 解析重定向
-    Redirection parseRedirection(std::vector<std::string>& tokens) {
-        Redirection redir;
+    // 在当前进程中应用重定向后执行内建命令，结束后恢复被替换的描述符
+    void executeBuiltinInPlace(const std::vector<std::string>& args, const RedirectionPlan& plan) {
+        std::vector<std::pair<int, int>> saved;  // 描述符与它的副本（原来未打开时为 -1）
+        for (const auto& action : plan.actions()) {
+            if (std::none_of(saved.begin(), saved.end(), [&](const auto& entry) { return entry.first == action.fd; })) {
+                saved.emplace_back(action.fd, fcntl(action.fd, F_DUPFD_CLOEXEC, 10));
+            }
+        }
 
-        for (size_t i = 0; i < tokens.size(); ++i) {
-            const std::string& token = tokens[i];
+        std::cout.flush();
+        std::string error;
+        if (plan.apply(error)) {
+            executeBuiltin(args);
+        } else {
+            std::cerr << "leizi: " << error << std::endl;
+            lastExitCode = 1;
+        }
+        std::cout.flush();
+        std::cerr.flush();
 
-            if (token == ">" && i + 1 < tokens.size()) {
-                redir.type = Redirection::OUTPUT;
-                redir.filename = tokens[i + 1];
-                tokens.erase(tokens.begin() + i, tokens.begin() + i + 2);
-                break;
-            } else if (token == ">>" && i + 1 < tokens.size()) {
-                redir.type = Redirection::OUTPUT_APPEND;
-                redir.filename = tokens[i + 1];
-                tokens.erase(tokens.begin() + i, tokens.begin() + i + 2);
-                break;
-            } else if (token == "<" && i + 1 < tokens.size()) {
-                redir.type = Redirection::INPUT;
-                redir.filename = tokens[i + 1];
-                tokens.erase(tokens.begin() + i, tokens.begin() + i + 2);
-                break;
-            } else if (token == "2>" && i + 1 < tokens.size()) {
-                redir.type = Redirection::ERROR;
-                redir.filename = tokens[i + 1];
-                tokens.erase(tokens.begin() + i, tokens.begin() + i + 2);
-                break;
-            } else if (token == "2>>" && i + 1 < tokens.size()) {
-                redir.type = Redirection::ERROR_APPEND;
-                redir.filename = tokens[i + 1];
-                tokens.erase(tokens.begin() + i, tokens.begin() + i + 2);
-                break;
-            } else if (token == "&>" && i + 1 < tokens.size()) {
-                redir.type = Redirection::BOTH;
-                redir.filename = tokens[i + 1];
-                tokens.erase(tokens.begin() + i, tokens.begin() + i + 2);
-                break;
+        for (auto it = saved.rbegin(); it != saved.rend(); ++it) {
+            if (it->second >= 0) {
+                dup2(it->second, it->first);
+                close(it->second);
+            } else {
+                close(it->first);
             }
         }
-
-        return redir;
     }
 
-    // 应用重定向
-    void applyRedirection(const Redirection& redir) {
-        if (redir.type == Redirection::NONE) return;
+    // 解析重定向并在当前进程中打开文件，失败时报告错误并设置退出码
+    bool prepareRedirections(std::vector<std::string>& args, RedirectionPlan& plan) {
+        std::string error;
+        if (!plan.parse(args, [this](const std::string& word) { return expandVariables(word); }, error)) {
+            std::cerr << "leizi: " << error << std::endl;
+            lastExitCode = 2;
+            return false;
+        }
+        if (!plan.open(error)) {
+            std::cerr << "leizi: " << error << std::endl;
+            lastExitCode = 1;
+            return false;
+        }
+        return true;
+    }
 
-        std::string filename = expandVariables(redir.filename);
+    // 在子进程中应用重定向，失败时退出
+    static void applyRedirections(const RedirectionPlan& plan) {
+        std::string error;
+        if (!plan.apply(error)) {
+            std::cerr << "leizi: " << error << std::endl;
+            exit(1);
+        }
+    }
 
-        switch (redir.type) {
-            case Redirection::OUTPUT: {
-                int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-                if (fd < 0) {
-                    perror("open");
-                    exit(1);
-                }
-                dup2(fd, STDOUT_FILENO);
-                close(fd);
-                break;
-            }
-            case Redirection::OUTPUT_APPEND: {
-                int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
-                if (fd < 0) {
-                    perror("open");
-                    exit(1);
-                }
-                dup2(fd, STDOUT_FILENO);
-                close(fd);
-                break;
-            }
-            case Redirection::INPUT: {
-                int fd = open(filename.c_str(), O_RDONLY);
-                if (fd < 0) {
-                    perror("open");
-                    exit(1);
-                }
-                dup2(fd, STDIN_FILENO);
-                close(fd);
-                break;
-            }
-            case Redirection::ERROR: {
-                int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-                if (fd < 0) {
-                    perror("open");
-                    exit(1);
-                }
-                dup2(fd, STDERR_FILENO);
-                close(fd);
-                break;
-            }
-            case Redirection::ERROR_APPEND: {
-                int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
-                if (fd < 0) {
-                    perror("open");
-                    exit(1);
-                }
-                dup2(fd, STDERR_FILENO);
-                close(fd);
-                break;
-            }
-            case Redirection::BOTH: {
-                int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-                if (fd < 0) {
-                    perror("open");
-                    exit(1);
-                }
-                dup2(fd, STDOUT_FILENO);
-                dup2(fd, STDERR_FILENO);
-                close(fd);
-                break;
-            }
-            default:
-                break;
+    // 用 posix_spawn 启动前台命令，重定向计划作为文件动作；stdoutFd 不为 -1 时先接到标准输出
+    // @return 子进程 PID；失败时返回 -1，spawnError 为错误码
+    static pid_t spawnCommand(std::vector<char*>& argv, const RedirectionPlan& plan, int& spawnError,
+                              int stdoutFd = -1) {
+        posix_spawn_file_actions_t actions;
+        posix_spawnattr_t attr;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawnattr_init(&attr);
+
+        // 恢复默认的 SIGINT/SIGTSTP 处理（Ctrl+C、Ctrl+Z），清空信号屏蔽
+        sigset_t defaults;
+        sigemptyset(&defaults);
+        sigaddset(&defaults, SIGINT);
+        sigaddset(&defaults, SIGTSTP);
+        sigset_t mask;
+        sigemptyset(&mask);
+        posix_spawnattr_setsigdefault(&attr, &defaults);
+        posix_spawnattr_setsigmask(&attr, &mask);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+
+        pid_t pid = -1;
+        if (stdoutFd >= 0) {
+            posix_spawn_file_actions_adddup2(&actions, stdoutFd, STDOUT_FILENO);
         }
+        spawnError = plan.addSpawnActions(&actions)
+            ? posix_spawnp(&pid, argv[0], &actions, &attr, argv.data(), environ)
+            : ENOMEM;
+
+        posix_spawnattr_destroy(&attr);
+        posix_spawn_file_actions_destroy(&actions);
+        return spawnError == 0 ? pid : -1;
     }
 
     // 执行管道命令
@@ -693,6 +1414,17 @@ private:
             return;
         }
 
+        // 重定向在创建子进程前解析并打开，错误由对应的子进程报告
+        std::vector<std::vector<std::string>> stages(commands);
+        std::vector<RedirectionPlan> plans(commands.size());
+        std::vector<std::string> planErrors(commands.size());
+        for (size_t i = 0; i < stages.size(); ++i) {
+            if (plans[i].parse(stages[i], [this](const std::string& word) { return expandVariables(word); },
+                               planErrors[i])) {
+                plans[i].open(planErrors[i]);
+            }
+        }
+
         // 创建管道
         std::vector<std::pair<int, int>> pipes(commands.size() - 1);
         for (size_t i = 0; i < pipes.size(); ++i) {
@@ -714,10 +1446,6 @@ private:
                 // 子进程
                 signal(SIGINT, SIG_DFL);  // 恢复默认的SIGINT处理
 
-                // 解析重定向（复制命令以避免修改原始命令）
-                std::vector<std::string> cmdCopy = commands[i];
-                Redirection redir = parseRedirection(cmdCopy);
-
                 // 设置输入重定向
                 if (i > 0) {
                     dup2(pipes[i - 1].first, STDIN_FILENO);
@@ -735,13 +1463,17 @@ private:
                 }
 
                 // 应用文件重定向（会覆盖管道重定向）
-                applyRedirection(redir);
+                if (!planErrors[i].empty()) {
+                    std::cerr << "leizi: " << planErrors[i] << std::endl;
+                    exit(1);
+                }
+                applyRedirections(plans[i]);
+                if (stages[i].empty()) {
+                    exit(0);
+                }
 
                 // 展开变量并执行命令
-                std::vector<std::string> expandedArgs;
-                for (const auto& arg : cmdCopy) {
-                    expandedArgs.push_back(expandVariables(arg));
-                }
+                std::vector<std::string> expandedArgs = expandArguments(stages[i]);
 
                 std::vector<char*> argv;
                 for (const auto& arg : expandedArgs) {
@@ -751,7 +1483,7 @@ private:
 
                 // 检查是否是内建命令
                 if (expandedArgs[0] == "cd" || expandedArgs[0] == "export" ||
-                    expandedArgs[0] == "unset" || expandedArgs[0] == "array") {
+                    expandedArgs[0] == "unset" || expandedArgs[0] == "array" || expandedArgs[0] == "typeset") {
                     // 内建命令不能在管道中使用
                     std::cerr << "leizi: " << expandedArgs[0]
                               << ": builtin command cannot be used in pipeline\n";
@@ -783,13 +1515,26 @@ private:
             close(pipes[i].second);
         }
 
-        // 等待所有子进程完成
-        for (pid_t pid : pids) {
+        // 按结束的先后回收各段，每段的耗时截至它自己结束。先用 WNOWAIT 查看哪个子进程已结束，
+        // 不属于管道的（后台作业）留给作业控制回收，此时按顺序等待下一段
+        std::vector<size_t> remaining(pids.size());
+        std::iota(remaining.begin(), remaining.end(), 0);
+        while (!remaining.empty()) {
+            size_t next = 0;
+            siginfo_t info {};
+            if (waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) == 0) {
+                auto it = std::find_if(remaining.begin(), remaining.end(),
+                                       [&](size_t stage) { return pids[stage] == info.si_pid; });
+                if (it != remaining.end()) next = static_cast<size_t>(it - remaining.begin());
+            }
+            const size_t stage = remaining[next];
+            remaining.erase(remaining.begin() + static_cast<std::ptrdiff_t>(next));
+
             int status;
-            waitpid(pid, &status, 0);
+            commandTimer.waitStage(stage, pids[stage], &status);
 
             // 记录最后一个命令的退出状态
-            if (pid == pids.back()) {
+            if (stage + 1 == pids.size()) {
                 if (WIFEXITED(status)) {
                     lastExitCode = WEXITSTATUS(status);
                 } else if (WIFSIGNALED(status)) {
@@ -804,13 +1549,18 @@ private:
         if (args.empty()) return;
 
         // 解析重定向
-        Redirection redir = parseRedirection(args);
+        RedirectionPlan plan;
+        if (!prepareRedirections(args, plan)) {
+            return;
+        }
+        if (args.empty()) {
+            // 只有重定向：文件已经创建或截断
+            lastExitCode = 0;
+            return;
+        }
 
         // 展开所有参数中的变量
-        std::vector<std::string> expandedArgs;
-        for (const auto& arg : args) {
-            expandedArgs.push_back(expandVariables(arg));
-        }
+        std::vector<std::string> expandedArgs = expandArguments(args);
 
         // 创建参数数组
         std::vector<char*> argv;
@@ -819,7 +1569,27 @@ private:
         }
         argv.push_back(nullptr);
 
-        pid_t pid = fork();
+        // 前台命令用 posix_spawn 启动；后台命令需要忽略 SIGINT，
+        // 没有 #! 的脚本需要 execvp 回退到 /bin/sh，这两种情况仍然 fork
+        pid_t pid = -1;
+        int spawnError = ENOEXEC;
+        if (!background) {
+            pid = spawnCommand(argv, plan, spawnError);
+            if (spawnError == ENOENT) {
+                std::cerr << "leizi: " << argv[0] << ": command not found" << std::endl;
+                lastExitCode = 127;
+                return;
+            }
+            if (spawnError != 0 && spawnError != ENOEXEC) {
+                std::cerr << "leizi: " << argv[0] << ": " << std::strerror(spawnError) << std::endl;
+                lastExitCode = 126;
+                return;
+            }
+        }
+        if (spawnError != 0) {
+            pid = fork();
+        }
+
         if (pid == 0) {
             // 子进程
             signal(SIGINT, SIG_DFL);  // 恢复默认的SIGINT处理
@@ -831,7 +1601,7 @@ private:
             }
 
             // 应用重定向
-            applyRedirection(redir);
+            applyRedirections(plan);
 
             execvp(argv[0], argv.data());
             std::cerr << "leizi: " << argv[0] << ": command not found" << std::endl;
@@ -851,7 +1621,7 @@ private:
                 foregroundPid = pid;
                 g_foregroundPid = pid;  // 更新全局前台进程ID
                 int status;
-                waitpid(pid, &status, WUNTRACED);
+                waitWithUsage(pid, &status, WUNTRACED, &commandTimer.stats());
                 foregroundPid = -1;
                 g_foregroundPid = -1;  // 清除全局前台进程ID
 
@@ -907,15 +1677,28 @@ public:
         variables.setString("SHELL", "/usr/local/bin/leizi", true);
         variables.setString("LEIZI_VERSION", LEIZI_VERSION_STRING, true);
 
-        // 加载历史记录
-        loadHistory();
-
         // 加载配置文件
         std::string configPath = homeDirectory + "/.config/leizi/config";
         if (!configManager.loadConfig(configPath)) {
             // 如果配置不存在，生成默认配置
             configManager.generateDefaultConfig(configPath);
         }
+        applyPromptConfig();
+
+        // 加载历史记录（去重规则来自 [history] 配置）
+        commandHistory.setIgnoreDuplicates(configManager.getBool("history", "ignore_duplicates").value_or(true));
+        commandHistory.setIgnoreSpace(configManager.getBool("history", "ignore_space").value_or(true));
+        loadHistory();
+
+        // 历史文件超过 [history] size 时在后台压缩，打开 archive 时旧记录移入归档
+        if (historyWriter) {
+            historyWriter->setMaxEntries(historySize());
+            if (configManager.getBool("history", "archive").value_or(false)) {
+                historyWriter->setArchive(HistoryArchive::pathFor(historyFile));
+            }
+            historyWriter->maybeCompact();
+        }
+        shareHistory = configManager.getBool("history", "share").value_or(false);
 
         // 初始化智能补全系统
         completer = std::make_unique<SmartCompleter>();
@@ -929,7 +1712,7 @@ public:
         // 添加各种补全提供者 (按优先级从高到低)
         completer->addProvider(std::make_unique<CommandCompleter>(builtins));
         completer->addProvider(std::make_unique<VariableCompleter>(variables));
-        completer->addProvider(std::make_unique<HistoryCompleter>(commandHistory));
+        completer->addProvider(std::make_unique<HistoryCompleter>(commandHistory.entries()));
         completer->addProvider(std::make_unique<FileCompleter>());
 
         // 初始化语法高亮器
@@ -939,11 +1722,22 @@ public:
         // 初始化readline
         rl_attempted_completion_function = nullptr;
         using_history();
+        g_historySearch = &historySearch;
+        rl_bind_keyseq("\\C-r", reverseSearch);
+        setupLineDecoration();
         #endif
     }
 
     ~LeiziShell() {
-        saveHistory();
+        #if HAVE_READLINE
+        g_historySearch = nullptr;
+        g_historySuggest = nullptr;
+        g_lineHighlighter = nullptr;
+        #endif
+        // 历史已在执行时逐条写入，这里只需等待后台压缩结束
+        if (historyWriter) {
+            historyWriter->wait();
+        }
     }
 
     void run() {
@@ -959,7 +1753,15 @@ public:
         while (!exitRequested) {
             // 更新后台作业状态
             updateJobStatus();
+            importSharedHistory();
             #if HAVE_READLINE
+            if (g_historySuggest) {
+                historySuggest.sync(0);
+            }
+            // Ctrl-R 索引先加入新执行或导入的记录，文件中的旧记录在等待输入时从新到旧补充
+            if (historySearch.sync(0)) {
+                rl_event_hook = backfillIndexes;
+            }
             char* line = readline(generatePrompt().c_str());
             if (!line) {
                 // EOF (Ctrl+D)
@@ -968,15 +1770,12 @@ public:
             }
 
             input = std::string(line);
+            free(line);
+            collapsePrompt(input);
+            readHereDocuments(input);
             if (!input.empty()) {
-                add_history(line);
-                commandHistory.push_back(input);
-
-                // 解析和执行命令（支持管道）
-                auto pipeline = commandParser.parsePipeline(input);
-                executePipeline(pipeline);
+                executeAndRecord(input);
             }
-            free(line);
             #else
             // 简单的输入循环（没有readline时）
             input = simpleReadline(generatePrompt());
@@ -988,12 +1787,10 @@ public:
                 break;
             }
 
+            collapsePrompt(input);
+            readHereDocuments(input);
             if (!input.empty()) {
-                commandHistory.push_back(input);
-
-                // 解析和执行命令（支持管道）
-                auto pipeline = commandParser.parsePipeline(input);
-                executePipeline(pipeline);
+                executeAndRecord(input);
             }
             #endif
 
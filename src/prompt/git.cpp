@@ -12,12 +12,30 @@
 GitIntegration::Cache GitIntegration::cache = {};
 
 bool GitIntegration::isGitRepository() {
-    struct stat buffer {};
-    return (stat(".git", &buffer) == 0) || (getenv("GIT_DIR") != nullptr);
+    return currentRepository() != nullptr;
+}
+
+GitRepository* GitIntegration::currentRepository() {
+    char cwd[1024];
+    if (getcwd(cwd, sizeof(cwd)) == nullptr) {
+        return nullptr;
+    }
+
+    // 向上查找只需要几次 stat；同一仓库保留已映射的 pack 索引
+    auto found = GitRepository::discover(cwd);
+    if (!found) {
+        cache.repository.reset();
+        return nullptr;
+    }
+    if (!cache.repository || cache.repository->gitDir() != found->gitDir()) {
+        cache.repository = std::move(found);
+    }
+    return &*cache.repository;
 }
 
 std::string GitIntegration::getBranch(bool forceRefresh) {
-    if (!isGitRepository()) return "";
+    GitRepository* repo = currentRepository();
+    if (!repo) return "";
 
     // 获取当前工作目录
     char cwd[1024];
@@ -39,12 +57,15 @@ std::string GitIntegration::getBranch(bool forceRefresh) {
         return cache.branch;
     }
 
-    // 缓存失效或强制刷新，重新获取
-    std::string result = executeCommand(
-        "git symbolic-ref --short HEAD 2>/dev/null || "
-        "git describe --tags --exact-match 2>/dev/null || "
-        "git rev-parse --short HEAD 2>/dev/null"
-    );
+    // 缓存失效或强制刷新，重新获取：分支名 > 精确标签 > 短提交 ID
+    GitRepository::Head head = repo->readHead();
+    std::string result = head.branch;
+    if (head.detached) {
+        result = repo->tagFor(head.commit);
+        if (result.empty()) {
+            result = head.commit.substr(0, 7);
+        }
+    }
 
     // 截断过长的分支名
     result = result.length() > 20 ? result.substr(0, 20) + "..." : result;
@@ -139,6 +160,87 @@ std::string GitIntegration::getStatus(bool forceRefresh) {
     return result;
 }
 
+GitRepoState GitIntegration::getRepoState(bool forceRefresh) {
+    GitRepository* repo = currentRepository();
+    if (!repo) return {};
+
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+        now - cache.repoStateTime
+    ).count();
+
+    if (!forceRefresh &&
+        cache.repoStateDir == repo->gitDir() &&
+        elapsed < STATUS_CACHE_SECONDS) {
+        return cache.repoState;
+    }
+
+    GitRepoState state;
+    state.stashes = repo->stashCount();
+    state.operation = repo->operationInProgress();
+
+    GitRepository::Head head = repo->readHead();
+    if (!head.detached && !head.commit.empty()) {
+        if (auto upstream = repo->upstreamRef(head.branch)) {
+            std::string upstreamCommit = repo->resolveRef(*upstream);
+            if (!upstreamCommit.empty()) {
+                // 提交 ID 对不变时结果也不变，无需重新遍历
+                std::string key = head.commit + ":" + upstreamCommit;
+                auto it = cache.aheadBehind.find(key);
+                if (it == cache.aheadBehind.end()) {
+                    if (auto counts = repo->aheadBehind(head.commit, upstreamCommit,
+                                                        AHEAD_BEHIND_MAX_COMMITS)) {
+                        if (cache.aheadBehind.size() >= AHEAD_BEHIND_CACHE_ENTRIES) {
+                            cache.aheadBehind.clear();
+                        }
+                        it = cache.aheadBehind.emplace(key, *counts).first;
+                    }
+                }
+                if (it != cache.aheadBehind.end()) {
+                    state.hasUpstream = true;
+                    state.ahead = it->second.ahead;
+                    state.behind = it->second.behind;
+                    state.truncated = it->second.truncated;
+                }
+            }
+        }
+    }
+
+    cache.repoState = state;
+    cache.repoStateTime = now;
+    cache.repoStateDir = repo->gitDir();
+    return state;
+}
+
+std::uint64_t GitIntegration::stateStamp() {
+    GitRepository* repo = currentRepository();
+    if (!repo) return 0;
+
+    // FNV-1a 组合各项输入
+    std::uint64_t stamp = 1469598103934665603ULL;
+    auto mix = [&stamp](std::uint64_t value) {
+        stamp ^= value;
+        stamp *= 1099511628211ULL;
+    };
+
+    for (const char* name : {"/HEAD", "/index"}) {
+        std::string path = repo->gitDir() + name;
+        struct stat st {};
+        if (stat(path.c_str(), &st) == 0) {
+            mix(static_cast<std::uint64_t>(st.st_mtime));
+            mix(static_cast<std::uint64_t>(st.st_ino));
+            mix(static_cast<std::uint64_t>(st.st_size));
+        }
+    }
+
+    // 工作区改动不会反映在 index 上，按状态缓存周期强制刷新
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    mix(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(now).count() / STATUS_CACHE_SECONDS));
+
+    return stamp == 0 ? 1 : stamp;
+}
+
 void GitIntegration::clearCache() {
     cache = Cache{};
 }
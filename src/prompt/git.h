@@ -3,18 +3,35 @@
 
 #include <string>
 #include <chrono>
+#include <cstdint>
 #include <optional>
+#include <unordered_map>
+
+#include "prompt/git_repo.h"
+
+/**
+ * @brief 仓库附加状态：领先/落后、stash 数与进行中的操作
+ */
+struct GitRepoState {
+    bool hasUpstream = false;
+    int ahead = 0;
+    int behind = 0;
+    bool truncated = false;  // 提交遍历达到上限，计数为下限
+    int stashes = 0;
+    std::string operation;   // rebase、am、merge、cherry-pick、revert、bisect，无则为空
+};
 
 /**
  * @brief Git 集成功能类
  *
  * 负责获取 Git 仓库信息，包括分支名和文件状态
+ * 分支、上游与 stash 等信息直接读取 .git 目录，只有工作区状态仍调用 git
  * 使用缓存机制优化性能，减少 git 命令调用
  */
 class GitIntegration {
 public:
     /**
-     * @brief 检查当前目录是否为 Git 仓库
+     * @brief 检查当前目录（或其上级目录）是否位于 Git 仓库中
      * @return true 如果是 Git 仓库
      */
     static bool isGitRepository();
@@ -33,6 +50,23 @@ public:
      */
     static std::string getStatus(bool forceRefresh = false);
 
+    /**
+     * @brief 获取领先/落后、stash 数与进行中的操作（带缓存，不启动子进程）
+     *
+     * 领先/落后计数以本地与上游提交 ID 对为键缓存，只有任一侧移动时才重新遍历
+     * @param forceRefresh 是否强制刷新缓存
+     */
+    static GitRepoState getRepoState(bool forceRefresh = false);
+
+    /**
+     * @brief 获取仓库状态戳，用于判断提示符段落缓存是否失效
+     *
+     * 由 HEAD 与 index 的修改时间以及状态缓存周期组合而成，
+     * 只调用 stat，不启动子进程
+     * @return 状态戳，不在仓库中时返回 0
+     */
+    static std::uint64_t stateStamp();
+
     /**
      * @brief 清除所有缓存
      */
@@ -46,6 +80,12 @@ private:
      */
     static std::string executeCommand(const std::string& command);
 
+    /**
+     * @brief 返回当前目录所在的仓库，同一仓库复用已打开的读取器
+     * @return 不在仓库中时返回 nullptr
+     */
+    static GitRepository* currentRepository();
+
     // 缓存相关
     struct Cache {
         std::string branch;
@@ -53,11 +93,20 @@ private:
         std::chrono::steady_clock::time_point branchTime;
         std::chrono::steady_clock::time_point statusTime;
         std::string lastWorkingDir;
+
+        std::optional<GitRepository> repository;
+        GitRepoState repoState;
+        std::chrono::steady_clock::time_point repoStateTime;
+        std::string repoStateDir;
+        // "本地ID:上游ID" -> 领先/落后
+        std::unordered_map<std::string, GitRepository::AheadBehind> aheadBehind;
     };
 
     static Cache cache;
     static constexpr int BRANCH_CACHE_SECONDS = 10; // 分支名缓存10秒
     static constexpr int STATUS_CACHE_SECONDS = 2;  // 状态缓存2秒
+    static constexpr size_t AHEAD_BEHIND_MAX_COMMITS = 10000;  // 提交遍历上限
+    static constexpr size_t AHEAD_BEHIND_CACHE_ENTRIES = 64;
 };
 
 #endif // LEIZI_PROMPT_GIT_H
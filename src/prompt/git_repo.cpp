@@ -0,0 +1,708 @@
+#include "prompt/git_repo.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <queue>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#ifdef LEIZI_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+constexpr int OBJ_COMMIT = 1;
+constexpr int OBJ_OFS_DELTA = 6;
+constexpr int OBJ_REF_DELTA = 7;
+
+// delta 链过长视为损坏
+constexpr int MAX_DELTA_DEPTH = 64;
+
+bool isDirectory(const std::string& path) {
+    struct stat st {};
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool exists(const std::string& path) {
+    struct stat st {};
+    return stat(path.c_str(), &st) == 0;
+}
+
+std::string trimRight(std::string s) {
+    while (!s.empty() && (s.back() == '\n' || s.back() == '\r' || s.back() == ' ' || s.back() == '\t')) {
+        s.pop_back();
+    }
+    return s;
+}
+
+std::string trim(const std::string& s) {
+    size_t start = 0;
+    while (start < s.size() && std::isspace(static_cast<unsigned char>(s[start]))) ++start;
+    return trimRight(s.substr(start));
+}
+
+std::string parentDir(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) return ".";
+    if (slash == 0) return "/";
+    return path.substr(0, slash);
+}
+
+std::string joinPath(const std::string& base, const std::string& rel) {
+    if (!rel.empty() && rel[0] == '/') return rel;
+    return base + "/" + rel;
+}
+
+struct ObjectIdHash {
+    size_t operator()(const GitObjectId& id) const {
+        size_t h;
+        std::memcpy(&h, id.data(), sizeof(h));
+        return h;
+    }
+};
+
+// 只读内存映射
+struct MappedFile {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st {};
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) return false;
+        data = static_cast<const unsigned char*>(addr);
+        size = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    ~MappedFile() {
+        if (data) munmap(const_cast<unsigned char*>(data), size);
+    }
+};
+
+std::uint32_t readBe32(const unsigned char* p) {
+    return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+}
+
+#ifdef LEIZI_HAVE_ZLIB
+// 解压 zlib 流；expected 为 0 时表示未知长度
+bool inflateBuffer(const unsigned char* in, size_t inSize, std::string& out, size_t expected) {
+    z_stream zs {};
+    if (inflateInit(&zs) != Z_OK) return false;
+
+    out.clear();
+    out.resize(expected > 0 ? expected : std::max<size_t>(inSize * 2, 256));
+    zs.next_in = const_cast<Bytef*>(in);
+    zs.avail_in = static_cast<uInt>(std::min<size_t>(inSize, UINT32_MAX));
+
+    int ret = Z_OK;
+    size_t produced = 0;
+    while (ret == Z_OK) {
+        if (produced == out.size()) {
+            if (expected > 0) break;  // 已得到预期长度
+            out.resize(out.size() * 2);
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(&out[produced]);
+        zs.avail_out = static_cast<uInt>(out.size() - produced);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        produced = out.size() - zs.avail_out;
+    }
+    inflateEnd(&zs);
+
+    if (ret != Z_STREAM_END && !(expected > 0 && produced == expected)) return false;
+    out.resize(produced);
+    return expected == 0 || produced == expected;
+}
+#endif
+
+// pack 内 delta 头部的变长整数
+size_t readDeltaSize(const std::string& delta, size_t& pos) {
+    size_t value = 0;
+    int shift = 0;
+    while (pos < delta.size()) {
+        unsigned char c = static_cast<unsigned char>(delta[pos++]);
+        value |= static_cast<size_t>(c & 0x7f) << shift;
+        shift += 7;
+        if (!(c & 0x80)) break;
+    }
+    return value;
+}
+
+bool applyDelta(const std::string& base, const std::string& delta, std::string& out) {
+    size_t pos = 0;
+    size_t baseSize = readDeltaSize(delta, pos);
+    size_t resultSize = readDeltaSize(delta, pos);
+    if (baseSize != base.size()) return false;
+
+    out.clear();
+    out.reserve(resultSize);
+    while (pos < delta.size()) {
+        unsigned char cmd = static_cast<unsigned char>(delta[pos++]);
+        if (cmd & 0x80) {
+            size_t offset = 0;
+            size_t size = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (cmd & (1 << i)) {
+                    if (pos >= delta.size()) return false;
+                    offset |= static_cast<size_t>(static_cast<unsigned char>(delta[pos++])) << (8 * i);
+                }
+            }
+            for (int i = 0; i < 3; ++i) {
+                if (cmd & (0x10 << i)) {
+                    if (pos >= delta.size()) return false;
+                    size |= static_cast<size_t>(static_cast<unsigned char>(delta[pos++])) << (8 * i);
+                }
+            }
+            if (size == 0) size = 0x10000;
+            if (offset + size > base.size()) return false;
+            out.append(base, offset, size);
+        } else if (cmd != 0) {
+            if (pos + cmd > delta.size()) return false;
+            out.append(delta, pos, cmd);
+            pos += cmd;
+        } else {
+            return false;
+        }
+    }
+    return out.size() == resultSize;
+}
+
+} // namespace
+
+// .idx（v2）与 .pack 文件对
+struct GitRepository::PackFile {
+    MappedFile index;
+    MappedFile pack;
+    std::uint32_t count = 0;
+
+    const unsigned char* fanout() const { return index.data + 8; }
+    const unsigned char* ids() const { return index.data + 8 + 256 * 4; }
+    const unsigned char* offsets32() const { return ids() + size_t(count) * 20 + size_t(count) * 4; }
+    const unsigned char* offsets64() const { return offsets32() + size_t(count) * 4; }
+
+    bool load(const std::string& idxPath, const std::string& packPath) {
+        if (!index.open(idxPath) || !pack.open(packPath)) return false;
+        if (index.size < 8 + 256 * 4 || std::memcmp(index.data, "\377tOc", 4) != 0 ||
+            readBe32(index.data + 4) != 2) {
+            return false;
+        }
+        count = readBe32(fanout() + 255 * 4);
+        return index.size >= size_t(offsets64() - index.data);
+    }
+
+    std::optional<std::uint64_t> find(const GitObjectId& id) const {
+        std::uint32_t lo = id[0] == 0 ? 0 : readBe32(fanout() + (id[0] - 1) * 4);
+        std::uint32_t hi = readBe32(fanout() + id[0] * 4);
+        while (lo < hi) {
+            std::uint32_t mid = lo + (hi - lo) / 2;
+            int cmp = std::memcmp(ids() + size_t(mid) * 20, id.data(), 20);
+            if (cmp == 0) {
+                std::uint32_t off = readBe32(offsets32() + size_t(mid) * 4);
+                if (!(off & 0x80000000u)) return off;
+                const unsigned char* p = offsets64() + size_t(off & 0x7fffffffu) * 8;
+                return (std::uint64_t(readBe32(p)) << 32) | readBe32(p + 4);
+            }
+            if (cmp < 0) lo = mid + 1; else hi = mid;
+        }
+        return std::nullopt;
+    }
+};
+
+GitRepository::GitRepository(GitRepository&&) noexcept = default;
+GitRepository& GitRepository::operator=(GitRepository&&) noexcept = default;
+GitRepository::~GitRepository() = default;
+
+std::optional<GitRepository> GitRepository::discover(const std::string& startDir) {
+    GitRepository repo;
+
+    if (const char* envDir = getenv("GIT_DIR")) {
+        repo.gitDir_ = joinPath(startDir, envDir);
+    } else {
+        std::string dir = startDir;
+        while (true) {
+            std::string candidate = dir + (dir == "/" ? ".git" : "/.git");
+            struct stat st {};
+            if (stat(candidate.c_str(), &st) == 0) {
+                if (S_ISDIR(st.st_mode)) {
+                    repo.gitDir_ = candidate;
+                } else {
+                    // worktree / submodule：.git 文件内容为 "gitdir: <path>"
+                    std::string content = trimRight(repo.readFile(candidate));
+                    if (content.rfind("gitdir:", 0) != 0) return std::nullopt;
+                    repo.gitDir_ = joinPath(dir, trim(content.substr(7)));
+                }
+                break;
+            }
+            if (dir == "/" || dir.empty()) return std::nullopt;
+            dir = parentDir(dir);
+        }
+    }
+
+    if (!exists(repo.gitDir_ + "/HEAD")) return std::nullopt;
+
+    repo.commonDir_ = repo.gitDir_;
+    std::string common = trimRight(repo.readFile(repo.gitDir_ + "/commondir"));
+    if (!common.empty()) {
+        repo.commonDir_ = joinPath(repo.gitDir_, common);
+    }
+    return repo;
+}
+
+std::string GitRepository::readFile(const std::string& path) const {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return {};
+    std::string content;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        content.append(buffer, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return content;
+}
+
+GitRepository::Head GitRepository::readHead() const {
+    Head head;
+    std::string content = trimRight(readFile(gitDir_ + "/HEAD"));
+
+    if (content.rfind("ref:", 0) == 0) {
+        std::string ref = trim(content.substr(4));
+        if (ref.rfind("refs/heads/", 0) == 0) {
+            head.branch = ref.substr(11);
+        } else {
+            head.branch = ref;
+        }
+        head.commit = resolveRef(ref);
+    } else {
+        head.detached = true;
+        head.commit = content;
+    }
+    return head;
+}
+
+std::string GitRepository::resolveRef(const std::string& ref) const {
+    std::string current = ref;
+    // 符号引用最多跟随几层
+    for (int depth = 0; depth < 5; ++depth) {
+        std::string content = trimRight(readFile(gitDir_ + "/" + current));
+        if (content.empty() && commonDir_ != gitDir_) {
+            content = trimRight(readFile(commonDir_ + "/" + current));
+        }
+        if (content.empty()) {
+            return packedRef(current);
+        }
+        if (content.rfind("ref:", 0) == 0) {
+            current = trim(content.substr(4));
+            continue;
+        }
+        return content.size() >= 40 ? content.substr(0, 40) : std::string();
+    }
+    return {};
+}
+
+std::string GitRepository::packedRef(const std::string& ref) const {
+    std::istringstream packed(readFile(commonDir_ + "/packed-refs"));
+    std::string line;
+    while (std::getline(packed, line)) {
+        if (line.size() > 41 && line[40] == ' ' && line.compare(41, std::string::npos, ref) == 0) {
+            return line.substr(0, 40);
+        }
+    }
+    return {};
+}
+
+std::optional<std::string> GitRepository::upstreamRef(const std::string& branch) const {
+    if (branch.empty()) return std::nullopt;
+
+    std::istringstream config(readFile(commonDir_ + "/config"));
+    const std::string wanted = "branch \"" + branch + "\"";
+    std::string line;
+    std::string section;
+    std::string remote;
+    std::string merge;
+
+    while (std::getline(config, line)) {
+        std::string t = trim(line);
+        if (t.empty() || t[0] == '#' || t[0] == ';') continue;
+        if (t.front() == '[' && t.back() == ']') {
+            section = trim(t.substr(1, t.size() - 2));
+            continue;
+        }
+        if (section != wanted) continue;
+
+        size_t eq = t.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = trim(t.substr(0, eq));
+        std::string value = trim(t.substr(eq + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        if (key == "remote") remote = value;
+        else if (key == "merge") merge = value;
+    }
+
+    if (remote.empty() || merge.empty()) return std::nullopt;
+    if (remote == ".") return merge;  // 本地上游分支
+
+    std::string name = merge.rfind("refs/heads/", 0) == 0 ? merge.substr(11) : merge;
+    return "refs/remotes/" + remote + "/" + name;
+}
+
+std::string GitRepository::tagFor(const std::string& commit) const {
+    if (commit.empty()) return {};
+
+    // 松散的轻量标签
+    std::string tagsDir = commonDir_ + "/refs/tags";
+    if (DIR* dir = opendir(tagsDir.c_str())) {
+        std::string found;
+        while (struct dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.') continue;
+            if (trimRight(readFile(tagsDir + "/" + entry->d_name)) == commit) {
+                found = entry->d_name;
+                break;
+            }
+        }
+        closedir(dir);
+        if (!found.empty()) return found;
+    }
+
+    // packed-refs：轻量标签直接匹配，附注标签匹配其后的 "^<peeled>" 行
+    std::istringstream packed(readFile(commonDir_ + "/packed-refs"));
+    std::string line;
+    std::string lastTag;
+    while (std::getline(packed, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        if (line[0] == '^') {
+            if (!lastTag.empty() && line.compare(1, 40, commit) == 0) return lastTag;
+            continue;
+        }
+        lastTag.clear();
+        if (line.size() > 51 && line.compare(41, 10, "refs/tags/") == 0) {
+            std::string name = line.substr(51);
+            if (line.compare(0, 40, commit) == 0) return name;
+            lastTag = name;
+        }
+    }
+    return {};
+}
+
+int GitRepository::stashCount() const {
+    std::string log = readFile(commonDir_ + "/logs/refs/stash");
+    return static_cast<int>(std::count(log.begin(), log.end(), '\n'));
+}
+
+std::string GitRepository::operationInProgress() const {
+    if (isDirectory(gitDir_ + "/rebase-merge")) return "rebase";
+    if (isDirectory(gitDir_ + "/rebase-apply")) {
+        return exists(gitDir_ + "/rebase-apply/applying") ? "am" : "rebase";
+    }
+    if (exists(gitDir_ + "/MERGE_HEAD")) return "merge";
+    if (exists(gitDir_ + "/CHERRY_PICK_HEAD")) return "cherry-pick";
+    if (exists(gitDir_ + "/REVERT_HEAD")) return "revert";
+    if (exists(gitDir_ + "/BISECT_LOG")) return "bisect";
+    return {};
+}
+
+bool GitRepository::parseObjectId(const std::string& hex, GitObjectId& id) {
+    if (hex.size() < 40) return false;
+    for (size_t i = 0; i < 20; ++i) {
+        auto nibble = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        };
+        int hi = nibble(hex[2 * i]);
+        int lo = nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        id[i] = static_cast<unsigned char>((hi << 4) | lo);
+    }
+    return true;
+}
+
+std::string GitRepository::formatObjectId(const GitObjectId& id) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(40, '0');
+    for (size_t i = 0; i < 20; ++i) {
+        hex[2 * i] = digits[id[i] >> 4];
+        hex[2 * i + 1] = digits[id[i] & 0xf];
+    }
+    return hex;
+}
+
+void GitRepository::loadPacks() const {
+    if (packsLoaded_) return;
+    packsLoaded_ = true;
+
+    std::string packDir = commonDir_ + "/objects/pack";
+    DIR* dir = opendir(packDir.c_str());
+    if (!dir) return;
+
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= 4 || name.compare(name.size() - 4, 4, ".idx") != 0) continue;
+        std::string base = packDir + "/" + name.substr(0, name.size() - 4);
+        auto pack = std::make_unique<PackFile>();
+        if (pack->load(base + ".idx", base + ".pack")) {
+            packs_.push_back(std::move(pack));
+        }
+    }
+    closedir(dir);
+}
+
+bool GitRepository::readObject(const GitObjectId& id, std::string& data, int& type) const {
+    loadPacks();
+    for (const auto& pack : packs_) {
+        if (auto offset = pack->find(id)) {
+            return readPackedObject(*pack, *offset, data, type, 0);
+        }
+    }
+    if (readLooseObject(id, data, type)) {
+        return true;
+    }
+
+    // fetch / gc 之后可能出现新的 pack，重新扫描一次
+    packs_.clear();
+    packsLoaded_ = false;
+    loadPacks();
+    for (const auto& pack : packs_) {
+        if (auto offset = pack->find(id)) {
+            return readPackedObject(*pack, *offset, data, type, 0);
+        }
+    }
+    return false;
+}
+
+bool GitRepository::readLooseObject(const GitObjectId& id, std::string& data, int& type) const {
+#ifdef LEIZI_HAVE_ZLIB
+    std::string hex = formatObjectId(id);
+    std::string path = commonDir_ + "/objects/" + hex.substr(0, 2) + "/" + hex.substr(2);
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    std::string raw;
+    if (!inflateBuffer(file.data, file.size, raw, 0)) return false;
+
+    // "<type> <size>\0<body>"
+    size_t nul = raw.find('\0');
+    if (nul == std::string::npos) return false;
+    std::string header = raw.substr(0, nul);
+    if (header.rfind("commit ", 0) == 0) type = 1;
+    else if (header.rfind("tree ", 0) == 0) type = 2;
+    else if (header.rfind("blob ", 0) == 0) type = 3;
+    else if (header.rfind("tag ", 0) == 0) type = 4;
+    else return false;
+
+    data = raw.substr(nul + 1);
+    return true;
+#else
+    (void)id;
+    (void)data;
+    (void)type;
+    return false;
+#endif
+}
+
+bool GitRepository::readPackedObject(const PackFile& pack, std::uint64_t offset, std::string& data,
+                                     int& type, int depth) const {
+#ifdef LEIZI_HAVE_ZLIB
+    if (depth > MAX_DELTA_DEPTH || offset >= pack.pack.size) return false;
+
+    const unsigned char* p = pack.pack.data + offset;
+    const unsigned char* end = pack.pack.data + pack.pack.size;
+
+    unsigned char c = *p++;
+    int objType = (c >> 4) & 7;
+    size_t size = c & 15;
+    int shift = 4;
+    while ((c & 0x80) && p < end) {
+        c = *p++;
+        size |= static_cast<size_t>(c & 0x7f) << shift;
+        shift += 7;
+    }
+
+    if (objType == OBJ_OFS_DELTA || objType == OBJ_REF_DELTA) {
+        std::string base;
+        int baseType = 0;
+
+        if (objType == OBJ_OFS_DELTA) {
+            if (p >= end) return false;
+            c = *p++;
+            std::uint64_t rel = c & 0x7f;
+            while ((c & 0x80) && p < end) {
+                c = *p++;
+                rel = ((rel + 1) << 7) | (c & 0x7f);
+            }
+            if (rel > offset) return false;
+            if (!readPackedObject(pack, offset - rel, base, baseType, depth + 1)) return false;
+        } else {
+            if (end - p < 20) return false;
+            GitObjectId baseId;
+            std::memcpy(baseId.data(), p, 20);
+            p += 20;
+            if (!readObject(baseId, base, baseType)) return false;
+        }
+
+        std::string delta;
+        if (!inflateBuffer(p, static_cast<size_t>(end - p), delta, size)) return false;
+        type = baseType;
+        return applyDelta(base, delta, data);
+    }
+
+    type = objType;
+    return inflateBuffer(p, static_cast<size_t>(end - p), data, size);
+#else
+    (void)pack;
+    (void)offset;
+    (void)data;
+    (void)type;
+    (void)depth;
+    return false;
+#endif
+}
+
+bool GitRepository::readCommit(const GitObjectId& id, std::vector<GitObjectId>& parents,
+                               std::int64_t& commitTime) const {
+    std::string data;
+    int type = 0;
+    if (!readObject(id, data, type) || type != OBJ_COMMIT) return false;
+
+    parents.clear();
+    commitTime = 0;
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t eol = data.find('\n', pos);
+        if (eol == std::string::npos || eol == pos) break;  // 空行之后是提交信息
+
+        if (data.compare(pos, 7, "parent ") == 0) {
+            GitObjectId parent;
+            if (parseObjectId(data.substr(pos + 7, 40), parent)) {
+                parents.push_back(parent);
+            }
+        } else if (data.compare(pos, 10, "committer ") == 0) {
+            // committer Name <email> 1700000000 +0800
+            size_t gt = data.rfind('>', eol);
+            if (gt != std::string::npos && gt > pos) {
+                commitTime = std::strtoll(data.c_str() + gt + 1, nullptr, 10);
+            }
+        }
+        pos = eol + 1;
+    }
+    return true;
+}
+
+std::optional<GitRepository::AheadBehind> GitRepository::aheadBehind(const std::string& local,
+                                                                     const std::string& upstream,
+                                                                     size_t maxCommits) const {
+    AheadBehind result;
+    if (local == upstream) return result;
+
+    GitObjectId localId;
+    GitObjectId upstreamId;
+    if (!parseObjectId(local, localId) || !parseObjectId(upstream, upstreamId)) return std::nullopt;
+
+    // 按提交时间从新到旧遍历，给两侧祖先分别染色；
+    // 队列中只剩两侧共同祖先时即可停止（与 git 的 paint-down 思路一致）
+    constexpr unsigned LOCAL = 1;
+    constexpr unsigned UPSTREAM = 2;
+    constexpr unsigned BOTH = LOCAL | UPSTREAM;
+
+    struct Node {
+        unsigned flags = 0;
+        std::int64_t time = 0;
+        bool queued = false;
+        bool loaded = false;
+        std::vector<GitObjectId> parents;
+    };
+
+    std::unordered_map<GitObjectId, Node, ObjectIdHash> nodes;
+    using Entry = std::pair<std::int64_t, GitObjectId>;
+    std::priority_queue<Entry> queue;
+    size_t activeInQueue = 0;  // 队列中尚未染成 BOTH 的节点数
+
+    auto load = [&](const GitObjectId& id, Node& node) {
+        if (!node.loaded) {
+            node.loaded = true;
+            if (!readCommit(id, node.parents, node.time)) return false;
+        }
+        return true;
+    };
+
+    auto paint = [&](const GitObjectId& id, unsigned flags) {
+        Node& node = nodes[id];
+        unsigned merged = node.flags | flags;
+        if (merged == node.flags) return true;
+        if (!load(id, node)) return false;
+
+        if (node.queued) {
+            if (merged == BOTH && node.flags != BOTH) --activeInQueue;
+        } else {
+            node.queued = true;
+            queue.emplace(node.time, id);
+            if (merged != BOTH) ++activeInQueue;
+        }
+        node.flags = merged;
+        return true;
+    };
+
+    if (!paint(localId, LOCAL) || !paint(upstreamId, UPSTREAM)) return std::nullopt;
+
+    size_t visited = 0;
+    while (!queue.empty() && activeInQueue > 0) {
+        if (visited++ >= maxCommits) {
+            result.truncated = true;
+            break;
+        }
+
+        GitObjectId id = queue.top().second;
+        queue.pop();
+        Node& node = nodes[id];
+        node.queued = false;
+        unsigned flags = node.flags;
+        if (flags != BOTH) --activeInQueue;
+
+        std::vector<GitObjectId> parents = node.parents;
+        for (const auto& parent : parents) {
+            if (!paint(parent, flags)) return std::nullopt;
+        }
+    }
+
+    // 提交时间相同或时钟偏差时，共同祖先可能晚于其父提交出队；
+    // 把剩余的 BOTH 标记补传给已访问过的节点，避免误计数
+    while (!result.truncated && !queue.empty()) {
+        GitObjectId id = queue.top().second;
+        queue.pop();
+        Node& node = nodes[id];
+        node.queued = false;
+        unsigned flags = node.flags;
+
+        std::vector<GitObjectId> parents = node.parents;
+        for (const auto& parent : parents) {
+            auto it = nodes.find(parent);
+            if (it != nodes.end() && (it->second.flags | flags) != it->second.flags) {
+                if (!paint(parent, flags)) return std::nullopt;
+            }
+        }
+    }
+
+    for (const auto& [id, node] : nodes) {
+        if (node.flags == LOCAL) ++result.ahead;
+        else if (node.flags == UPSTREAM) ++result.behind;
+    }
+    return result;
+}
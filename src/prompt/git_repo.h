@@ -0,0 +1,127 @@
+#ifndef LEIZI_PROMPT_GIT_REPO_H
+#define LEIZI_PROMPT_GIT_REPO_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Git 对象 ID（SHA-1，20 字节）
+ */
+using GitObjectId = std::array<unsigned char, 20>;
+
+/**
+ * @brief 原生 Git 仓库读取器
+ *
+ * 直接解析 .git 目录下的文件（HEAD、refs、packed-refs、config、
+ * 松散对象与 pack 文件），不启动 git 子进程。
+ * 只实现提示符需要的只读功能。
+ */
+class GitRepository {
+public:
+    /**
+     * @brief 从 startDir 向上查找仓库（支持 GIT_DIR、.git 文件与 worktree）
+     * @return 找不到仓库时返回 nullopt
+     */
+    static std::optional<GitRepository> discover(const std::string& startDir);
+
+    GitRepository(GitRepository&&) noexcept;
+    GitRepository& operator=(GitRepository&&) noexcept;
+    ~GitRepository();
+
+    const std::string& gitDir() const { return gitDir_; }
+    const std::string& commonDir() const { return commonDir_; }
+
+    /**
+     * @brief HEAD 信息
+     */
+    struct Head {
+        std::string branch;     // 分支名（不含 refs/heads/），分离头指针时为空
+        std::string commit;     // HEAD 指向的提交（40 位十六进制），空仓库时为空
+        bool detached = false;
+    };
+
+    Head readHead() const;
+
+    /**
+     * @brief 解析引用（先查松散引用，再查 packed-refs）
+     * @param ref 完整引用名，如 refs/heads/main
+     * @return 40 位十六进制提交 ID，不存在时为空
+     */
+    std::string resolveRef(const std::string& ref) const;
+
+    /**
+     * @brief 根据 .git/config 的 [branch "name"] 段求上游引用
+     * @return 如 refs/remotes/origin/main，未配置上游时为 nullopt
+     */
+    std::optional<std::string> upstreamRef(const std::string& branch) const;
+
+    /**
+     * @brief 查找恰好指向 commit 的标签名
+     */
+    std::string tagFor(const std::string& commit) const;
+
+    /**
+     * @brief stash 数量（logs/refs/stash 的行数）
+     */
+    int stashCount() const;
+
+    /**
+     * @brief 正在进行的操作：rebase、am、merge、cherry-pick、revert、bisect，无则为空
+     */
+    std::string operationInProgress() const;
+
+    /**
+     * @brief 领先/落后计数
+     */
+    struct AheadBehind {
+        int ahead = 0;
+        int behind = 0;
+        bool truncated = false;  // 达到遍历上限，计数为下限
+    };
+
+    /**
+     * @brief 按提交时间并行遍历两侧祖先，计算 local 相对 upstream 的领先/落后数
+     * @param maxCommits 最多访问的提交数
+     * @return 读取对象失败（或未编译 zlib 支持）时返回 nullopt
+     */
+    std::optional<AheadBehind> aheadBehind(const std::string& local, const std::string& upstream,
+                                           size_t maxCommits) const;
+
+    /**
+     * @brief 读取提交的父提交与提交时间
+     */
+    bool readCommit(const GitObjectId& id, std::vector<GitObjectId>& parents, std::int64_t& commitTime) const;
+
+    static bool parseObjectId(const std::string& hex, GitObjectId& id);
+    static std::string formatObjectId(const GitObjectId& id);
+
+private:
+    struct PackFile;
+
+    GitRepository() = default;
+
+    std::string gitDir_;
+    std::string commonDir_;
+    mutable std::vector<std::unique_ptr<PackFile>> packs_;
+    mutable bool packsLoaded_ = false;
+
+    std::string readFile(const std::string& path) const;
+    std::string packedRef(const std::string& ref) const;
+    void loadPacks() const;
+
+    /**
+     * @brief 读取对象内容
+     * @param type 输出对象类型（1=commit 2=tree 3=blob 4=tag）
+     */
+    bool readObject(const GitObjectId& id, std::string& data, int& type) const;
+    bool readLooseObject(const GitObjectId& id, std::string& data, int& type) const;
+    bool readPackedObject(const PackFile& pack, std::uint64_t offset, std::string& data, int& type,
+                          int depth) const;
+};
+
+#endif // LEIZI_PROMPT_GIT_REPO_H
@@ -1,80 +1,301 @@
 #include "prompt/prompt.h"
 
 #include "prompt/git.h"
+#include "prompt/segments.h"
 #include "utils/colors.h"
 
-#include <chrono>
 #include <ctime>
-#include <pwd.h>
-#include <sstream>
 #include <string>
-#include <unistd.h>
-
-std::string PromptGenerator::generate(const PromptContext& context) const {
-    std::stringstream prompt;
-
-    char hostname[256];
-    gethostname(hostname, sizeof(hostname));
-    struct passwd* pw = getpwuid(getuid());
-    std::string username = pw ? pw->pw_name : "user";
-    bool isRoot = (getuid() == 0);
-
-    prompt << (isRoot ? Color::BRIGHT_RED : Color::BRIGHT_CYAN) << Color::BOLD
-           << username << Color::RESET
-           << Color::BRIGHT_WHITE << "@" << Color::RESET
-           << Color::BRIGHT_GREEN << Color::BOLD << hostname << Color::RESET;
-
-    prompt << " " << Color::BRIGHT_BLUE << Color::BOLD
-           << getDisplayPath(context) << Color::RESET;
-
-    std::string gitBranch = GitIntegration::getBranch();
-    if (!gitBranch.empty()) {
-        prompt << " " << Color::BRIGHT_MAGENTA << "(" << gitBranch << ")" << Color::RESET;
-        std::string gitStatus = GitIntegration::getStatus();
-        if (!gitStatus.empty()) {
-            prompt << " " << gitStatus;
+
+namespace {
+// 常见提示符长度在 200 字节以内，预留足够空间避免重复分配
+constexpr size_t PROMPT_BUFFER_RESERVE = 512;
+
+// readline 的不可见序列起止标记（RL_PROMPT_START_IGNORE / RL_PROMPT_END_IGNORE）
+constexpr char RL_IGNORE_START = '\001';
+constexpr char RL_IGNORE_END = '\002';
+
+// 返回从 pos 开始的 ANSI 转义序列长度，pos 处不是转义序列时返回 0
+size_t escapeLength(std::string_view text, size_t pos) {
+    if (text[pos] != '\033' || pos + 1 >= text.size()) return 0;
+
+    if (text[pos + 1] != '[') {
+        return 2;  // ESC 7 / ESC 8 等两字节序列
+    }
+
+    size_t end = pos + 2;
+    while (end < text.size() && !(text[end] >= 0x40 && text[end] <= 0x7e)) {
+        ++end;
+    }
+    return end < text.size() ? end - pos + 1 : text.size() - pos;
+}
+
+// 把转义序列用 readline 标记包裹起来
+void markInvisible(std::string& text) {
+    std::string marked;
+    marked.reserve(text.size() + 16);
+
+    for (size_t i = 0; i < text.size();) {
+        size_t len = escapeLength(text, i);
+        if (len == 0) {
+            marked += text[i++];
+            continue;
         }
+        marked += RL_IGNORE_START;
+        marked.append(text, i, len);
+        marked += RL_IGNORE_END;
+        i += len;
     }
 
-    if (context.lastExitCode != 0) {
-        prompt << " " << Color::BRIGHT_RED << "[" << context.lastExitCode << "]" << Color::RESET;
+    text.swap(marked);
+}
+} // namespace
+
+PromptGenerator::PromptGenerator() {
+    buffer_.reserve(PROMPT_BUFFER_RESERVE);
+    buildDefaultSegments();
+}
+
+void PromptGenerator::setOptions(const PromptOptions& options) {
+    options_ = options;
+    buildDefaultSegments();
+}
+
+void PromptGenerator::addSegment(std::unique_ptr<PromptSegment> segment, SegmentAlign align) {
+    SegmentSlot slot;
+    slot.segment = std::move(segment);
+    slot.align = align;
+    segments_.push_back(std::move(slot));
+}
+
+void PromptGenerator::clearSegments() {
+    segments_.clear();
+    symbol_ = SegmentSlot{};
+    timings_.clear();
+}
+
+void PromptGenerator::invalidate() {
+    for (auto& slot : segments_) {
+        slot.valid = false;
     }
+    symbol_.valid = false;
+}
+
+void PromptGenerator::buildDefaultSegments() {
+    clearSegments();
+
+    const SegmentAlign statusAlign = options_.rightPrompt ? SegmentAlign::RIGHT : SegmentAlign::LEFT;
+
+    if (options_.showUser) {
+        addSegment(std::make_unique<UserHostSegment>());
+    }
+    addSegment(std::make_unique<PathSegment>());
+    if (options_.showGit) {
+        addSegment(std::make_unique<GitSegment>());
+    }
+    addSegment(std::make_unique<DurationSegment>(options_.durationThresholdMs), statusAlign);
+    addSegment(std::make_unique<ExitCodeSegment>(), statusAlign);
+    if (options_.showTime) {
+        addSegment(std::make_unique<TimeSegment>(), statusAlign);
+    }
+
+    symbol_.segment = std::make_unique<SymbolSegment>(options_.symbol);
+}
+
+const std::string& PromptGenerator::renderSlot(SegmentSlot& slot, const InputSnapshot& inputs) {
+    const unsigned deps = slot.segment->inputs();
+    const PromptContext& context = *inputs.context;
+
+    bool fresh = slot.valid;
+    if (fresh && (deps & PromptInput::CWD) && slot.cwd != context.currentDirectory) fresh = false;
+    if (fresh && (deps & PromptInput::EXIT_CODE) && slot.exitCode != context.lastExitCode) fresh = false;
+    if (fresh && (deps & PromptInput::TIME) && slot.timeSeconds != inputs.timeSeconds) fresh = false;
+    if (fresh && (deps & PromptInput::REPO) && slot.repoStamp != inputs.repoStamp) fresh = false;
+    if (fresh && (deps & PromptInput::COMMAND) && slot.commandNumber != context.commandNumber) fresh = false;
 
-    auto now = std::chrono::system_clock::now();
-    auto asTimeT = std::chrono::system_clock::to_time_t(now);
-    auto tm = *std::localtime(&asTimeT);
-    char timeStr[32];
-    std::strftime(timeStr, sizeof(timeStr), "%H:%M:%S", &tm);
-    prompt << " " << Color::DIM << timeStr << Color::RESET;
+    if (fresh) {
+        timings_.push_back({slot.segment->name(), std::chrono::nanoseconds::zero(), true});
+        return slot.rendered;
+    }
 
-    prompt << "\n";
-    if (isRoot) {
-        prompt << Color::BRIGHT_RED << "# " << Color::RESET;
-    } else {
-        prompt << Color::BRIGHT_GREEN << "❯ " << Color::RESET;
+    auto start = std::chrono::steady_clock::now();
+    slot.rendered.clear();
+    slot.segment->render(context, slot.rendered);
+    slot.width = displayWidth(slot.rendered);
+    if (options_.readlineMarkers) {
+        markInvisible(slot.rendered);
     }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    slot.valid = true;
+    if (deps & PromptInput::CWD) slot.cwd = context.currentDirectory;
+    slot.exitCode = context.lastExitCode;
+    slot.timeSeconds = inputs.timeSeconds;
+    slot.repoStamp = inputs.repoStamp;
+    slot.commandNumber = context.commandNumber;
+
+    timings_.push_back({slot.segment->name(),
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed), false});
+    return slot.rendered;
+}
 
-    return prompt.str();
+void PromptGenerator::appendInvisible(std::string_view sequence) {
+    if (options_.readlineMarkers) buffer_ += RL_IGNORE_START;
+    buffer_ += sequence;
+    if (options_.readlineMarkers) buffer_ += RL_IGNORE_END;
 }
 
-std::string PromptGenerator::getDisplayPath(const PromptContext& context) {
-    std::string displayPath = context.currentDirectory;
+const std::string& PromptGenerator::generate(const PromptContext& context) {
+    timings_.clear();
+    buffer_.clear();
+
+    // 只采集至少一个段落依赖的输入
+    unsigned needed = PromptInput::NONE;
+    for (const auto& slot : segments_) {
+        needed |= slot.segment->inputs();
+    }
+
+    InputSnapshot inputs {&context, 0, 0};
+    if (needed & PromptInput::TIME) {
+        inputs.timeSeconds = static_cast<std::int64_t>(std::time(nullptr));
+    }
+    if (needed & PromptInput::REPO) {
+        inputs.repoStamp = GitIntegration::stateStamp();
+    }
+
+    // 左侧段落直接写入缓冲区，右侧段落先渲染并统计宽度
+    size_t leftWidth = 0;
+    size_t rightWidth = 0;
+    size_t rightCount = 0;
+    bool first = true;
+    for (auto& slot : segments_) {
+        const std::string& rendered = renderSlot(slot, inputs);
+        if (rendered.empty()) continue;
+        if (slot.align == SegmentAlign::RIGHT) {
+            rightWidth += slot.width + (rightCount++ > 0 ? 1 : 0);
+            continue;
+        }
+        if (!first) {
+            buffer_ += ' ';
+            ++leftWidth;
+        }
+        buffer_ += rendered;
+        leftWidth += slot.width;
+        first = false;
+    }
+
+    const std::string* symbol = nullptr;
+    size_t symbolWidth = 0;
+    if (symbol_.segment) {
+        symbol = &renderSlot(symbol_, inputs);
+        symbolWidth = symbol_.width;
+    }
+
+    // 右侧提示符位于信息行末尾，用光标定位代替空格填充。
+    // 单行布局时与输入行共用一行：整段保存/恢复光标，对 readline 而言全部不可见
+    const size_t rightLineUsed = options_.multiline ? leftWidth : leftWidth + 1 + symbolWidth;
+    const bool drawRight = rightCount > 0 && context.columns > 0 &&
+                           rightLineUsed + 1 + rightWidth <= static_cast<size_t>(context.columns);
+    if (drawRight) {
+        const size_t column = static_cast<size_t>(context.columns) - rightWidth + 1;
+        const bool sameLine = !options_.multiline;
 
-    if (!context.homeDirectory.empty() && context.currentDirectory.find(context.homeDirectory) == 0) {
-        if (context.currentDirectory == context.homeDirectory) {
-            displayPath = "~";
+        if (sameLine && options_.readlineMarkers) buffer_ += RL_IGNORE_START;
+        std::string move = sameLine ? "\0337\033[" : "\033[";
+        move += std::to_string(column);
+        move += 'G';
+        if (sameLine) {
+            buffer_ += move;
         } else {
-            displayPath = "~" + context.currentDirectory.substr(context.homeDirectory.length());
+            appendInvisible(move);
+        }
+
+        bool firstRight = true;
+        for (const auto& slot : segments_) {
+            if (slot.align != SegmentAlign::RIGHT || slot.rendered.empty()) continue;
+            if (!firstRight) buffer_ += ' ';
+            if (sameLine) {
+                for (char c : slot.rendered) {
+                    if (c != RL_IGNORE_START && c != RL_IGNORE_END) buffer_ += c;
+                }
+            } else {
+                buffer_ += slot.rendered;
+            }
+            firstRight = false;
+        }
+
+        if (sameLine) {
+            buffer_ += "\0338";
+            if (options_.readlineMarkers) buffer_ += RL_IGNORE_END;
         }
     }
 
-    if (displayPath.length() > 40) {
-        size_t pos = displayPath.find_last_of('/');
-        if (pos != std::string::npos && pos > 3) {
-            displayPath = "..." + displayPath.substr(pos);
+    lastColumns_ = context.columns;
+    lastLinesAbove_ = 0;
+    lastInputLineWidth_ = leftWidth;
+
+    if (symbol_.segment) {
+        if (!first) {
+            if (options_.multiline) {
+                buffer_ += '\n';
+                lastLinesAbove_ = context.columns > 0
+                    ? (leftWidth + context.columns - 1) / static_cast<size_t>(context.columns)
+                    : 1;
+                lastInputLineWidth_ = 0;
+            } else {
+                buffer_ += ' ';
+                ++lastInputLineWidth_;
+            }
         }
+        buffer_ += *symbol;
+        lastInputLineWidth_ += symbolWidth;
     }
 
-    return displayPath;
+    return buffer_;
 }
 
+std::string PromptGenerator::transientLine(std::string_view input) const {
+    if (lastColumns_ <= 0) {
+        return {};
+    }
+
+    // 提示符与输入占用的终端行数（readline 提交后光标位于下一行行首）
+    const size_t columns = static_cast<size_t>(lastColumns_);
+    const size_t inputRowWidth = lastInputLineWidth_ + displayWidth(input);
+    const size_t inputRows = inputRowWidth == 0 ? 1 : (inputRowWidth + columns - 1) / columns;
+    const size_t rows = lastLinesAbove_ + inputRows;
+
+    std::string out;
+    out.reserve(input.size() + options_.transientSymbol.size() + 24);
+    out += "\033[";
+    out += std::to_string(rows);
+    out += "A\r\033[J";
+    out += Color::BRIGHT_GREEN;
+    out += options_.transientSymbol;
+    out += Color::RESET;
+    out += ' ';
+    out += input;
+    out += '\n';
+    return out;
+}
+
+size_t PromptGenerator::displayWidth(std::string_view text) {
+    size_t width = 0;
+    for (size_t i = 0; i < text.size();) {
+        if (text[i] == RL_IGNORE_START) {
+            size_t end = text.find(RL_IGNORE_END, i + 1);
+            i = end == std::string_view::npos ? text.size() : end + 1;
+            continue;
+        }
+        if (size_t len = escapeLength(text, i); len > 0) {
+            i += len;
+            continue;
+        }
+        // 只统计 UTF-8 首字节
+        if ((static_cast<unsigned char>(text[i]) & 0xc0) != 0x80) {
+            ++width;
+        }
+        ++i;
+    }
+    return width;
+}
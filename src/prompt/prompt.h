@@ -1,18 +1,179 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/command_stats.h"
 
 struct PromptContext {
     std::string currentDirectory;
     std::string homeDirectory;
     int lastExitCode = 0;
+    int columns = 0;   // 终端宽度，0 表示未知（此时不绘制右侧提示符）
+    std::uint64_t commandNumber = 0;            // 已执行的命令数
+    const CommandStats* lastCommand = nullptr;  // 上一条命令的耗时与资源占用
+};
+
+/**
+ * @brief 提示符选项，对应配置文件中的 [prompt] 段
+ */
+struct PromptOptions {
+    bool showUser = true;
+    bool showGit = true;
+    bool showTime = true;
+    std::string symbol = "❯";
+    bool multiline = true;      // 信息行与输入行分两行显示
+    bool rightPrompt = false;   // 退出码与时间右对齐显示
+    bool transient = false;     // 提交命令后将提示符折叠为简短标记
+    std::string transientSymbol = "❯";
+    int durationThresholdMs = 2000; // 命令耗时超过该值才显示耗时段落
+    bool readlineMarkers = false; // 用 \001/\002 包裹不可见序列供 readline 计算宽度
+};
+
+/**
+ * @brief 段落的对齐方式
+ */
+enum class SegmentAlign {
+    LEFT,
+    RIGHT
+};
+
+/**
+ * @brief 段落所依赖的输入，任一输入变化时段落才会重新渲染
+ */
+namespace PromptInput {
+enum : unsigned {
+    NONE = 0,            // 会话内不变（用户名、主机名等）
+    CWD = 1u << 0,       // 当前目录
+    EXIT_CODE = 1u << 1, // 上一条命令的退出码
+    TIME = 1u << 2,      // 当前时间（秒级）
+    REPO = 1u << 3,      // Git 仓库状态
+    COMMAND = 1u << 4    // 上一条命令（序号变化即视为变化）
+};
+} // namespace PromptInput
+
+/**
+ * @brief 提示符段落基类
+ *
+ * 每个段落声明自己依赖的输入，由 PromptGenerator 负责缓存渲染结果
+ */
+class PromptSegment {
+public:
+    virtual ~PromptSegment() = default;
+
+    /**
+     * @brief 段落名称，用于耗时统计
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief 依赖的输入集合（PromptInput 位掩码）
+     */
+    virtual unsigned inputs() const = 0;
+
+    /**
+     * @brief 将渲染结果追加到 out，不追加任何内容表示该段落隐藏
+     */
+    virtual void render(const PromptContext& context, std::string& out) = 0;
+};
+
+/**
+ * @brief 单个段落的渲染耗时
+ */
+struct SegmentTiming {
+    const char* name;
+    std::chrono::nanoseconds renderTime;
+    bool cached;
 };
 
 class PromptGenerator {
 public:
-    std::string generate(const PromptContext& context) const;
+    PromptGenerator();
+
+    /**
+     * @brief 应用配置并按配置重建默认段落
+     */
+    void setOptions(const PromptOptions& options);
+    const PromptOptions& options() const { return options_; }
+
+    /**
+     * @brief 追加一个信息行段落（同一侧按添加顺序排列）
+     */
+    void addSegment(std::unique_ptr<PromptSegment> segment, SegmentAlign align = SegmentAlign::LEFT);
+
+    /**
+     * @brief 移除所有段落（包括提示符号）
+     */
+    void clearSegments();
+
+    /**
+     * @brief 生成提示符，返回的引用在下一次调用前有效
+     */
+    const std::string& generate(const PromptContext& context);
+
+    /**
+     * @brief 上一次 generate() 中各段落的耗时明细
+     */
+    const std::vector<SegmentTiming>& lastTimings() const { return timings_; }
+
+    /**
+     * @brief 丢弃所有段落缓存
+     */
+    void invalidate();
+
+    /**
+     * @brief 生成折叠上一个提示符所需的终端输出
+     *
+     * 在命令提交后调用：光标上移到提示符起始行，清除到屏幕末尾，
+     * 再输出简短标记与命令本身，而不是重绘整个提示符
+     * @param input 用户提交的命令行
+     * @return 需要直接写到终端的字节，无法折叠时为空
+     */
+    std::string transientLine(std::string_view input) const;
+
+    /**
+     * @brief 计算字符串的显示宽度，忽略 ANSI 转义序列与 readline 标记
+     */
+    static size_t displayWidth(std::string_view text);
 
 private:
-    static std::string getDisplayPath(const PromptContext& context);
-};
+    struct SegmentSlot {
+        std::unique_ptr<PromptSegment> segment;
+        SegmentAlign align = SegmentAlign::LEFT;
+        std::string rendered;
+        size_t width = 0;
+        bool valid = false;
+
+        // 上次渲染时的输入快照
+        std::string cwd;
+        int exitCode = 0;
+        std::int64_t timeSeconds = 0;
+        std::uint64_t repoStamp = 0;
+        std::uint64_t commandNumber = 0;
+    };
+
+    struct InputSnapshot {
+        const PromptContext* context;
+        std::int64_t timeSeconds;
+        std::uint64_t repoStamp;
+    };
 
+    PromptOptions options_;
+    std::vector<SegmentSlot> segments_;
+    SegmentSlot symbol_;
+    std::string buffer_;
+    std::vector<SegmentTiming> timings_;
+
+    // 上一次生成的提示符几何信息，供 transientLine() 使用
+    int lastColumns_ = 0;
+    size_t lastLinesAbove_ = 0;
+    size_t lastInputLineWidth_ = 0;
+
+    void buildDefaultSegments();
+    void appendInvisible(std::string_view sequence);
+    const std::string& renderSlot(SegmentSlot& slot, const InputSnapshot& inputs);
+};
@@ -0,0 +1,211 @@
+#include "prompt/segments.h"
+
+#include "prompt/git.h"
+#include "utils/colors.h"
+
+#include <cstdio>
+#include <ctime>
+#include <pwd.h>
+#include <string>
+#include <unistd.h>
+
+void UserHostSegment::render(const PromptContext& /*context*/, std::string& out) {
+    char hostname[256] = {};
+    gethostname(hostname, sizeof(hostname) - 1);
+    struct passwd* pw = getpwuid(getuid());
+    const char* username = pw ? pw->pw_name : "user";
+    bool isRoot = (getuid() == 0);
+
+    out += isRoot ? Color::BRIGHT_RED : Color::BRIGHT_CYAN;
+    out += Color::BOLD;
+    out += username;
+    out += Color::RESET;
+    out += Color::BRIGHT_WHITE;
+    out += '@';
+    out += Color::RESET;
+    out += Color::BRIGHT_GREEN;
+    out += Color::BOLD;
+    out += hostname;
+    out += Color::RESET;
+}
+
+void PathSegment::render(const PromptContext& context, std::string& out) {
+    out += Color::BRIGHT_BLUE;
+    out += Color::BOLD;
+    out += displayPath(context);
+    out += Color::RESET;
+}
+
+std::string PathSegment::displayPath(const PromptContext& context) {
+    std::string displayPath = context.currentDirectory;
+
+    if (!context.homeDirectory.empty() && context.currentDirectory.find(context.homeDirectory) == 0) {
+        if (context.currentDirectory == context.homeDirectory) {
+            displayPath = "~";
+        } else {
+            displayPath = "~" + context.currentDirectory.substr(context.homeDirectory.length());
+        }
+    }
+
+    if (displayPath.length() > 40) {
+        size_t pos = displayPath.find_last_of('/');
+        if (pos != std::string::npos && pos > 3) {
+            displayPath = "..." + displayPath.substr(pos);
+        }
+    }
+
+    return displayPath;
+}
+
+const char* GitSegment::operationLabel(const std::string& operation) {
+    if (operation == "rebase") return "REBASE";
+    if (operation == "am") return "AM";
+    if (operation == "merge") return "MERGING";
+    if (operation == "cherry-pick") return "CHERRY-PICKING";
+    if (operation == "revert") return "REVERTING";
+    if (operation == "bisect") return "BISECTING";
+    return operation.c_str();
+}
+
+void GitSegment::render(const PromptContext& /*context*/, std::string& out) {
+    std::string gitBranch = GitIntegration::getBranch();
+    if (gitBranch.empty()) {
+        return;
+    }
+
+    GitRepoState state = GitIntegration::getRepoState();
+
+    out += Color::BRIGHT_MAGENTA;
+    out += '(';
+    out += gitBranch;
+    if (!state.operation.empty()) {
+        out += Color::BRIGHT_RED;
+        out += '|';
+        out += operationLabel(state.operation);
+        out += Color::BRIGHT_MAGENTA;
+    }
+    out += ')';
+    out += Color::RESET;
+
+    if (state.ahead > 0 || state.behind > 0) {
+        out += ' ';
+        out += Color::CYAN;
+        if (state.ahead > 0) {
+            out += "⇡";
+            out += std::to_string(state.ahead);
+        }
+        if (state.behind > 0) {
+            out += "⇣";
+            out += std::to_string(state.behind);
+        }
+        if (state.truncated) {
+            out += '+';
+        }
+        out += Color::RESET;
+    }
+
+    if (state.stashes > 0) {
+        out += ' ';
+        out += Color::DIM;
+        out += '*';
+        out += std::to_string(state.stashes);
+        out += Color::RESET;
+    }
+
+    std::string gitStatus = GitIntegration::getStatus();
+    if (!gitStatus.empty()) {
+        out += ' ';
+        out += gitStatus;
+    }
+}
+
+void ExitCodeSegment::render(const PromptContext& context, std::string& out) {
+    if (context.lastExitCode == 0) {
+        return;
+    }
+
+    out += Color::BRIGHT_RED;
+    out += '[';
+    out += std::to_string(context.lastExitCode);
+    out += ']';
+    out += Color::RESET;
+}
+
+void DurationSegment::render(const PromptContext& context, std::string& out) {
+    const CommandStats* stats = context.lastCommand;
+    if (!stats || context.commandNumber == 0) {
+        return;
+    }
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(stats->wallTime).count() < thresholdMs_) {
+        return;
+    }
+
+    out += Color::YELLOW;
+    out += "took ";
+    out += formatDuration(stats->wallTime);
+    out += Color::RESET;
+
+    // 只有外部命令才有子进程资源占用
+    if (stats->processes > 0) {
+        out += Color::DIM;
+        out += " cpu ";
+        out += formatDuration(stats->cpuTime());
+        out += " rss ";
+        if (stats->maxRssKb >= 1024 * 1024) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.1fG", stats->maxRssKb / (1024.0 * 1024.0));
+            out += buf;
+        } else if (stats->maxRssKb >= 1024) {
+            out += std::to_string(stats->maxRssKb / 1024);
+            out += 'M';
+        } else {
+            out += std::to_string(stats->maxRssKb);
+            out += 'K';
+        }
+        out += Color::RESET;
+    }
+}
+
+std::string DurationSegment::formatDuration(std::chrono::nanoseconds duration) {
+    using namespace std::chrono;
+    const long long ms = duration_cast<milliseconds>(duration).count();
+    char buf[32];
+
+    if (ms < 1000) {
+        std::snprintf(buf, sizeof(buf), "%lldms", ms);
+    } else if (ms < 60 * 1000) {
+        std::snprintf(buf, sizeof(buf), "%.1fs", ms / 1000.0);
+    } else if (ms < 60 * 60 * 1000) {
+        std::snprintf(buf, sizeof(buf), "%lldm%02llds", ms / 60000, (ms / 1000) % 60);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%lldh%02lldm", ms / 3600000, (ms / 60000) % 60);
+    }
+    return buf;
+}
+
+void TimeSegment::render(const PromptContext& /*context*/, std::string& out) {
+    std::time_t now = std::time(nullptr);
+    std::tm tm {};
+    localtime_r(&now, &tm);
+    char timeStr[32];
+    std::strftime(timeStr, sizeof(timeStr), "%H:%M:%S", &tm);
+
+    out += Color::DIM;
+    out += timeStr;
+    out += Color::RESET;
+}
+
+void SymbolSegment::render(const PromptContext& /*context*/, std::string& out) {
+    static const std::string defaultSymbol = PromptOptions().symbol;
+    if (getuid() == 0) {
+        // 默认符号对 root 换成 #；配置的符号照常使用，只用红色提示
+        out += Color::BRIGHT_RED;
+        out += symbol_ == defaultSymbol ? "#" : symbol_;
+        out += ' ';
+    } else {
+        out += Color::BRIGHT_GREEN;
+        out += symbol_;
+        out += ' ';
+    }
+    out += Color::RESET;
+}
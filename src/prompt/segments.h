@@ -0,0 +1,85 @@
+#pragma once
+
+#include "prompt/prompt.h"
+
+#include <string>
+
+// 内置提示符段落。每个段落只负责渲染自身，缓存由 PromptGenerator 管理。
+
+// user@host，会话内只计算一次
+class UserHostSegment : public PromptSegment {
+public:
+    const char* name() const override { return "user"; }
+    unsigned inputs() const override { return PromptInput::NONE; }
+    void render(const PromptContext& context, std::string& out) override;
+};
+
+// 当前目录，家目录缩写为 ~，过长时截断
+class PathSegment : public PromptSegment {
+public:
+    const char* name() const override { return "path"; }
+    unsigned inputs() const override { return PromptInput::CWD; }
+    void render(const PromptContext& context, std::string& out) override;
+
+    static std::string displayPath(const PromptContext& context);
+};
+
+// Git 分支、进行中的操作、领先/落后、stash 数与工作区状态
+class GitSegment : public PromptSegment {
+public:
+    const char* name() const override { return "git"; }
+    unsigned inputs() const override { return PromptInput::CWD | PromptInput::REPO; }
+    void render(const PromptContext& context, std::string& out) override;
+
+    /**
+     * @brief 进行中操作的显示名，如 rebase -> REBASE、merge -> MERGING
+     */
+    static const char* operationLabel(const std::string& operation);
+};
+
+// 非零退出码
+class ExitCodeSegment : public PromptSegment {
+public:
+    const char* name() const override { return "exit_code"; }
+    unsigned inputs() const override { return PromptInput::EXIT_CODE; }
+    void render(const PromptContext& context, std::string& out) override;
+};
+
+// 上一条命令的耗时与资源占用，超过阈值才显示
+class DurationSegment : public PromptSegment {
+public:
+    explicit DurationSegment(int thresholdMs) : thresholdMs_(thresholdMs) {}
+
+    const char* name() const override { return "duration"; }
+    unsigned inputs() const override { return PromptInput::COMMAND; }
+    void render(const PromptContext& context, std::string& out) override;
+
+    /**
+     * @brief 把时长格式化为 850ms / 3.2s / 2m05s / 1h02m
+     */
+    static std::string formatDuration(std::chrono::nanoseconds duration);
+
+private:
+    int thresholdMs_;
+};
+
+// HH:MM:SS 时钟
+class TimeSegment : public PromptSegment {
+public:
+    const char* name() const override { return "time"; }
+    unsigned inputs() const override { return PromptInput::TIME; }
+    void render(const PromptContext& context, std::string& out) override;
+};
+
+// 输入行前的提示符号，root 用户显示红色的 #（除非配置了其它符号）
+class SymbolSegment : public PromptSegment {
+public:
+    explicit SymbolSegment(std::string symbol) : symbol_(std::move(symbol)) {}
+
+    const char* name() const override { return "symbol"; }
+    unsigned inputs() const override { return PromptInput::NONE; }
+    void render(const PromptContext& context, std::string& out) override;
+
+private:
+    std::string symbol_;
+};
@@ -0,0 +1,565 @@
+#include "utils/arithmetic.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <utility>
+
+#include "utils/variables.h"
+
+namespace {
+
+using Op = ArithmeticProgram::Op;
+
+// 变量值按表达式递归求值的最大深度
+constexpr int MAX_RECURSION = 32;
+
+struct Token {
+    enum class Kind { End, Number, Name, Operator, Invalid };
+    Kind kind = Kind::End;
+    std::string_view text;
+    std::int64_t value = 0;
+};
+
+const char* const OPERATORS[] = {
+    "<<=", ">>=", "**", "++", "--", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||",
+    "*=", "/=", "%=", "+=", "-=", "&=", "^=", "|=",
+    "+", "-", "*", "/", "%", "<", ">", "=", "!", "~", "&", "^", "|", "?", ":", ",", "(", ")"
+};
+
+// 二元运算符的优先级（数字越大结合越紧），不是二元运算符时为 0
+int binaryPrecedence(std::string_view op) {
+    if (op == "||") return 1;
+    if (op == "&&") return 2;
+    if (op == "|") return 3;
+    if (op == "^") return 4;
+    if (op == "&") return 5;
+    if (op == "==" || op == "!=") return 6;
+    if (op == "<" || op == "<=" || op == ">" || op == ">=") return 7;
+    if (op == "<<" || op == ">>") return 8;
+    if (op == "+" || op == "-") return 9;
+    if (op == "*" || op == "/" || op == "%") return 10;
+    return 0;
+}
+
+Op binaryOp(std::string_view op) {
+    if (op == "|") return Op::BitOr;
+    if (op == "^") return Op::BitXor;
+    if (op == "&") return Op::BitAnd;
+    if (op == "==") return Op::Equal;
+    if (op == "!=") return Op::NotEqual;
+    if (op == "<") return Op::Less;
+    if (op == "<=") return Op::LessEqual;
+    if (op == ">") return Op::Greater;
+    if (op == ">=") return Op::GreaterEqual;
+    if (op == "<<") return Op::Shl;
+    if (op == ">>") return Op::Shr;
+    if (op == "+") return Op::Add;
+    if (op == "-") return Op::Sub;
+    if (op == "*") return Op::Mul;
+    if (op == "/") return Op::Div;
+    return Op::Mod;
+}
+
+bool isAssignment(std::string_view op) {
+    return op == "=" || (op.size() >= 2 && op.back() == '=' && op != "==" && op != "!=" && op != "<=" &&
+                         op != ">=");
+}
+
+// 数字常量：十进制、0 开头的八进制、0x 十六进制与 base#digits
+bool parseNumber(std::string_view text, std::int64_t& value) {
+    int base = 10;
+    if (auto hash = text.find('#'); hash != std::string_view::npos) {
+        base = 0;
+        for (char c : text.substr(0, hash)) {
+            if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+            base = base * 10 + (c - '0');
+            if (base > 64) return false;
+        }
+        if (base < 2) return false;
+        text.remove_prefix(hash + 1);
+    } else if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        base = 16;
+        text.remove_prefix(2);
+    } else if (text.size() > 1 && text[0] == '0') {
+        base = 8;
+        text.remove_prefix(1);
+    }
+    if (text.empty()) return false;
+
+    std::uint64_t result = 0;
+    for (char c : text) {
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'z') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'Z') digit = c - 'A' + (base <= 36 ? 10 : 36);
+        else if (c == '@') digit = 62;
+        else if (c == '_') digit = 63;
+        else return false;
+        if (digit >= base) return false;
+        result = result * static_cast<std::uint64_t>(base) + static_cast<std::uint64_t>(digit);
+    }
+    value = static_cast<std::int64_t>(result);
+    return true;
+}
+
+/**
+ * 递归下降编译器：按优先级逐层解析，边解析边生成字节码
+ */
+class Compiler {
+public:
+    Compiler(std::string_view source, ArithmeticProgram& program) : source_(source), program_(program) {}
+
+    bool compile(std::string& error) {
+        advance();
+        if (token_.kind != Token::Kind::End) {
+            parseComma();
+        }
+        if (error_.empty() && token_.kind != Token::Kind::End) {
+            fail("syntax error in expression");
+        }
+        if (!error_.empty()) {
+            error = error_;
+            return false;
+        }
+        if (program_.code.empty()) {
+            emit(Op::Push, 0);
+        }
+        return true;
+    }
+
+private:
+    std::string_view source_;
+    size_t pos_ = 0;
+    Token token_;
+    ArithmeticProgram& program_;
+    std::string error_;
+
+    void fail(const std::string& message) {
+        if (!error_.empty()) return;
+        const size_t at = token_.kind == Token::Kind::End
+                              ? source_.size()
+                              : static_cast<size_t>(token_.text.data() - source_.data());
+        error_ = message + " (error token is \"" + std::string(source_.substr(at)) + "\")";
+    }
+
+    void advance() {
+        while (pos_ < source_.size() && std::isspace(static_cast<unsigned char>(source_[pos_]))) ++pos_;
+        token_ = Token();
+        if (pos_ >= source_.size()) {
+            token_.text = source_.substr(source_.size());
+            return;
+        }
+
+        const size_t start = pos_;
+        const char c = source_[pos_];
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            while (pos_ < source_.size() &&
+                   (std::isalnum(static_cast<unsigned char>(source_[pos_])) || source_[pos_] == '#' ||
+                    source_[pos_] == '@' || source_[pos_] == '_')) {
+                ++pos_;
+            }
+            token_.text = source_.substr(start, pos_ - start);
+            token_.kind = parseNumber(token_.text, token_.value) ? Token::Kind::Number : Token::Kind::Invalid;
+            return;
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            while (pos_ < source_.size() &&
+                   (std::isalnum(static_cast<unsigned char>(source_[pos_])) || source_[pos_] == '_')) {
+                ++pos_;
+            }
+            token_.kind = Token::Kind::Name;
+            token_.text = source_.substr(start, pos_ - start);
+            return;
+        }
+        for (const char* op : OPERATORS) {
+            std::string_view candidate(op);
+            if (source_.compare(start, candidate.size(), candidate) == 0) {
+                pos_ += candidate.size();
+                token_.kind = Token::Kind::Operator;
+                token_.text = source_.substr(start, candidate.size());
+                return;
+            }
+        }
+        token_.kind = Token::Kind::Invalid;
+        token_.text = source_.substr(start, 1);
+    }
+
+    bool accept(std::string_view op) {
+        if (token_.kind == Token::Kind::Operator && token_.text == op) {
+            advance();
+            return true;
+        }
+        return false;
+    }
+
+    size_t emit(Op op, std::int64_t operand = 0) {
+        program_.code.push_back({op, operand});
+        return program_.code.size() - 1;
+    }
+
+    void patch(size_t jump) {
+        program_.code[jump].operand = static_cast<std::int64_t>(program_.code.size());
+    }
+
+    std::int64_t nameIndex(std::string_view name) {
+        for (size_t i = 0; i < program_.names.size(); ++i) {
+            if (program_.names[i] == name) return static_cast<std::int64_t>(i);
+        }
+        program_.names.emplace_back(name);
+        program_.ids.push_back(NameTable::instance().intern(name));
+        return static_cast<std::int64_t>(program_.names.size() - 1);
+    }
+
+    // expr , expr
+    void parseComma() {
+        parseAssignment();
+        while (error_.empty() && accept(",")) {
+            emit(Op::Pop);
+            parseAssignment();
+        }
+    }
+
+    // name op= expr（右结合），否则为条件表达式
+    void parseAssignment() {
+        if (token_.kind == Token::Kind::Name) {
+            const size_t saved = pos_;
+            const Token name = token_;
+            advance();
+            if (token_.kind == Token::Kind::Operator && isAssignment(token_.text)) {
+                const std::string_view op = token_.text;
+                const std::int64_t slot = nameIndex(name.text);
+                advance();
+                if (op != "=") emit(Op::Load, slot);
+                parseAssignment();
+                if (op != "=") emit(binaryOp(op.substr(0, op.size() - 1)));
+                emit(Op::Store, slot);
+                return;
+            }
+            pos_ = saved;
+            token_ = name;
+        }
+        parseConditional();
+    }
+
+    // cond ? expr : cond
+    void parseConditional() {
+        parseBinary(1);
+        if (!error_.empty() || !accept("?")) return;
+
+        const size_t toElse = emit(Op::JumpIfZero);
+        parseAssignment();
+        if (error_.empty() && !accept(":")) {
+            fail("`:' expected for conditional expression");
+            return;
+        }
+        const size_t toEnd = emit(Op::Jump);
+        patch(toElse);
+        parseAssignment();
+        patch(toEnd);
+    }
+
+    // 左结合的二元运算；&& 与 || 短路
+    void parseBinary(int minPrecedence) {
+        parsePower();
+        while (error_.empty() && token_.kind == Token::Kind::Operator) {
+            const std::string_view op = token_.text;
+            const int precedence = binaryPrecedence(op);
+            if (precedence < minPrecedence || precedence == 0) return;
+            advance();
+
+            if (op == "&&" || op == "||") {
+                const size_t shortCircuit = emit(op == "&&" ? Op::JumpIfZero : Op::JumpIfNonZero);
+                parseBinary(precedence + 1);
+                emit(Op::Bool);
+                const size_t toEnd = emit(Op::Jump);
+                patch(shortCircuit);
+                emit(Op::Push, op == "&&" ? 0 : 1);
+                patch(toEnd);
+            } else {
+                parseBinary(precedence + 1);
+                emit(binaryOp(op));
+            }
+        }
+    }
+
+    // unary ** power（右结合）
+    void parsePower() {
+        parseUnary();
+        if (error_.empty() && accept("**")) {
+            parsePower();
+            emit(Op::Pow);
+        }
+    }
+
+    void parseUnary() {
+        if (token_.kind == Token::Kind::Operator) {
+            const std::string_view op = token_.text;
+            if (op == "++" || op == "--") {
+                advance();
+                if (token_.kind != Token::Kind::Name) {
+                    fail("syntax error: operand expected");
+                    return;
+                }
+                const std::int64_t slot = nameIndex(token_.text);
+                advance();
+                emit(Op::Load, slot);
+                emit(Op::Push, 1);
+                emit(op == "++" ? Op::Add : Op::Sub);
+                emit(Op::Store, slot);
+                return;
+            }
+            if (op == "-" || op == "+" || op == "!" || op == "~") {
+                advance();
+                parseUnary();
+                if (op == "-") emit(Op::Negate);
+                else if (op == "!") emit(Op::Not);
+                else if (op == "~") emit(Op::BitNot);
+                return;
+            }
+        }
+        parsePostfix();
+    }
+
+    void parsePostfix() {
+        switch (token_.kind) {
+            case Token::Kind::Number:
+                emit(Op::Push, token_.value);
+                advance();
+                return;
+            case Token::Kind::Name: {
+                const std::int64_t slot = nameIndex(token_.text);
+                advance();
+                emit(Op::Load, slot);
+                if (token_.kind == Token::Kind::Operator && (token_.text == "++" || token_.text == "--")) {
+                    // 旧值留在栈上
+                    emit(Op::Load, slot);
+                    emit(Op::Push, 1);
+                    emit(token_.text == "++" ? Op::Add : Op::Sub);
+                    emit(Op::Store, slot);
+                    emit(Op::Pop);
+                    advance();
+                }
+                return;
+            }
+            case Token::Kind::Operator:
+                if (accept("(")) {
+                    parseComma();
+                    if (error_.empty() && !accept(")")) {
+                        fail("missing `)'");
+                    }
+                    return;
+                }
+                break;
+            case Token::Kind::Invalid:
+                fail(std::isdigit(static_cast<unsigned char>(token_.text.front())) ? "value too great for base"
+                                                                                    : "syntax error: invalid arithmetic operator");
+                return;
+            case Token::Kind::End:
+                break;
+        }
+        fail("syntax error: operand expected");
+    }
+};
+
+// 整数运算按补码回绕，避免有符号溢出
+std::int64_t wrap(std::uint64_t value) {
+    return static_cast<std::int64_t>(value);
+}
+
+} // namespace
+
+ArithmeticEngine::ArithmeticEngine(size_t cacheSize) : capacity_(cacheSize == 0 ? 1 : cacheSize) {}
+
+bool ArithmeticEngine::compile(std::string_view expression, ArithmeticProgram& program, std::string& error) {
+    program = ArithmeticProgram();
+    return Compiler(expression, program).compile(error);
+}
+
+std::shared_ptr<const ArithmeticProgram> ArithmeticEngine::lookup(std::string_view expression, std::string& error) {
+    if (auto found = index_.find(expression); found != index_.end()) {
+        cache_.splice(cache_.begin(), cache_, found->second);
+        return found->second->program;
+    }
+
+    auto program = std::make_shared<ArithmeticProgram>();
+    ++compiles_;
+    if (!compile(expression, *program, error)) {
+        return nullptr;
+    }
+
+    if (cache_.size() >= capacity_) {
+        index_.erase(cache_.back().source);
+        cache_.pop_back();
+    }
+    cache_.push_front(CacheEntry{std::string(expression), program});
+    index_.emplace(cache_.front().source, cache_.begin());
+    return program;
+}
+
+bool ArithmeticEngine::evaluate(std::string_view expression, VariableManager& variables, std::int64_t& result,
+                                std::string& error) {
+    return evaluate(expression, variables, result, error, 0);
+}
+
+bool ArithmeticEngine::evaluate(std::string_view expression, VariableManager& variables, std::int64_t& result,
+                                std::string& error, int depth) {
+    auto program = lookup(expression, error);
+    return program && run(*program, variables, result, error, depth);
+}
+
+bool ArithmeticEngine::load(NameId name, VariableManager& variables, std::int64_t& value, std::string& error,
+                            int depth) {
+    std::string text;
+    if (const Variable* variable = std::as_const(variables).get(name)) {
+        if (variable->type() == VarType::INTEGER) {
+            value = variable->intValue();
+            return true;
+        }
+        text = variable->toString();
+    } else if (const char* env = std::getenv(NameTable::instance().name(name).c_str())) {
+        text = env;
+    }
+
+    // 常见情况：十进制整数，直接转换；其余（八进制、十六进制、表达式）按表达式求值
+    size_t first = text.find_first_not_of(" \t\n");
+    if (first == std::string::npos) {
+        value = 0;
+        return true;
+    }
+    size_t last = text.find_last_not_of(" \t\n");
+    std::string_view digits(text.data() + first, last + 1 - first);
+    const bool negative = digits.front() == '-';
+    if (negative || digits.front() == '+') digits.remove_prefix(1);
+    if (!digits.empty() && digits.size() <= 18 && (digits.front() != '0' || digits.size() == 1) &&
+        digits.find_first_not_of("0123456789") == std::string_view::npos) {
+        std::int64_t parsed = 0;
+        for (char c : digits) parsed = parsed * 10 + (c - '0');
+        value = negative ? -parsed : parsed;
+        return true;
+    }
+
+    if (depth >= MAX_RECURSION) {
+        error = NameTable::instance().name(name) + ": expression recursion level exceeded";
+        return false;
+    }
+    return evaluate(text, variables, value, error, depth + 1);
+}
+
+bool ArithmeticEngine::run(const ArithmeticProgram& program, VariableManager& variables, std::int64_t& result,
+                           std::string& error, int depth) {
+    // 嵌套求值（变量值为表达式）共用同一个栈，只使用 base 之上的部分
+    const size_t base = stack_.size();
+    auto pop = [&]() {
+        const std::int64_t value = stack_.back();
+        stack_.pop_back();
+        return value;
+    };
+    auto failed = [&](std::string message) {
+        error = std::move(message);
+        stack_.resize(base);
+        return false;
+    };
+
+    const auto& code = program.code;
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        const auto& instruction = code[pc];
+        switch (instruction.op) {
+            case Op::Push:
+                stack_.push_back(instruction.operand);
+                break;
+            case Op::Load: {
+                std::int64_t value = 0;
+                if (!load(program.ids[static_cast<size_t>(instruction.operand)], variables, value, error, depth)) {
+                    stack_.resize(base);
+                    return false;
+                }
+                stack_.push_back(value);
+                break;
+            }
+            case Op::Store: {
+                const auto slot = static_cast<size_t>(instruction.operand);
+                const NameId name = program.ids[slot];
+                if (const Variable* existing = std::as_const(variables).get(name); existing && existing->isReadonly) {
+                    return failed(program.names[slot] + ": readonly variable");
+                }
+                variables.set(name, Variable(stack_.back()));
+                break;
+            }
+            case Op::Pop:
+                stack_.pop_back();
+                break;
+            case Op::Negate:
+                stack_.back() = wrap(0 - static_cast<std::uint64_t>(stack_.back()));
+                break;
+            case Op::Not:
+                stack_.back() = stack_.back() == 0;
+                break;
+            case Op::BitNot:
+                stack_.back() = ~stack_.back();
+                break;
+            case Op::Bool:
+                stack_.back() = stack_.back() != 0;
+                break;
+            case Op::Jump:
+                pc = static_cast<size_t>(instruction.operand) - 1;
+                break;
+            case Op::JumpIfZero:
+                if (pop() == 0) pc = static_cast<size_t>(instruction.operand) - 1;
+                break;
+            case Op::JumpIfNonZero:
+                if (pop() != 0) pc = static_cast<size_t>(instruction.operand) - 1;
+                break;
+            default: {
+                const std::int64_t right = pop();
+                std::int64_t& left = stack_.back();
+                const auto l = static_cast<std::uint64_t>(left);
+                const auto r = static_cast<std::uint64_t>(right);
+                switch (instruction.op) {
+                    case Op::Add: left = wrap(l + r); break;
+                    case Op::Sub: left = wrap(l - r); break;
+                    case Op::Mul: left = wrap(l * r); break;
+                    case Op::Div:
+                    case Op::Mod:
+                        if (right == 0) {
+                            return failed("division by 0");
+                        }
+                        if (right == -1) {
+                            // INT64_MIN / -1 会溢出
+                            left = instruction.op == Op::Div ? wrap(0 - l) : 0;
+                        } else {
+                            left = instruction.op == Op::Div ? left / right : left % right;
+                        }
+                        break;
+                    case Op::Pow: {
+                        if (right < 0) {
+                            return failed("exponent less than 0");
+                        }
+                        std::uint64_t base = l, value = 1;
+                        for (std::uint64_t e = r; e; e >>= 1) {
+                            if (e & 1) value *= base;
+                            base *= base;
+                        }
+                        left = wrap(value);
+                        break;
+                    }
+                    case Op::Shl: left = wrap(l << (r & 63)); break;
+                    case Op::Shr: left = left >> (r & 63); break;
+                    case Op::Less: left = left < right; break;
+                    case Op::LessEqual: left = left <= right; break;
+                    case Op::Greater: left = left > right; break;
+                    case Op::GreaterEqual: left = left >= right; break;
+                    case Op::Equal: left = left == right; break;
+                    case Op::NotEqual: left = left != right; break;
+                    case Op::BitAnd: left &= right; break;
+                    case Op::BitXor: left ^= right; break;
+                    case Op::BitOr: left |= right; break;
+                    default: break;
+                }
+            }
+        }
+    }
+
+    result = stack_.empty() || stack_.size() == base ? 0 : stack_.back();
+    stack_.resize(base);
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef LEIZI_UTILS_ARITHMETIC_H
+#define LEIZI_UTILS_ARITHMETIC_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/variables.h"
+
+/**
+ * @brief 编译后的算术表达式
+ *
+ * 表达式被编译为栈式字节码，变量按名字表中的下标引用；名字在编译时驻留为 NameId，
+ * 缓存的程序反复执行时直接按编号查找变量。
+ * &&、||、?: 编译为跳转，只对需要的分支求值。
+ */
+struct ArithmeticProgram {
+    enum class Op : std::uint8_t {
+        Push,       // 压入常量 operand
+        Load,       // 压入变量 names[operand] 的值
+        Store,      // 栈顶写入变量 names[operand]（值保留在栈顶）
+        Pop,
+        Negate, Not, BitNot, Bool,
+        Add, Sub, Mul, Div, Mod, Pow,
+        Shl, Shr, Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual,
+        BitAnd, BitXor, BitOr,
+        Jump,       // 跳转到 operand
+        JumpIfZero, // 弹出栈顶，为 0 时跳转
+        JumpIfNonZero
+    };
+
+    struct Instruction {
+        Op op;
+        std::int64_t operand;
+    };
+
+    std::vector<Instruction> code;
+    std::vector<std::string> names;
+    std::vector<NameId> ids;  // 与 names 一一对应
+};
+
+/**
+ * @brief $(( )) 与 let 的求值器
+ *
+ * 每个表达式只解析一次：按源文本缓存字节码（LRU），循环中的 i=$((i+1))
+ * 从第二次起只执行字节码。运算为 64 位有符号整数，语义与 bash 相同：
+ *
+ *     ( )  后置 ++ --  前置 ++ -- + - ! ~  **  * / %  + -  << >>
+ *     < <= > >=  == !=  &  ^  |  &&  ||  ?:  = *= /= %= += -= <<= >>= &= ^= |=  ,
+ *
+ * 变量的值不是数字时按表达式递归求值，未设置的变量为 0。
+ */
+class ArithmeticEngine {
+public:
+    static constexpr size_t DEFAULT_CACHE_SIZE = 256;
+
+    explicit ArithmeticEngine(size_t cacheSize = DEFAULT_CACHE_SIZE);
+
+    /**
+     * @brief 求值 expression，赋值写回 variables
+     * @return 语法或运算错误时返回 false，error 为错误说明
+     */
+    bool evaluate(std::string_view expression, VariableManager& variables, std::int64_t& result,
+                  std::string& error);
+
+    /**
+     * @brief 把 expression 编译为字节码（不使用缓存）
+     */
+    static bool compile(std::string_view expression, ArithmeticProgram& program, std::string& error);
+
+    size_t cachedCount() const { return cache_.size(); }
+    size_t compileCount() const { return compiles_; }
+
+private:
+    struct CacheEntry {
+        std::string source;
+        std::shared_ptr<const ArithmeticProgram> program;  // 执行期间被淘汰时仍然有效
+    };
+
+    size_t capacity_;
+    size_t compiles_ = 0;
+    std::list<CacheEntry> cache_;  // 最近使用的在前
+    std::unordered_map<std::string_view, std::list<CacheEntry>::iterator> index_;  // 键指向 cache_ 中的 source
+    std::vector<std::int64_t> stack_;
+
+    std::shared_ptr<const ArithmeticProgram> lookup(std::string_view expression, std::string& error);
+    bool evaluate(std::string_view expression, VariableManager& variables, std::int64_t& result,
+                  std::string& error, int depth);
+    bool run(const ArithmeticProgram& program, VariableManager& variables, std::int64_t& result,
+             std::string& error, int depth);
+    bool load(NameId name, VariableManager& variables, std::int64_t& value, std::string& error, int depth);
+};
+
+#endif // LEIZI_UTILS_ARITHMETIC_H
@@ -0,0 +1,76 @@
+#include "utils/string_array.h"
+
+#include <algorithm>
+
+StringArray::StringArray(std::vector<std::string> values) : size_(values.size()) {
+    chunks_.reserve((values.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    for (size_t first = 0; first < values.size(); first += CHUNK_SIZE) {
+        auto chunk = std::make_shared<Chunk>();
+        chunk->reserve(CHUNK_SIZE);
+        const size_t last = std::min(values.size(), first + CHUNK_SIZE);
+        std::move(values.begin() + static_cast<std::ptrdiff_t>(first),
+                  values.begin() + static_cast<std::ptrdiff_t>(last), std::back_inserter(*chunk));
+        chunks_.push_back(std::move(chunk));
+    }
+}
+
+StringArray::Chunk& StringArray::writable(size_t chunk) {
+    auto& pointer = chunks_[chunk];
+    if (pointer.use_count() > 1) {
+        auto copy = std::make_shared<Chunk>();
+        copy->reserve(CHUNK_SIZE);
+        *copy = *pointer;
+        pointer = std::move(copy);
+    }
+    return *pointer;
+}
+
+void StringArray::push_back(std::string value) {
+    if (size_ % CHUNK_SIZE == 0) {
+        auto chunk = std::make_shared<Chunk>();
+        chunk->reserve(CHUNK_SIZE);
+        chunks_.push_back(std::move(chunk));
+    }
+    writable(chunks_.size() - 1).push_back(std::move(value));
+    ++size_;
+}
+
+void StringArray::set(size_t index, std::string value) {
+    writable(index / CHUNK_SIZE)[index % CHUNK_SIZE] = std::move(value);
+}
+
+void StringArray::resize(size_t size) {
+    if (size <= size_) {
+        chunks_.resize((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        if (size % CHUNK_SIZE != 0) {
+            writable(chunks_.size() - 1).resize(size % CHUNK_SIZE);
+        }
+        size_ = size;
+        return;
+    }
+    while (size_ < size) {
+        push_back(std::string());
+    }
+}
+
+void StringArray::clear() {
+    chunks_.clear();
+    size_ = 0;
+}
+
+bool StringArray::unique() const {
+    return std::all_of(chunks_.begin(), chunks_.end(), [](const auto& chunk) { return chunk.use_count() == 1; });
+}
+
+std::vector<std::string> StringArray::toVector() const {
+    std::vector<std::string> values;
+    values.reserve(size_);
+    for (const auto& chunk : chunks_) {
+        values.insert(values.end(), chunk->begin(), chunk->end());
+    }
+    return values;
+}
+
+bool StringArray::operator==(const StringArray& other) const {
+    return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+}
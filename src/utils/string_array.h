@@ -0,0 +1,100 @@
+#ifndef LEIZI_UTILS_STRING_ARRAY_H
+#define LEIZI_UTILS_STRING_ARRAY_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 分块存储的字符串数组
+ *
+ * 元素按 CHUNK_SIZE 个一块存放，除最后一块外每块都是满的，下标访问是 O(1)。
+ * 块由 shared_ptr 持有：复制数组只复制块指针，写入时才复制被写的那一块，
+ * 因此变量快照与数组赋值不会逐个复制元素；追加最多复制最后一块，均摊 O(1)。
+ */
+class StringArray {
+public:
+    static constexpr size_t CHUNK_SIZE = 256;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string*;
+        using reference = const std::string&;
+
+        const_iterator() = default;
+        const_iterator(const StringArray* array, size_t index) : array_(array), index_(index) {}
+
+        reference operator*() const { return (*array_)[index_]; }
+        pointer operator->() const { return &(*array_)[index_]; }
+        const_iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator copy = *this;
+            ++index_;
+            return copy;
+        }
+        bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+    private:
+        const StringArray* array_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    StringArray() = default;
+    explicit StringArray(std::vector<std::string> values);
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const std::string& operator[](size_t index) const { return (*chunks_[index / CHUNK_SIZE])[index % CHUNK_SIZE]; }
+    const std::string& front() const { return (*this)[0]; }
+    const std::string& back() const { return (*this)[size_ - 1]; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    /**
+     * @brief 追加一个元素，均摊 O(1)
+     */
+    void push_back(std::string value);
+
+    /**
+     * @brief 替换下标 index 的元素，只复制它所在的块
+     */
+    void set(size_t index, std::string value);
+
+    /**
+     * @brief 改变元素个数，新增的元素为空字符串
+     */
+    void resize(size_t size);
+
+    void clear();
+
+    /**
+     * @brief 数组的所有块都不与其它数组共享时返回 true（用于测试写时复制）
+     */
+    bool unique() const;
+
+    std::vector<std::string> toVector() const;
+
+    bool operator==(const StringArray& other) const;
+
+private:
+    using Chunk = std::vector<std::string>;
+
+    std::vector<std::shared_ptr<Chunk>> chunks_;
+    size_t size_ = 0;
+
+    // 第 chunk 块的可写引用，与其它数组共享时先复制
+    Chunk& writable(size_t chunk);
+};
+
+#endif // LEIZI_UTILS_STRING_ARRAY_H
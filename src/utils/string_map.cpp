@@ -0,0 +1,108 @@
+#include "utils/string_map.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+constexpr size_t MIN_CAPACITY = 8;
+
+size_t hashKey(std::string_view key) {
+    return std::hash<std::string_view>{}(key);
+}
+
+} // namespace
+
+StringMap::const_iterator StringMap::begin() const {
+    if (!table_) return const_iterator();
+    const Entry* data = table_->entries.data();
+    return const_iterator(data, data + table_->entries.size());
+}
+
+StringMap::const_iterator StringMap::end() const {
+    if (!table_) return const_iterator();
+    const Entry* data = table_->entries.data() + table_->entries.size();
+    return const_iterator(data, data);
+}
+
+size_t StringMap::probe(const Table& table, std::string_view key, size_t hash) {
+    const size_t mask = table.slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const std::uint32_t slot = table.slots[i];
+        if (slot == EMPTY_SLOT) return i;
+        const Entry& entry = table.entries[slot];
+        if (!entry.erased && entry.hash == hash && entry.key == key) return i;
+    }
+}
+
+StringMap::Table& StringMap::writable() {
+    if (!table_) {
+        table_ = std::make_shared<Table>();
+    } else if (table_.use_count() > 1) {
+        table_ = std::make_shared<Table>(*table_);
+    }
+    return *table_;
+}
+
+void StringMap::rehash(Table& table, size_t capacity) {
+    table.entries.erase(std::remove_if(table.entries.begin(), table.entries.end(),
+                                       [](const Entry& entry) { return entry.erased; }),
+                        table.entries.end());
+    table.slots.assign(capacity, EMPTY_SLOT);
+    const size_t mask = capacity - 1;
+    for (size_t index = 0; index < table.entries.size(); ++index) {
+        size_t i = table.entries[index].hash & mask;
+        while (table.slots[i] != EMPTY_SLOT) i = (i + 1) & mask;
+        table.slots[i] = static_cast<std::uint32_t>(index);
+    }
+}
+
+const std::string* StringMap::find(std::string_view key) const {
+    if (!table_ || table_->size == 0) return nullptr;
+    const std::uint32_t slot = table_->slots[probe(*table_, key, hashKey(key))];
+    return slot == EMPTY_SLOT ? nullptr : &table_->entries[slot].value;
+}
+
+std::string& StringMap::set(std::string key, std::string value) {
+    Table& table = writable();
+    const size_t hash = hashKey(key);
+    if (table.slots.empty()) {
+        rehash(table, MIN_CAPACITY);
+    }
+
+    size_t i = probe(table, key, hash);
+    if (table.slots[i] != EMPTY_SLOT) {
+        return table.entries[table.slots[i]].value = std::move(value);
+    }
+
+    // 已删除的条目仍占着槽位，负载按 entries 计算，保证探测总能遇到空槽
+    if ((table.entries.size() + 1) * 4 > table.slots.size() * 3) {
+        size_t capacity = MIN_CAPACITY;
+        while ((table.size + 1) * 2 > capacity) capacity *= 2;
+        rehash(table, capacity);
+        i = probe(table, key, hash);
+    }
+    table.slots[i] = static_cast<std::uint32_t>(table.entries.size());
+    table.entries.push_back(Entry{std::move(key), std::move(value), hash, false});
+    ++table.size;
+    return table.entries.back().value;
+}
+
+bool StringMap::erase(std::string_view key) {
+    // 先在共享的表上查找，键不存在时不复制
+    if (!find(key)) return false;
+    Table& table = writable();
+    Entry& entry = table.entries[table.slots[probe(table, key, hashKey(key))]];
+    entry.erased = true;
+    entry.key.clear();
+    entry.value.clear();
+    --table.size;
+    return true;
+}
+
+bool StringMap::operator==(const StringMap& other) const {
+    if (size() != other.size()) return false;
+    return std::equal(begin(), end(), other.begin(), [](const Entry& left, const Entry& right) {
+        return left.key == right.key && left.value == right.value;
+    });
+}
@@ -0,0 +1,115 @@
+#ifndef LEIZI_UTILS_STRING_MAP_H
+#define LEIZI_UTILS_STRING_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 保持插入顺序的字符串关联数组（typeset -A）
+ *
+ * 条目按插入顺序连续存放在 entries 中；索引是 2 的幂大小的 uint32 槽位数组，
+ * 以线性探测（开放寻址）保存条目的位置，查找只访问两块连续内存。
+ * 删除只把条目标记为已删除，探测时跳过；重建索引时再把已删除的条目压缩掉。
+ * 整张表由 shared_ptr 持有，复制只共享指针，写入时才复制（与 StringArray 相同）。
+ */
+class StringMap {
+public:
+    struct Entry {
+        std::string key;
+        std::string value;
+        size_t hash = 0;
+        bool erased = false;
+    };
+
+    // 按插入顺序遍历未删除的条目
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entry*;
+        using reference = const Entry&;
+
+        const_iterator() = default;
+        const_iterator(const Entry* current, const Entry* end) : current_(current), end_(end) { skip(); }
+
+        reference operator*() const { return *current_; }
+        pointer operator->() const { return current_; }
+        const_iterator& operator++() {
+            ++current_;
+            skip();
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+        bool operator==(const const_iterator& other) const { return current_ == other.current_; }
+        bool operator!=(const const_iterator& other) const { return current_ != other.current_; }
+
+    private:
+        const Entry* current_ = nullptr;
+        const Entry* end_ = nullptr;
+
+        void skip() {
+            while (current_ != end_ && current_->erased) ++current_;
+        }
+    };
+
+    size_t size() const { return table_ ? table_->size : 0; }
+    bool empty() const { return size() == 0; }
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * @brief 键对应的值；键不存在时返回 nullptr
+     */
+    const std::string* find(std::string_view key) const;
+
+    /**
+     * @brief 设置键的值；键已存在时保持它原来的位置
+     */
+    std::string& set(std::string key, std::string value);
+
+    /**
+     * @brief 删除键，键不存在时返回 false
+     */
+    bool erase(std::string_view key);
+
+    void clear() { table_.reset(); }
+
+    /**
+     * @brief 表不与其它关联数组共享时返回 true（用于测试写时复制）
+     */
+    bool unique() const { return !table_ || table_.use_count() == 1; }
+
+    // 内容与顺序都相同时相等
+    bool operator==(const StringMap& other) const;
+
+private:
+    static constexpr std::uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    struct Table {
+        std::vector<Entry> entries;         // 插入顺序，含已删除的条目
+        std::vector<std::uint32_t> slots;   // 条目在 entries 中的下标或 EMPTY_SLOT
+        size_t size = 0;                    // 未删除的条目数
+    };
+
+    std::shared_ptr<Table> table_;
+
+    // 键在 slots 中的槽位：找到时指向该条目，否则指向探测到的第一个空槽
+    static size_t probe(const Table& table, std::string_view key, size_t hash);
+    // 可写的表，与其它关联数组共享时先复制
+    Table& writable();
+    // 压缩已删除的条目并按 capacity 个槽位重建索引
+    static void rehash(Table& table, size_t capacity);
+};
+
+#endif // LEIZI_UTILS_STRING_MAP_H
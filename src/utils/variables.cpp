@@ -1,110 +1,771 @@
 #include "utils/variables.h"
 
+#include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cstring>
 
-Variable::Variable(const std::string& str, bool readonly)
-    : type(VarType::STRING), stringValue(str), intValue(0), isReadonly(readonly) {}
+#include "core/glob.h"
 
-Variable::Variable(const std::vector<std::string>& arr, bool readonly)
-    : type(VarType::ARRAY), arrayValue(arr), intValue(0), isReadonly(readonly) {}
+namespace {
 
-Variable::Variable(int value, bool readonly)
-    : type(VarType::INTEGER), intValue(value), isReadonly(readonly) {}
+// 作用域的表链超过该长度时，冻结前合并为一层
+constexpr size_t MAX_LAYER_DEPTH = 8;
 
-std::string Variable::toString() const {
-    switch (type) {
+bool isNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// open 指向 "${" 的 '{' 时返回与之配对的 '}'：跳过嵌套的 ${...} 与命令替换，没有闭合时返回 npos
+size_t parameterEnd(const std::string& text, size_t open) {
+    int depth = 0;
+    for (size_t i = open; i < text.size(); ++i) {
+        const char c = text[i];
+        if (c == '\\') {
+            ++i;
+        } else if ((c == '$' && i + 1 < text.size() && text[i + 1] == '(') || c == '`') {
+            i = substitutionEnd(text, i);
+            if (i == std::string::npos) return i;
+        } else if (c == '{') {
+            ++depth;
+        } else if (c == '}' && --depth == 0) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+// 可选空白与符号加十进制数字
+bool parseInteger(std::string_view text, std::int64_t& value) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && error == std::errc() && end == text.data() + text.size();
+}
+
+// ${var:offset:length} 在长度为 size 的值中选出的范围；负的 offset 从末尾数起，
+// 负的 length 表示结尾距末尾的距离。范围为空或越界时返回 false
+bool sliceRange(size_t size, std::int64_t offset, std::optional<std::int64_t> length, size_t& first,
+                size_t& count) {
+    const auto total = static_cast<std::int64_t>(size);
+    if (offset < 0) offset += total;
+    if (offset < 0 || offset > total) return false;
+    std::int64_t end = total;
+    if (length) {
+        end = *length >= 0 ? std::min(total, offset + std::min(*length, total)) : total + *length;
+    }
+    if (end <= offset) return false;
+    first = static_cast<size_t>(offset);
+    count = static_cast<size_t>(end - offset);
+    return true;
+}
+
+// ${arr[i,j]} 选出的元素范围 [first, end)：下标从 1 开始并包含两端，负数从末尾数起
+void subscriptRange(size_t size, std::int64_t low, std::int64_t high, size_t& first, size_t& end) {
+    const auto total = static_cast<std::int64_t>(size);
+    const std::int64_t from = std::max<std::int64_t>(0, low > 0 ? low - 1 : low == 0 ? 0 : total + low);
+    const std::int64_t to = std::min(total, high >= 0 ? high : total + high + 1);
+    first = static_cast<size_t>(std::min(from, total));
+    end = static_cast<size_t>(std::max(from, to));
+    end = std::max(first, std::min(end, size));
+}
+
+// 去掉与模式匹配的最短或最长前缀（suffix 时为后缀）；没有匹配时原样返回
+std::string_view trimPattern(std::string_view value, const GlobMatcher& pattern, bool suffix, bool longest) {
+    if (pattern.isLiteral()) {
+        const std::string& text = pattern.literal();
+        if (suffix ? value.ends_with(text) : value.starts_with(text)) {
+            return suffix ? value.substr(0, value.size() - text.size()) : value.substr(text.size());
+        }
+        return value;
+    }
+    for (size_t k = 0; k <= value.size(); ++k) {
+        const size_t length = longest ? value.size() - k : k;
+        if (suffix ? pattern.matches(value.substr(value.size() - length))
+                   : pattern.matches(value.substr(0, length))) {
+            return suffix ? value.substr(0, value.size() - length) : value.substr(length);
+        }
+    }
+    return value;
+}
+
+// 把 value 中与模式匹配的部分换成 replacement 后追加到 out。
+// mode 为 0 时替换第一处，'/' 替换全部，'#' 与 '%' 只匹配开头或结尾；每处取最长匹配
+void replacePattern(std::string_view value, const GlobMatcher& pattern, std::string_view replacement, char mode,
+                    std::string& out) {
+    if (mode == '#' || mode == '%') {
+        const std::string_view rest = trimPattern(value, pattern, mode == '%', true);
+        const bool matched = rest.size() != value.size() || pattern.matches(std::string_view());
+        if (!matched) {
+            out.append(value);
+        } else if (mode == '#') {
+            out.append(replacement).append(rest);
+        } else {
+            out.append(rest).append(replacement);
+        }
+        return;
+    }
+
+    const bool literal = pattern.isLiteral();
+    if (literal && pattern.literal().empty()) {
+        out.append(value);
+        return;
+    }
+    size_t copied = 0;
+    for (size_t i = 0; i < value.size();) {
+        size_t length = 0;
+        if (literal) {
+            i = value.find(pattern.literal(), i);
+            if (i == std::string_view::npos) break;
+            length = pattern.literal().size();
+        } else {
+            for (length = value.size() - i; length > 0 && !pattern.matches(value.substr(i, length)); --length) {
+            }
+            if (length == 0) {
+                ++i;
+                continue;
+            }
+        }
+        out.append(value.substr(copied, i - copied)).append(replacement);
+        i += length;
+        copied = i;
+        if (mode != '/') break;
+    }
+    out.append(value.substr(copied));
+}
+
+// 去掉 body 开头的 (k)、(v) 或 (kv) 标志并存入 flags；标志中有其它字符时返回 false
+bool parameterFlags(std::string_view& body, std::string_view& flags) {
+    if (body.empty() || body[0] != '(') return true;
+    const size_t close = body.find(')');
+    if (close == std::string_view::npos) return false;
+    flags = body.substr(1, close - 1);
+    body.remove_prefix(close + 1);
+    return flags.find_first_not_of("kv") == std::string_view::npos;
+}
+
+} // namespace
+
+Variable::Variable(std::string str, bool readonly) : isReadonly(readonly), value_(std::move(str)) {}
+
+Variable::Variable(std::vector<std::string> arr, bool readonly)
+    : isReadonly(readonly), value_(StringArray(std::move(arr))) {}
+
+Variable::Variable(StringArray arr, bool readonly) : isReadonly(readonly), value_(std::move(arr)) {}
+
+Variable::Variable(StringMap map, bool readonly) : isReadonly(readonly), value_(std::move(map)) {}
+
+Variable::Variable(std::int64_t value, bool readonly) : isReadonly(readonly) {
+    Integer integer;
+    integer.value = value;
+    const auto [end, _] = std::to_chars(integer.text, integer.text + sizeof(integer.text), value);
+    integer.length = static_cast<std::uint8_t>(end - integer.text);
+    value_ = integer;
+}
+
+std::string_view Variable::view() const {
+    switch (type()) {
         case VarType::STRING:
-            return stringValue;
-        case VarType::INTEGER:
-            return std::to_string(intValue);
-        case VarType::ARRAY:
-            return arrayValue.empty() ? std::string() : arrayValue.front();
+            return std::get<std::string>(value_);
+        case VarType::INTEGER: {
+            const Integer& integer = std::get<Integer>(value_);
+            return std::string_view(integer.text, integer.length);
+        }
+        case VarType::ARRAY: {
+            const auto& array = std::get<StringArray>(value_);
+            return array.empty() ? std::string_view() : std::string_view(array.front());
+        }
+        case VarType::ASSOC: {
+            const auto& map = std::get<StringMap>(value_);
+            return map.empty() ? std::string_view() : std::string_view(map.begin()->value);
+        }
         default:
-            return std::string();
+            return std::string_view();
     }
 }
 
-Variable& VariableManager::set(const std::string& name, const Variable& value) {
-    auto [it, _] = variables_.insert_or_assign(name, value);
-    return it->second;
+NameTable& NameTable::instance() {
+    static NameTable table;
+    return table;
+}
+
+NameId NameTable::intern(std::string_view name) {
+    if (auto it = ids_.find(name); it != ids_.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<NameId>(names_.size());
+    auto [it, _] = ids_.emplace(std::string(name), id);
+    names_.push_back(&it->first);
+    return id;
+}
+
+std::optional<NameId> NameTable::find(std::string_view name) const {
+    if (auto it = ids_.find(name); it != ids_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+VariableManager::VariableManager() : scopes_{std::make_shared<Layer>()} {}
+
+const std::optional<Variable>* VariableManager::find(NameId name, size_t& scope) const {
+    for (size_t i = scopes_.size(); i-- > 0;) {
+        for (const Layer* layer = scopes_[i].get(); layer; layer = layer->parent.get()) {
+            if (auto it = layer->entries.find(name); it != layer->entries.end()) {
+                scope = i;
+                return &it->second;
+            }
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const VariableManager::Layer> VariableManager::freeze(std::shared_ptr<Layer>& layer) {
+    if (layer->entries.empty()) {
+        return layer->parent;
+    }
+    if (layer->depth > MAX_LAYER_DEPTH) {
+        // 把下层中仍然可见的变量合并进链首，链长回到 1
+        for (const Layer* below = layer->parent.get(); below; below = below->parent.get()) {
+            for (const auto& [name, entry] : below->entries) {
+                layer->entries.try_emplace(name, entry);
+            }
+        }
+        layer->parent.reset();
+        layer->depth = 1;
+        for (auto it = layer->entries.begin(); it != layer->entries.end();) {
+            it = it->second ? std::next(it) : layer->entries.erase(it);
+        }
+    }
+    return std::shared_ptr<const Layer>(std::move(layer));
+}
+
+Variable& VariableManager::set(const std::string& name, Variable value) {
+    return set(NameTable::instance().intern(name), std::move(value));
+}
+
+Variable& VariableManager::set(NameId name, Variable value) {
+    size_t scope = 0;
+    find(name, scope);
+    auto [it, _] = scopes_[scope]->entries.insert_or_assign(name, std::move(value));
+    return *it->second;
+}
+
+Variable& VariableManager::setLocal(const std::string& name, Variable value) {
+    auto [it, _] = scopes_.back()->entries.insert_or_assign(NameTable::instance().intern(name), std::move(value));
+    return *it->second;
+}
+
+void VariableManager::pushScope() {
+    scopes_.push_back(std::make_shared<Layer>());
+}
+
+void VariableManager::popScope() {
+    if (scopes_.size() > 1) {
+        scopes_.pop_back();
+    }
+}
+
+VariableManager VariableManager::snapshot() {
+    VariableManager copy;
+    copy.scopes_.clear();
+    for (auto& layer : scopes_) {
+        auto frozen = freeze(layer);
+        const size_t depth = frozen ? frozen->depth + 1 : 1;
+        layer = std::make_shared<Layer>(Layer{{}, frozen, depth});
+        copy.scopes_.push_back(std::make_shared<Layer>(Layer{{}, frozen, depth}));
+    }
+    return copy;
 }
 
 Variable& VariableManager::setString(const std::string& name, const std::string& value, bool readonly) {
     return set(name, Variable(value, readonly));
 }
 
-Variable& VariableManager::setArray(const std::string& name, const std::vector<std::string>& values, bool readonly) {
-    return set(name, Variable(values, readonly));
+Variable& VariableManager::setArray(const std::string& name, std::vector<std::string> values, bool readonly) {
+    return set(name, Variable(std::move(values), readonly));
 }
 
-Variable& VariableManager::setInteger(const std::string& name, int value, bool readonly) {
+Variable& VariableManager::setInteger(const std::string& name, std::int64_t value, bool readonly) {
     return set(name, Variable(value, readonly));
 }
 
 const Variable* VariableManager::get(const std::string& name) const {
-    auto it = variables_.find(name);
-    return it != variables_.end() ? &it->second : nullptr;
+    const auto id = NameTable::instance().find(name);
+    return id ? get(*id) : nullptr;
 }
 
 Variable* VariableManager::get(const std::string& name) {
-    auto it = variables_.find(name);
-    return it != variables_.end() ? &it->second : nullptr;
+    const auto id = NameTable::instance().find(name);
+    return id ? get(*id) : nullptr;
+}
+
+const Variable* VariableManager::get(NameId name) const {
+    size_t scope = 0;
+    const auto* entry = find(name, scope);
+    return entry && *entry ? &**entry : nullptr;
+}
+
+Variable* VariableManager::get(NameId name) {
+    size_t scope = 0;
+    const auto* entry = find(name, scope);
+    if (!entry || !*entry) {
+        return nullptr;
+    }
+    // 调用方可能修改变量：冻结层中的变量先复制到所在作用域的链首
+    auto& entries = scopes_[scope]->entries;
+    auto it = entries.find(name);
+    if (it == entries.end()) {
+        it = entries.emplace(name, *entry).first;
+    }
+    return &*it->second;
 }
 
 bool VariableManager::erase(const std::string& name) {
-    return variables_.erase(name) > 0;
+    const auto id = NameTable::instance().find(name);
+    size_t scope = 0;
+    const auto* entry = id ? find(*id, scope) : nullptr;
+    if (!entry || !*entry) {
+        return false;
+    }
+    // 局部变量与下层仍有同名变量时留下删除标记
+    Layer& layer = *scopes_[scope];
+    if (scope > 0 || layer.parent) {
+        layer.entries.insert_or_assign(*id, std::nullopt);
+    } else {
+        layer.entries.erase(*id);
+    }
+    return true;
 }
 
 bool VariableManager::contains(const std::string& name) const {
-    return variables_.find(name) != variables_.end();
+    return get(name) != nullptr;
 }
 
-std::string VariableManager::expand(const std::string& input, const Resolver& resolver) const {
-    std::string result = input;
+bool VariableManager::expandArray(std::string_view word, std::vector<std::string>& words) const {
+    if (word.size() < 4 || !word.starts_with("${") || !word.ends_with("}")) {
+        return false;
+    }
+    std::string_view body = word.substr(2, word.size() - 3);
+    std::string_view flags;
+    if (!parameterFlags(body, flags)) {
+        return false;
+    }
+    size_t nameEnd = 0;
+    while (nameEnd < body.size() && isNameChar(body[nameEnd])) ++nameEnd;
+    if (nameEnd == 0) {
+        return false;
+    }
+    const std::string_view subscript = body.substr(nameEnd);
+
+    const auto id = NameTable::instance().find(body.substr(0, nameEnd));
+    const Variable* variable = id ? get(*id) : nullptr;
+    if (!variable) {
+        return false;
+    }
+
+    if (variable->type() == VarType::ASSOC) {
+        // ${map}、${map[@]} 与 ${(k)map} 等：按插入顺序追加值、键或键值对
+        if (!subscript.empty() && subscript != "[@]" && subscript != "[*]") {
+            return false;
+        }
+        const bool keys = flags.find('k') != std::string_view::npos;
+        const bool values = !keys || flags.find('v') != std::string_view::npos;
+        const StringMap& map = variable->mapValue();
+        words.reserve(words.size() + map.size() * (keys && values ? 2 : 1));
+        for (const auto& entry : map) {
+            if (keys) words.push_back(entry.key);
+            if (values) words.push_back(entry.value);
+        }
+        return true;
+    }
+
+    if (!flags.empty() || variable->type() != VarType::ARRAY || subscript.size() < 3 || subscript.front() != '[' ||
+        subscript.back() != ']') {
+        return false;
+    }
+    const std::string_view expression = subscript.substr(1, subscript.size() - 2);
+    std::int64_t low = 1;
+    std::int64_t high = -1;
+    if (expression != "@") {
+        const size_t comma = expression.find(',');
+        if (comma == std::string_view::npos || !parseInteger(expression.substr(0, comma), low) ||
+            !parseInteger(expression.substr(comma + 1), high)) {
+            return false;
+        }
+    }
+
+    const StringArray& array = variable->arrayValue();
+    size_t first = 0;
+    size_t end = 0;
+    subscriptRange(array.size(), low, high, first, end);
+    words.reserve(words.size() + (end - first));
+    for (size_t i = first; i < end; ++i) {
+        words.push_back(array[i]);
+    }
+    return true;
+}
+
+std::string VariableManager::expand(const std::string& input, const Resolver& resolver,
+                                   const Substituter& substitute, const Substituter& arithmetic) const {
+    // 逐段追加到结果中：未展开的部分与展开结果各复制一次，展开结果不再扫描
+    std::string result;
+    result.reserve(input.size());
     size_t pos = 0;
+    size_t copied = 0;
 
-    while ((pos = result.find('$', pos)) != std::string::npos) {
-        if (pos + 1 >= result.size()) break;
+    while ((pos = input.find_first_of("$`", pos)) != std::string::npos) {
+        // \$ 与 \` 是字面量：去掉反斜杠，不展开
+        if (pos > 0 && input[pos - 1] == '\\') {
+            result.append(input, copied, pos - 1 - copied);
+            copied = pos++;
+            continue;
+        }
+        if (pos + 1 >= input.size()) break;
+        if (input[pos] == '`' && !substitute) {
+            ++pos;
+            continue;
+        }
+
+        // 算术展开：$((expr))
+        if (arithmetic && input.compare(pos, 3, "$((") == 0) {
+            const size_t close = arithmeticEnd(input, pos);
+            if (close != std::string::npos) {
+                result.append(input, copied, pos - copied);
+                result += arithmetic(input.substr(pos + 3, close - 1 - (pos + 3)));
+                pos = copied = close + 1;
+                continue;
+            }
+        }
+
+        // 命令替换：$(cmd) 与 `cmd`（$(( 留给算术展开）
+        const bool backtick = input[pos] == '`';
+        if (backtick || (substitute && input[pos + 1] == '(' &&
+                         (pos + 2 >= input.size() || input[pos + 2] != '('))) {
+            const size_t close = substitutionEnd(input, pos);
+            if (close == std::string::npos) {
+                ++pos;
+                continue;
+            }
+            const size_t bodyStart = pos + (backtick ? 1 : 2);
+            result.append(input, copied, pos - copied);
+            result += substitute(input.substr(bodyStart, close - bodyStart));
+            pos = copied = close + 1;
+            continue;
+        }
 
         size_t start = pos + 1;
         size_t end = start;
-
-        bool braced = (start < result.size() && result[start] == '{');
+        const bool braced = input[start] == '{';
         if (braced) {
             ++start;
-            end = result.find('}', start);
+            end = parameterEnd(input, pos + 1);
             if (end == std::string::npos) {
                 ++pos;
                 continue;
             }
         } else {
-            while (end < result.size() &&
-                   (std::isalnum(static_cast<unsigned char>(result[end])) || result[end] == '_')) {
+            while (end < input.size() && isNameChar(input[end])) {
                 ++end;
             }
+            if (end == start) {
+                ++pos;
+                continue;
+            }
         }
 
-        if (end > start) {
-            std::string varName = result.substr(start, end - start);
-            std::string value;
+        result.append(input, copied, pos - copied);
+        expandParameter(std::string_view(input).substr(start, end - start), resolver, substitute, arithmetic, result);
+        pos = copied = braced ? end + 1 : end;
+    }
 
-            if (const auto* variable = get(varName)) {
-                value = variable->toString();
-            } else if (resolver) {
-                if (auto resolved = resolver(varName); resolved.has_value()) {
-                    value = *resolved;
-                }
-            }
+    result.append(input, copied, std::string::npos);
+    return result;
+}
 
-            size_t replaceStart = pos;
-            size_t replaceEnd = braced ? end + 1 : end;
-            result.replace(replaceStart, replaceEnd - replaceStart, value);
-            pos = replaceStart + value.length();
+void VariableManager::expandParameter(std::string_view body, const Resolver& resolver, const Substituter& substitute,
+                                      const Substituter& arithmetic, std::string& out) const {
+    // 操作数（默认值、模式、替换串）中的展开
+    auto word = [&](std::string_view text) {
+        return text.find_first_of("$`") == std::string_view::npos
+                   ? std::string(text)
+                   : expand(std::string(text), resolver, substitute, arithmetic);
+    };
+    // 下标与偏移量按算术表达式求值
+    auto number = [&](std::string_view text, std::int64_t& value) {
+        return parseInteger(arithmetic ? arithmetic(std::string(text)) : word(text), value);
+    };
+
+    // ${(k)map} 取关联数组的键，${(v)map} 取值，${(kv)map} 依次取键与值
+    std::string_view flags;
+    if (!parameterFlags(body, flags)) return;
+
+    const bool length = body.size() > 1 && body[0] == '#';
+    if (length) body.remove_prefix(1);
+
+    size_t nameEnd = 0;
+    while (nameEnd < body.size() && isNameChar(body[nameEnd])) ++nameEnd;
+    // ${?} ${$} ${#} ${!} 等特殊参数只有一个字符，由 resolver 提供值
+    if (nameEnd == 0 && !body.empty() && body[0] != '\0' && std::strchr("?$#!@*-", body[0]) != nullptr) {
+        nameEnd = 1;
+    }
+    if (nameEnd == 0) return;
+    const std::string_view name = body.substr(0, nameEnd);
+    body.remove_prefix(nameEnd);
+
+    std::optional<std::string_view> expression;
+    if (!body.empty() && body[0] == '[') {
+        const size_t close = body.find(']');
+        if (close == std::string_view::npos) return;
+        expression = body.substr(1, close - 1);
+        body.remove_prefix(close + 1);
+    }
+
+    // 取值只建立视图；环境变量的值保存在 storage 中
+    std::string storage;
+    std::string_view scalar;
+    const StringArray* elements = nullptr;
+    const StringMap* map = nullptr;
+    bool isSet = true;
+    // 名字只在驻留表中查找一次，没有出现过的名字不可能是 shell 变量
+    const auto id = NameTable::instance().find(name);
+    if (const Variable* variable = id ? get(*id) : nullptr) {
+        if (variable->type() == VarType::ARRAY) {
+            elements = &variable->arrayValue();
+        } else if (variable->type() == VarType::ASSOC) {
+            map = &variable->mapValue();
         } else {
-            ++pos;
+            scalar = variable->view();
         }
+    } else if (std::optional<std::string> resolved; resolver && (resolved = resolver(std::string(name)))) {
+        storage = std::move(*resolved);
+        scalar = storage;
+    } else {
+        isSet = false;
     }
 
-    return result;
+    // [@] 与 [*] 取全部元素，[i] 从 1 开始、负数从末尾数起，[i,j] 取 i 到 j 的元素；
+    // 关联数组的下标是键，其中的 $ 展开后按原样查找
+    enum class Subscript { None, All, One } subscript = Subscript::None;
+    std::int64_t index = 0;
+    std::int64_t low = 1;
+    std::int64_t high = -1;
+    if (expression) {
+        const size_t comma = expression->find(',');
+        if (*expression == "@" || *expression == "*") {
+            subscript = Subscript::All;
+        } else if (map) {
+            subscript = Subscript::One;
+        } else if (comma != std::string_view::npos) {
+            if (!number(expression->substr(0, comma), low) || !number(expression->substr(comma + 1), high)) return;
+            subscript = Subscript::All;
+        } else if (number(*expression, index)) {
+            subscript = Subscript::One;
+        } else {
+            return;
+        }
+    }
+
+    // 标量按只有一个元素的数组处理；不带下标的数组取第一个元素，${#arr} 除外；
+    // 不带下标的关联数组取全部的值（zsh 的行为）
+    const bool wholeArray = (elements || map) && subscript == Subscript::None;
+    std::vector<std::string_view> items;
+    const size_t available = elements ? elements->size() : isSet ? 1 : 0;
+    auto item = [&](size_t i) { return elements ? std::string_view((*elements)[i]) : scalar; };
+    if (map) {
+        if (subscript == Subscript::One) {
+            if (const std::string* value = map->find(word(*expression))) {
+                items.push_back(*value);
+            } else {
+                isSet = false;
+            }
+        } else {
+            const bool keys = flags.find('k') != std::string_view::npos;
+            const bool values = !keys || flags.find('v') != std::string_view::npos;
+            items.reserve(map->size() * (keys && values ? 2 : 1));
+            for (const auto& entry : *map) {
+                if (keys) items.push_back(entry.key);
+                if (values) items.push_back(entry.value);
+            }
+        }
+    } else if (subscript == Subscript::One) {
+        const auto size = static_cast<std::int64_t>(available);
+        const std::int64_t i = index > 0 ? index - 1 : size + index;
+        if (index != 0 && i >= 0 && i < size) {
+            items.push_back(item(static_cast<size_t>(i)));
+        } else {
+            isSet = false;
+        }
+    } else if (subscript == Subscript::All || (wholeArray && length)) {
+        size_t first = 0;
+        size_t end = 0;
+        subscriptRange(available, low, high, first, end);
+        items.reserve(end - first);
+        for (size_t i = first; i < end; ++i) items.push_back(item(i));
+    } else if (available > 0) {
+        items.push_back(item(0));
+    }
+
+    if (length) {
+        // ${#arr} 与 ${#arr[@]} 是元素个数，其余是字符数
+        const bool count = wholeArray || subscript == Subscript::All;
+        out += std::to_string(count ? items.size() : items.empty() ? 0 : items.front().size());
+        return;
+    }
+
+    auto join = [&](const std::vector<std::string_view>& values) {
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i > 0) out += ' ';
+            out.append(values[i]);
+        }
+    };
+
+    if (body.empty()) {
+        join(items);
+        return;
+    }
+
+    const bool colon = body[0] == ':' && body.size() > 1 && std::strchr("-+", body[1]) != nullptr;
+    const char op = colon ? body[1] : body[0];
+    if (op == '-' || op == '+') {
+        // ${var-w} 与 ${var+w} 只看是否已设置，带冒号时空值也算未设置
+        const bool empty = items.empty() || (items.size() == 1 && items.front().empty());
+        const bool present = isSet && !(colon && empty);
+        const std::string_view operand = body.substr(colon ? 2 : 1);
+        if (op == '-' ? !present : present) {
+            out += word(operand);
+        } else if (op == '-') {
+            join(items);
+        }
+        return;
+    }
+
+    if (op == ':') {
+        // ${var:offset} 与 ${var:offset:length}；[@] 时按元素切片
+        const std::string_view spec = body.substr(1);
+        const size_t separator = spec.find(':');
+        std::int64_t offset = 0;
+        std::optional<std::int64_t> count;
+        if (!number(spec.substr(0, separator), offset)) return;
+        if (separator != std::string_view::npos) {
+            std::int64_t value = 0;
+            if (!number(spec.substr(separator + 1), value)) return;
+            count = value;
+        }
+
+        size_t first = 0;
+        size_t size = 0;
+        if (subscript == Subscript::All) {
+            if (sliceRange(items.size(), offset, count, first, size)) {
+                join(std::vector<std::string_view>(items.begin() + first, items.begin() + first + size));
+            }
+        } else if (!items.empty() && sliceRange(items.front().size(), offset, count, first, size)) {
+            out.append(items.front().substr(first, size));
+        }
+        return;
+    }
+
+    if (op == '#' || op == '%') {
+        // ${var#p} ${var##p} 去掉最短/最长的前缀，${var%p} ${var%%p} 去掉后缀
+        const bool longest = body.size() > 1 && body[1] == op;
+        const GlobMatcher pattern(word(body.substr(longest ? 2 : 1)));
+        for (auto& item : items) {
+            item = trimPattern(item, pattern, op == '%', longest);
+        }
+        join(items);
+        return;
+    }
+
+    if (op == '/') {
+        // ${var/p/r} 替换第一处最长匹配，//p 替换全部，/#p 与 /%p 只匹配开头或结尾
+        std::string_view spec = body.substr(1);
+        char mode = 0;
+        if (!spec.empty() && (spec[0] == '/' || spec[0] == '#' || spec[0] == '%')) {
+            mode = spec[0];
+            spec.remove_prefix(1);
+        }
+        size_t separator = 0;
+        while (separator < spec.size() && spec[separator] != '/') {
+            separator += spec[separator] == '\\' ? 2 : 1;
+        }
+        const GlobMatcher pattern(word(spec.substr(0, std::min(separator, spec.size()))));
+        const std::string replacement = separator < spec.size() ? word(spec.substr(separator + 1)) : std::string();
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (i > 0) out += ' ';
+            replacePattern(items[i], pattern, replacement, mode, out);
+        }
+    }
+}
+
+std::string escapeExpansion(std::string_view text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '$' || c == '`') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
 }
 
+void expandPathname(const std::string& word, const std::function<std::string(const std::string&)>& expand,
+                    const std::function<void(std::string)>& add) {
+    const std::string pattern = word.find_first_of("$`") != std::string::npos ? expand(word) : word;
+    if (GlobPattern::hasMagic(pattern)) {
+        auto matches = GlobPattern(pattern).expand();
+        if (!matches.empty()) {
+            for (const auto& match : matches) add(escapeExpansion(match));
+            return;
+        }
+    }
+    add(escapeExpansion(GlobPattern::unescape(pattern)));
+}
+
+size_t substitutionEnd(const std::string& text, size_t open) {
+    if (text[open] == '`') {
+        for (size_t i = open + 1; i < text.size(); ++i) {
+            if (text[i] == '\\') {
+                ++i;
+            } else if (text[i] == '`') {
+                return i;
+            }
+        }
+        return std::string::npos;
+    }
+
+    int depth = 0;
+    char quote = 0;
+    for (size_t i = open + 1; i < text.size(); ++i) {
+        const char c = text[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+            else if (c == '\\' && quote == '"') ++i;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+        } else if (c == '\\') {
+            ++i;
+        } else if (c == '(') {
+            ++depth;
+        } else if (c == ')' && --depth == 0) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+
+size_t arithmeticEnd(const std::string& text, size_t open) {
+    int depth = 0;
+    for (size_t i = open + (text[open] == '$' ? 3 : 2); i < text.size(); ++i) {
+        if (text[i] == '(') {
+            ++depth;
+        } else if (text[i] == ')') {
+            if (depth > 0) {
+                --depth;
+            } else {
+                return i + 1 < text.size() && text[i + 1] == ')' ? i + 1 : std::string::npos;
+            }
+        }
+    }
+    return std::string::npos;
+}
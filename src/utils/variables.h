@@ -1,55 +1,215 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <variant>
 #include <vector>
 
-// 表示 shell 变量的类型。
+#include "utils/string_array.h"
+#include "utils/string_map.h"
+
+// 表示 shell 变量的类型（与 Variable 中的可选类型按顺序对应）。
 enum class VarType {
     STRING,
     ARRAY,
     INTEGER,
+    ASSOC,
     READONLY
 };
 
 // 变量值封装，提供简单的类型转换能力。
-struct Variable {
-    VarType type = VarType::STRING;
-    std::string stringValue;
-    std::vector<std::string> arrayValue;
-    int intValue = 0;
+//
+// 值按类型只保存一种：字符串（短字符串存放在 std::string 的内联缓冲区中）、数组（分块共享存储）、
+// 整数或关联数组（开放寻址的共享表）。
+// 整数在赋值时就写好十进制文本，展开时直接取视图，不再每次分配。
+class Variable {
+public:
     bool isReadonly = false;
 
     Variable() = default;
-    explicit Variable(const std::string& str, bool readonly = false);
-    explicit Variable(const std::vector<std::string>& arr, bool readonly = false);
-    explicit Variable(int value, bool readonly = false);
+    explicit Variable(std::string str, bool readonly = false);
+    explicit Variable(std::vector<std::string> arr, bool readonly = false);
+    explicit Variable(StringArray arr, bool readonly = false);
+    explicit Variable(std::int64_t value, bool readonly = false);
+    explicit Variable(StringMap map, bool readonly = false);
+
+    VarType type() const { return static_cast<VarType>(value_.index()); }
+
+    // 访问与类型不符的值时抛出 std::bad_variant_access
+    const std::string& stringValue() const { return std::get<std::string>(value_); }
+    std::string& stringValue() { return std::get<std::string>(value_); }
+    const StringArray& arrayValue() const { return std::get<StringArray>(value_); }
+    StringArray& arrayValue() { return std::get<StringArray>(value_); }
+    std::int64_t intValue() const { return std::get<Integer>(value_).value; }
+    const StringMap& mapValue() const { return std::get<StringMap>(value_); }
+    StringMap& mapValue() { return std::get<StringMap>(value_); }
+
+    /**
+     * @brief 标量形式的视图：字符串本身、整数的十进制文本、数组的第一个元素或关联数组最早插入的值
+     */
+    std::string_view view() const;
+
+    std::string toString() const { return std::string(view()); }
+
+private:
+    // 整数与它的十进制文本（最长 20 个字符）
+    struct Integer {
+        std::int64_t value = 0;
+        char text[20] = {};
+        std::uint8_t length = 0;
+    };
+
+    // 顺序与 VarType 的前四个值一致
+    std::variant<std::string, StringArray, Integer, StringMap> value_;
+};
+
+// 变量名的编号：同一个名字在整个进程中只对应一个编号，编号本身即可作为哈希值
+using NameId = std::uint32_t;
+
+// 变量名的驻留表。名字只在第一次出现时复制一次，之后各层变量表都按编号查找，
+// 作用域链再长也不会对同一个名字重复计算字符串哈希。
+class NameTable {
+public:
+    static NameTable& instance();
+
+    /**
+     * @brief 名字的编号，第一次出现时分配
+     */
+    NameId intern(std::string_view name);
+
+    /**
+     * @brief 已分配的编号；名字从未出现过时返回 std::nullopt，不会分配
+     */
+    std::optional<NameId> find(std::string_view name) const;
+
+    /**
+     * @brief 编号对应的名字
+     */
+    const std::string& name(NameId id) const { return *names_[id]; }
 
-    std::string toString() const;
+    size_t size() const { return names_.size(); }
+
+private:
+    // 支持以 string_view 查找，不必为查找构造 std::string
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+
+    std::unordered_map<std::string, NameId, Hash, std::equal_to<>> ids_;
+    std::vector<const std::string*> names_;  // 指向 ids_ 中的键，节点地址不会改变
 };
 
 // 管理 shell 变量的容器，支持设置、查询与展开。
+//
+// 变量按作用域分层：scopes_[0] 是全局作用域，pushScope() 为函数压入只保存局部变量的一层。
+// 每个作用域是一条表的链，只有链首可写；snapshot() 把各链首冻结后由两个管理器共享，
+// 之后双方的写入都进入各自新的链首，修改冻结层中的变量时先把它复制到链首（写时复制）。
 class VariableManager {
 public:
-    VariableManager() = default;
+    VariableManager();
+    VariableManager(VariableManager&&) noexcept = default;
+    VariableManager& operator=(VariableManager&&) noexcept = default;
+    // 复制请使用 snapshot()，它需要冻结当前的链首
+    VariableManager(const VariableManager&) = delete;
+    VariableManager& operator=(const VariableManager&) = delete;
 
-    Variable& set(const std::string& name, const Variable& value);
+    // 赋值写入名字可见的最内层作用域，都不可见时写入全局作用域
+    Variable& set(const std::string& name, Variable value);
     Variable& setString(const std::string& name, const std::string& value, bool readonly = false);
-    Variable& setArray(const std::string& name, const std::vector<std::string>& values, bool readonly = false);
-    Variable& setInteger(const std::string& name, int value, bool readonly = false);
+    Variable& setArray(const std::string& name, std::vector<std::string> values, bool readonly = false);
+    Variable& setInteger(const std::string& name, std::int64_t value, bool readonly = false);
 
     const Variable* get(const std::string& name) const;
     Variable* get(const std::string& name);
 
+    // 按编号访问，供预先解析过名字的调用方（如编译后的算术表达式）使用
+    Variable& set(NameId name, Variable value);
+    const Variable* get(NameId name) const;
+    Variable* get(NameId name);
+
     bool erase(const std::string& name);
     bool contains(const std::string& name) const;
 
+    /**
+     * @brief 进入函数作用域，O(1)
+     */
+    void pushScope();
+
+    /**
+     * @brief 离开函数作用域并丢弃其中的局部变量；已在全局作用域时不做任何事
+     */
+    void popScope();
+
+    /**
+     * @brief 当前的作用域层数（只有全局作用域时为 1）
+     */
+    size_t scopeDepth() const { return scopes_.size(); }
+
+    /**
+     * @brief 在最内层作用域定义局部变量，遮住外层的同名变量
+     */
+    Variable& setLocal(const std::string& name, Variable value);
+
+    /**
+     * @brief 子 shell 使用的变量快照：与当前管理器共享全部表，之后双方的修改互不可见
+     */
+    VariableManager snapshot();
+
+    /**
+     * @brief 单词恰好是 ${name[@]} 或 ${name[i,j]} 且 name 是数组时，把各元素作为独立的单词追加到 words
+     *
+     * name 是关联数组时也接受 ${(k)name}、${(v)name} 与 ${(kv)name}，按插入顺序追加键、值或键值对。
+     * 元素从数组存储直接复制到 words，不经过拼接后的中间字符串。
+     * @return 单词不是这种形式或 name 不是数组时返回 false，words 不变
+     */
+    bool expandArray(std::string_view word, std::vector<std::string>& words) const;
+
     using Resolver = std::function<std::optional<std::string>(const std::string&)>;
-    std::string expand(const std::string& input, const Resolver& resolver = {}) const;
+    // 执行 $(...) 或 `...` 中的命令，返回去掉末尾换行的输出；同一签名也用于 $((...)) 的求值
+    using Substituter = std::function<std::string(const std::string&)>;
+    std::string expand(const std::string& input, const Resolver& resolver = {},
+                       const Substituter& substitute = {}, const Substituter& arithmetic = {}) const;
 
 private:
-    std::unordered_map<std::string, Variable> variables_;
+    // 一层表；nullopt 表示变量在这一层被删除，遮住下层的同名变量
+    struct Layer {
+        std::unordered_map<NameId, std::optional<Variable>> entries;
+        std::shared_ptr<const Layer> parent;
+        size_t depth = 1;  // 包括自身在内的链长
+    };
+
+    std::vector<std::shared_ptr<Layer>> scopes_;
+
+    // 名字可见的条目（可能是删除标记）与所在的作用域；都没有时返回 nullptr
+    const std::optional<Variable>* find(NameId name, size_t& scope) const;
+    // 冻结作用域的链首，返回以它为父层的空链首；链过长时先合并为一层
+    static std::shared_ptr<const Layer> freeze(std::shared_ptr<Layer>& layer);
+
+    // 展开 ${...} 的内容（或 $name 的名字），结果追加到 out
+    void expandParameter(std::string_view body, const Resolver& resolver, const Substituter& substitute,
+                         const Substituter& arithmetic, std::string& out) const;
 };
 
+// 已完成展开的文本（如路径名展开的结果）在 $ 与 ` 前加反斜杠，之后再交给 expand 时原样保留，
+// 其中的 $(...) 不会被执行
+std::string escapeExpansion(std::string_view text);
+
+// 单词的路径名展开，按 POSIX 的顺序先用 expand 做一次参数、命令与算术展开，再匹配文件。
+// 每个结果（没有匹配时为展开后去掉模式转义的单词）都经 escapeExpansion 标记后交给 add，
+// 因此文件名中的 $(...) 不会执行，单词中的命令替换也只执行一次
+void expandPathname(const std::string& word, const std::function<std::string(const std::string&)>& expand,
+                    const std::function<void(std::string)>& add);
+
+// 命令替换的结束位置：open 指向 "$(" 的 '$' 时返回匹配的 ')'，指向 '`' 时返回下一个未转义的 '`'；
+// 跳过引号内的内容并处理嵌套，没有闭合时返回 npos
+size_t substitutionEnd(const std::string& text, size_t open);
+
+// 算术展开的结束位置：open 指向 "$((" 的 '$' 或 "((" 的第一个 '(' 时返回结尾 "))" 中后一个 ')'；
+// 括号不平衡（例如 $((cmd) ...) 形式的命令替换）时返回 npos
+size_t arithmeticEnd(const std::string& text, size_t open);
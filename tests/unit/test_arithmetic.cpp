@@ -0,0 +1,137 @@
+#include "../catch.hpp"
+#include "utils/arithmetic.h"
+#include "utils/variables.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace {
+
+std::int64_t eval(ArithmeticEngine& engine, VariableManager& vm, const std::string& expression) {
+    std::int64_t value = 0;
+    std::string error;
+    INFO(expression);
+    REQUIRE(engine.evaluate(expression, vm, value, error));
+    return value;
+}
+
+} // namespace
+
+TEST_CASE("ArithmeticEngine - Operators and precedence", "[arithmetic]") {
+    ArithmeticEngine engine;
+    VariableManager vm;
+
+    CHECK(eval(engine, vm, "1 + 2 * 3") == 7);
+    CHECK(eval(engine, vm, "(1 + 2) * 3") == 9);
+    CHECK(eval(engine, vm, "2 ** 3 ** 2") == 512);
+    CHECK(eval(engine, vm, "-2 ** 2") == 4);
+    CHECK(eval(engine, vm, "7 / 2 + 7 % 2") == 4);
+    CHECK(eval(engine, vm, "1 << 40") == (std::int64_t{1} << 40));
+    CHECK(eval(engine, vm, "~0 & 0xff | 010") == 255);
+    CHECK(eval(engine, vm, "2#101 + 16#ff") == 260);
+    CHECK(eval(engine, vm, "3 > 2 && 2 >= 2 && !(1 == 2)") == 1);
+    CHECK(eval(engine, vm, "0 || 5") == 1);
+    CHECK(eval(engine, vm, "1 ? 10 : 20") == 10);
+    CHECK(eval(engine, vm, "0 ? 10 : 1 ? 30 : 40") == 30);
+    CHECK(eval(engine, vm, "1, 2, 3") == 3);
+    CHECK(eval(engine, vm, "") == 0);
+    CHECK(eval(engine, vm, "9223372036854775807 + 1") == std::numeric_limits<std::int64_t>::min());
+}
+
+TEST_CASE("ArithmeticEngine - Variables and assignment", "[arithmetic]") {
+    ArithmeticEngine engine;
+    VariableManager vm;
+
+    CHECK(eval(engine, vm, "i = 5") == 5);
+    REQUIRE(vm.get("i")->type() == VarType::INTEGER);
+    CHECK(eval(engine, vm, "i += 3, i") == 8);
+    CHECK(eval(engine, vm, "i++") == 8);
+    CHECK(eval(engine, vm, "++i") == 10);
+    CHECK(eval(engine, vm, "i--, --i") == 8);
+    CHECK(eval(engine, vm, "a = b = 4") == 4);
+    CHECK(vm.get("a")->intValue() == 4);
+    CHECK(eval(engine, vm, "x <<= 2") == 0);
+
+    // 短路：右侧的赋值不执行
+    CHECK(eval(engine, vm, "0 && (j = 1)") == 0);
+    CHECK(vm.get("j") == nullptr);
+    CHECK(eval(engine, vm, "1 ? (k = 1) : (k = 2)") == 1);
+    CHECK(vm.get("k")->intValue() == 1);
+
+    // 字符串值按表达式递归求值
+    vm.setString("s", " 12 ");
+    vm.setString("t", "s * 2");
+    vm.setString("o", "010");
+    CHECK(eval(engine, vm, "t + unset_var") == 24);
+    CHECK(eval(engine, vm, "o") == 8);
+}
+
+TEST_CASE("ArithmeticEngine - Errors", "[arithmetic]") {
+    ArithmeticEngine engine;
+    VariableManager vm;
+    std::int64_t value = 0;
+    std::string error;
+
+    CHECK_FALSE(engine.evaluate("1 / 0", vm, value, error));
+    CHECK(error == "division by 0");
+    CHECK_FALSE(engine.evaluate("2 ** -1", vm, value, error));
+    CHECK(error == "exponent less than 0");
+    CHECK_FALSE(engine.evaluate("1 +", vm, value, error));
+    CHECK(error == "syntax error: operand expected (error token is \"\")");
+    CHECK_FALSE(engine.evaluate("(1 + 2", vm, value, error));
+    CHECK_FALSE(engine.evaluate("08", vm, value, error));
+    CHECK(error == "value too great for base (error token is \"08\")");
+    CHECK_FALSE(engine.evaluate("1 = 2", vm, value, error));
+
+    vm.setString("r", "r + 1");
+    CHECK_FALSE(engine.evaluate("r", vm, value, error));
+    CHECK(error == "r: expression recursion level exceeded");
+
+    vm.setInteger("ro", 1, true);
+    CHECK_FALSE(engine.evaluate("ro = 2", vm, value, error));
+    CHECK(error == "ro: readonly variable");
+
+    // 出错后栈被清空，后续求值不受影响
+    CHECK(eval(engine, vm, "1 + 1") == 2);
+}
+
+TEST_CASE("ArithmeticEngine - Compiled programs are cached by source", "[arithmetic]") {
+    ArithmeticEngine engine(2);
+    VariableManager vm;
+
+    for (int n = 0; n < 100; ++n) {
+        eval(engine, vm, "i = i + 1");
+    }
+    CHECK(vm.get("i")->intValue() == 100);
+    CHECK(engine.compileCount() == 1);
+
+    eval(engine, vm, "1");
+    eval(engine, vm, "i = i + 1");
+    eval(engine, vm, "2");   // 淘汰最久未用的 "1"
+    CHECK(engine.cachedCount() == 2);
+    eval(engine, vm, "i = i + 1");
+    CHECK(engine.compileCount() == 3);
+    eval(engine, vm, "1");
+    CHECK(engine.compileCount() == 4);
+
+    ArithmeticProgram program;
+    std::string error;
+    REQUIRE(ArithmeticEngine::compile("a && b", program, error));
+    CHECK(program.names == std::vector<std::string>{"a", "b"});
+    CHECK(program.ids == std::vector<NameId>{NameTable::instance().intern("a"), NameTable::instance().intern("b")});
+}
+
+TEST_CASE("VariableManager - Arithmetic expansion", "[arithmetic]") {
+    VariableManager vm;
+    std::vector<std::string> seen;
+    auto arithmetic = [&](const std::string& expression) {
+        seen.push_back(expression);
+        return std::string("N");
+    };
+
+    CHECK(vm.expand("a$((1 + (2 * 3)))b $((x<<1))", {}, {}, arithmetic) == "aNb N");
+    CHECK(seen == std::vector<std::string>{"1 + (2 * 3)", "x<<1"});
+    CHECK(arithmeticEnd("$((1) + (2))", 0) == std::string::npos);
+    CHECK(vm.expand("$((1+2))", {}, {}, {}) == "$((1+2))");
+}
@@ -0,0 +1,77 @@
+#include "../catch.hpp"
+#include "core/brace.h"
+#include "core/parser.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> expand(const std::string& word) {
+    BraceExpansion braces(word);
+    std::vector<std::string> words;
+    std::string next;
+    while (braces.next(next)) {
+        words.push_back(next);
+    }
+    return words;
+}
+
+} // namespace
+
+TEST_CASE("BraceExpansion - Lists", "[brace]") {
+    CHECK(expand("{a,b,c}") == std::vector<std::string>{"a", "b", "c"});
+    CHECK(expand("pre{a,b}post") == std::vector<std::string>{"preapost", "prebpost"});
+    CHECK(expand("{a,b}{1,2}") == std::vector<std::string>{"a1", "a2", "b1", "b2"});
+    CHECK(expand("{a,b{1,2},c}") == std::vector<std::string>{"a", "b1", "b2", "c"});
+    CHECK(expand("x{,y}") == std::vector<std::string>{"x", "xy"});
+}
+
+TEST_CASE("BraceExpansion - Ranges", "[brace]") {
+    CHECK(expand("{1..5}") == std::vector<std::string>{"1", "2", "3", "4", "5"});
+    CHECK(expand("{3..1}") == std::vector<std::string>{"3", "2", "1"});
+    CHECK(expand("{-1..1}") == std::vector<std::string>{"-1", "0", "1"});
+    CHECK(expand("{1..10..4}") == std::vector<std::string>{"1", "5", "9"});
+    CHECK(expand("{10..1..-4}") == std::vector<std::string>{"10", "6", "2"});
+    CHECK(expand("{08..11}") == std::vector<std::string>{"08", "09", "10", "11"});
+    CHECK(expand("{a..e..2}") == std::vector<std::string>{"a", "c", "e"});
+    CHECK(expand("f{1..2}{x,y}") == std::vector<std::string>{"f1x", "f1y", "f2x", "f2y"});
+}
+
+TEST_CASE("BraceExpansion - Words left alone", "[brace]") {
+    CHECK_FALSE(BraceExpansion("{a}").expands());
+    CHECK_FALSE(BraceExpansion("{}").expands());
+    CHECK_FALSE(BraceExpansion("${a,b}").expands());
+    CHECK_FALSE(BraceExpansion("$(echo {a,b})").expands());
+    CHECK_FALSE(BraceExpansion("{a..}").expands());
+    CHECK_FALSE(BraceExpansion("\\{a,b}").expands());
+    CHECK(expand("{a,{b},c}") == std::vector<std::string>{"a", "{b}", "c"});
+    CHECK(expand("${x}{1,2}") == std::vector<std::string>{"${x}1", "${x}2"});
+}
+
+TEST_CASE("BraceExpansion - Huge ranges are generated lazily", "[brace]") {
+    BraceExpansion braces("{1..100000000}{a,b}");
+    REQUIRE(braces.expands());
+    CHECK(braces.count() == 200000000u);
+
+    std::string word;
+    REQUIRE(braces.next(word));
+    CHECK(word == "1a");
+    REQUIRE(braces.next(word));
+    CHECK(word == "1b");
+    REQUIRE(braces.next(word));
+    CHECK(word == "2a");
+
+    braces.reset();
+    REQUIRE(braces.next(word));
+    CHECK(word == "1a");
+}
+
+TEST_CASE("CommandParser - Brace expansion flags", "[brace]") {
+    CommandParser parser;
+    std::vector<unsigned char> flags;
+
+    auto tokens = parser.parseCommand("echo {a,b} '{c,d}' *{.h,.cpp}", &flags);
+    REQUIRE(tokens == std::vector<std::string>{"echo", "{a,b}", "{c,d}", "*{.h,.cpp}"});
+    CHECK(flags == std::vector<unsigned char>{0, WORD_BRACE, 0, WORD_GLOB | WORD_BRACE});
+}
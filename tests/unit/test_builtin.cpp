@@ -3,6 +3,11 @@
 #include "builtin/builtin_context.h"
 #include "utils/variables.h"
 #include "core/parser.h"
+#include "utils/colors.h"
+#include "history/history_store.h"
+
+#include <iostream>
+#include <sstream>
 
 TEST_CASE("BuiltinManager - Command registration", "[builtin]") {
     BuiltinManager manager;
@@ -79,4 +84,64 @@ TEST_CASE("BuiltinManager - Command execution", "[builtin]") {
         REQUIRE(result.shouldExit == true);
         REQUIRE(context.exitRequested == true);
     }
+
+    SECTION("History lists the newest records counting back from the end") {
+        leizi::HistoryStore store;
+        for (int i = 0; i < 100; ++i) {
+            leizi::HistoryRecord record;
+            record.command = "cmd " + std::to_string(i);
+            record.exitCode = i % 10 == 0 ? 1 : 0;
+            store.add(std::move(record));
+        }
+        context.historyStore = &store;
+
+        std::ostringstream out;
+        std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+        manager.execute({"history", "2"}, context);
+        manager.execute({"history", "--failed", "1"}, context);
+        std::cout.rdbuf(saved);
+
+        CHECK(out.str().find("-2" + Color::RESET + " cmd 98\n") != std::string::npos);
+        CHECK(out.str().find("-1" + Color::RESET + " cmd 99\n") != std::string::npos);
+        CHECK(out.str().find("-10" + Color::RESET + " cmd 90\n") != std::string::npos);
+        CHECK(out.str().find("cmd 97") == std::string::npos);
+    }
+
+    SECTION("History fallback numbers only live entries") {
+        history = {"ls", "", "make", "", "", "git status"};
+        std::ostringstream out;
+        std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+        auto result = manager.execute({"history", "2"}, context);
+        std::cout.rdbuf(saved);
+
+        REQUIRE(result.exitCode == 0);
+        CHECK(out.str().find("2" + Color::RESET + " make\n") != std::string::npos);
+        CHECK(out.str().find("3" + Color::RESET + " git status\n") != std::string::npos);
+        CHECK(out.str().find("ls") == std::string::npos);
+    }
+
+    SECTION("Unset array elements and map keys") {
+        variables.set("arr", Variable(std::vector<std::string>{"a", "b", "c", "d"}));
+        StringMap map;
+        map.set("k", "v");
+        map.set("other", "w");
+        variables.set("map", Variable(std::move(map)));
+
+        REQUIRE(manager.execute({"unset", "arr[2]"}, context).exitCode == 0);
+        REQUIRE(manager.execute({"unset", "arr[-1]"}, context).exitCode == 0);
+        REQUIRE(manager.execute({"unset", "arr[9]"}, context).exitCode == 0);
+        CHECK(variables.get("arr")->arrayValue().toVector() == std::vector<std::string>{"a", "c"});
+        CHECK(manager.execute({"unset", "arr[0]"}, context).exitCode == 1);
+
+        REQUIRE(manager.execute({"unset", "map[k]"}, context).exitCode == 0);
+        CHECK(variables.get("map")->mapValue().size() == 1);
+
+        variables.get("map")->isReadonly = true;
+        variables.get("arr")->isReadonly = true;
+        CHECK(manager.execute({"unset", "map[other]"}, context).exitCode == 1);
+        CHECK(manager.execute({"unset", "arr[1]"}, context).exitCode == 1);
+        CHECK(manager.execute({"unset", "arr"}, context).exitCode == 1);
+        CHECK(variables.get("map")->mapValue().size() == 1);
+        CHECK(variables.get("arr")->arrayValue().size() == 2);
+    }
 }
@@ -0,0 +1,182 @@
+#include "../catch.hpp"
+#include "prompt/git_repo.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// 在临时目录中用 git 命令构造测试仓库
+class TempRepo {
+public:
+    TempRepo() {
+        char pattern[] = "/tmp/leizi_git_XXXXXX";
+        const char* dir = mkdtemp(pattern);
+        path_ = dir ? dir : "";
+    }
+
+    ~TempRepo() {
+        if (!path_.empty()) {
+            std::system(("rm -rf '" + path_ + "'").c_str());
+        }
+    }
+
+    const std::string& path() const { return path_; }
+
+    bool git(const std::string& args) const {
+        std::string cmd = "cd '" + path_ + "' && git -c user.name=test -c user.email=test@example.com "
+                          "-c commit.gpgsign=false " + args + " >/dev/null 2>&1";
+        return std::system(cmd.c_str()) == 0;
+    }
+
+    std::string revParse(const std::string& rev) const {
+        std::string cmd = "cd '" + path_ + "' && git rev-parse " + rev + " 2>/dev/null";
+        FILE* pipe = popen(cmd.c_str(), "r");
+        if (!pipe) return "";
+        char buffer[64] = {};
+        std::string out = fgets(buffer, sizeof(buffer), pipe) ? buffer : "";
+        pclose(pipe);
+        while (!out.empty() && out.back() == '\n') out.pop_back();
+        return out;
+    }
+
+    void commit(const std::string& message) const {
+        std::ofstream(path_ + "/file.txt", std::ios::app) << message << "\n";
+        git("add file.txt");
+        git("commit -q -m '" + message + "'");
+    }
+
+private:
+    std::string path_;
+};
+
+bool haveGit() {
+    return std::system("git --version >/dev/null 2>&1") == 0;
+}
+
+} // namespace
+
+TEST_CASE("GitRepository reads HEAD, refs and config", "[git]") {
+    if (!haveGit()) return;
+
+    TempRepo repo;
+    REQUIRE(repo.git("init -q -b main ."));
+    repo.commit("one");
+    REQUIRE(repo.git("config branch.main.remote origin"));
+    REQUIRE(repo.git("config branch.main.merge refs/heads/main"));
+
+    // 子目录中也能找到仓库
+    mkdir((repo.path() + "/sub").c_str(), 0755);
+    auto found = GitRepository::discover(repo.path() + "/sub");
+    REQUIRE(found);
+
+    auto head = found->readHead();
+    CHECK(head.branch == "main");
+    CHECK_FALSE(head.detached);
+    CHECK(head.commit == repo.revParse("HEAD"));
+
+    auto upstream = found->upstreamRef("main");
+    REQUIRE(upstream);
+    CHECK(*upstream == "refs/remotes/origin/main");
+    CHECK_FALSE(found->upstreamRef("other"));
+
+    SECTION("detached HEAD resolves tags") {
+        REQUIRE(repo.git("tag v1.0"));
+        REQUIRE(repo.git("checkout -q --detach"));
+        auto detached = GitRepository::discover(repo.path())->readHead();
+        CHECK(detached.detached);
+        CHECK(found->tagFor(detached.commit) == "v1.0");
+
+        REQUIRE(repo.git("pack-refs --all"));
+        CHECK(found->tagFor(detached.commit) == "v1.0");
+    }
+
+    CHECK_FALSE(GitRepository::discover("/"));
+}
+
+#ifdef LEIZI_HAVE_ZLIB
+TEST_CASE("GitRepository counts ahead and behind", "[git]") {
+    if (!haveGit()) return;
+
+    TempRepo repo;
+    REQUIRE(repo.git("init -q -b main ."));
+    repo.commit("base");
+    repo.commit("shared");
+    REQUIRE(repo.git("update-ref refs/remotes/origin/main HEAD"));
+    repo.commit("local 1");
+    repo.commit("local 2");
+    REQUIRE(repo.git("checkout -q -b upstream origin/main"));
+    repo.commit("remote 1");
+    REQUIRE(repo.git("update-ref refs/remotes/origin/main HEAD"));
+    REQUIRE(repo.git("checkout -q main"));
+
+    auto found = GitRepository::discover(repo.path());
+    REQUIRE(found);
+    std::string local = found->resolveRef("refs/heads/main");
+    std::string upstream = found->resolveRef("refs/remotes/origin/main");
+    REQUIRE(local.size() == 40);
+    REQUIRE(upstream.size() == 40);
+
+    auto counts = found->aheadBehind(local, upstream, 1000);
+    REQUIRE(counts);
+    CHECK(counts->ahead == 2);
+    CHECK(counts->behind == 1);
+    CHECK_FALSE(counts->truncated);
+
+    auto same = found->aheadBehind(local, local, 1000);
+    REQUIRE(same);
+    CHECK(same->ahead == 0);
+    CHECK(same->behind == 0);
+
+    SECTION("packed objects and refs") {
+        REQUIRE(repo.git("gc -q --aggressive"));
+        auto packed = GitRepository::discover(repo.path());
+        REQUIRE(packed);
+        CHECK(packed->resolveRef("refs/remotes/origin/main") == upstream);
+
+        auto packedCounts = packed->aheadBehind(local, upstream, 1000);
+        REQUIRE(packedCounts);
+        CHECK(packedCounts->ahead == 2);
+        CHECK(packedCounts->behind == 1);
+    }
+
+    SECTION("walk limit marks the result as truncated") {
+        auto limited = found->aheadBehind(local, upstream, 1);
+        REQUIRE(limited);
+        CHECK(limited->truncated);
+    }
+}
+#endif
+
+TEST_CASE("GitRepository detects operations and stashes", "[git]") {
+    if (!haveGit()) return;
+
+    TempRepo repo;
+    REQUIRE(repo.git("init -q -b main ."));
+    repo.commit("one");
+
+    auto found = GitRepository::discover(repo.path());
+    REQUIRE(found);
+    CHECK(found->operationInProgress().empty());
+    CHECK(found->stashCount() == 0);
+
+    std::ofstream(repo.path() + "/file.txt", std::ios::app) << "dirty\n";
+    REQUIRE(repo.git("stash -q"));
+    std::ofstream(repo.path() + "/file.txt", std::ios::app) << "dirty again\n";
+    REQUIRE(repo.git("stash -q"));
+    CHECK(found->stashCount() == 2);
+
+    std::ofstream(found->gitDir() + "/MERGE_HEAD") << repo.revParse("HEAD") << "\n";
+    CHECK(found->operationInProgress() == "merge");
+    unlink((found->gitDir() + "/MERGE_HEAD").c_str());
+
+    std::ofstream(found->gitDir() + "/CHERRY_PICK_HEAD") << repo.revParse("HEAD") << "\n";
+    CHECK(found->operationInProgress() == "cherry-pick");
+    unlink((found->gitDir() + "/CHERRY_PICK_HEAD").c_str());
+
+    mkdir((found->gitDir() + "/rebase-merge").c_str(), 0755);
+    CHECK(found->operationInProgress() == "rebase");
+}
@@ -0,0 +1,189 @@
+#include "../catch.hpp"
+#include "core/glob.h"
+#include "core/parser.h"
+#include "utils/variables.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// 在临时目录中建立测试树，析构时删除
+class TempTree {
+public:
+    TempTree() {
+        char pattern[] = "/tmp/leizi_glob_XXXXXX";
+        REQUIRE(mkdtemp(pattern) != nullptr);
+        root_ = pattern;
+    }
+
+    ~TempTree() {
+        std::string command = "rm -rf '" + root_ + "'";
+        std::system(command.c_str());
+    }
+
+    void file(const std::string& path) {
+        int fd = open((root_ + "/" + path).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        REQUIRE(fd >= 0);
+        close(fd);
+    }
+
+    void dir(const std::string& path) {
+        REQUIRE(mkdir((root_ + "/" + path).c_str(), 0755) == 0);
+    }
+
+    void link(const std::string& target, const std::string& path) {
+        REQUIRE(symlink(target.c_str(), (root_ + "/" + path).c_str()) == 0);
+    }
+
+    const std::string& root() const { return root_; }
+
+private:
+    std::string root_;
+};
+
+std::vector<std::string> glob(const TempTree& tree, const std::string& pattern, unsigned threads = 1) {
+    auto matches = GlobPattern(tree.root() + "/" + pattern).expand(threads);
+    for (auto& match : matches) {
+        match.erase(0, tree.root().size() + 1);
+    }
+    return matches;
+}
+
+} // namespace
+
+TEST_CASE("GlobMatcher - Segment patterns", "[glob]") {
+    CHECK(GlobMatcher("*.cpp").matches("main.cpp"));
+    CHECK_FALSE(GlobMatcher("*.cpp").matches("main.cpp.o"));
+    CHECK(GlobMatcher("a*b*c").matches("aXbYbZc"));
+    CHECK_FALSE(GlobMatcher("a*b*c").matches("aXbYc_"));
+    CHECK(GlobMatcher("?.txt").matches("a.txt"));
+    CHECK_FALSE(GlobMatcher("?.txt").matches(".txt"));
+    CHECK(GlobMatcher("[a-c]x").matches("bx"));
+    CHECK_FALSE(GlobMatcher("[!a-c]x").matches("bx"));
+    CHECK(GlobMatcher("[]]").matches("]"));
+    CHECK(GlobMatcher("[[:digit:]]*").matches("7up"));
+    CHECK(GlobMatcher("[ab").matches("[ab"));
+    CHECK(GlobMatcher("\\*").matches("*"));
+    CHECK_FALSE(GlobMatcher("\\*").matches("x"));
+    CHECK(GlobMatcher("**").matches(""));
+
+    CHECK(GlobMatcher("file\\?").isLiteral());
+    CHECK(GlobMatcher("file\\?").literal() == "file?");
+    CHECK_FALSE(GlobMatcher("file?").isLiteral());
+    CHECK(GlobMatcher(".*").matchesHidden());
+    CHECK_FALSE(GlobMatcher("*").matchesHidden());
+}
+
+TEST_CASE("GlobPattern - Directory matching", "[glob]") {
+    TempTree tree;
+    tree.dir("src");
+    tree.dir("src/core");
+    tree.dir("src/core/deep");
+    tree.dir("src/.hidden");
+    tree.dir("docs");
+    tree.file("src/main.cpp");
+    tree.file("src/main.h");
+    tree.file("src/core/a.cpp");
+    tree.file("src/core/deep/b.cpp");
+    tree.file("src/.hidden/c.cpp");
+    tree.file("src/.dot.cpp");
+    tree.file("README.md");
+    tree.link("src", "link");
+
+    CHECK(glob(tree, "src/*.cpp") == std::vector<std::string>{"src/main.cpp"});
+    CHECK(glob(tree, "src/.*") == std::vector<std::string>{"src/.dot.cpp", "src/.hidden"});
+    CHECK(glob(tree, "*/") == std::vector<std::string>{"docs/", "link/", "src/"});
+    CHECK(glob(tree, "*/main.?") == std::vector<std::string>{"link/main.h", "src/main.h"});
+    CHECK(glob(tree, "src/co*/a.cpp") == std::vector<std::string>{"src/core/a.cpp"});
+    CHECK(glob(tree, "nothing/*").empty());
+    CHECK(glob(tree, "*.txt").empty());
+
+    const std::vector<std::string> recursive {"src/core/a.cpp", "src/core/deep/b.cpp", "src/main.cpp"};
+    CHECK(glob(tree, "src/**/*.cpp") == recursive);
+    CHECK(glob(tree, "src/**/**/*.cpp", 4) == recursive);
+    CHECK(glob(tree, "src/**/*.cpp", 4) == recursive);
+    CHECK(glob(tree, "**/deep") == std::vector<std::string>{"src/core/deep"});
+    CHECK(glob(tree, "src/**") ==
+          std::vector<std::string>{"src/core", "src/core/a.cpp", "src/core/deep", "src/core/deep/b.cpp",
+                                   "src/main.cpp", "src/main.h"});
+    CHECK(GlobPattern("a/**/b").recursive());
+    CHECK_FALSE(GlobPattern("a/*/b").recursive());
+}
+
+TEST_CASE("CommandParser - Glob pattern flags", "[glob]") {
+    CommandParser parser;
+    std::vector<unsigned char> patterns;
+
+    auto tokens = parser.parseCommand("ls *.cpp '*.h' \"a?\"b src/[ab]* $(ls *) > out*", &patterns);
+    REQUIRE(tokens == std::vector<std::string>{"ls", "*.cpp", "*.h", "a?b", "src/[ab]*", "$(ls *)", ">", "out*"});
+    CHECK(patterns == std::vector<unsigned char>{0, WORD_GLOB, 0, 0, WORD_GLOB, 0, 0, WORD_GLOB});
+
+    std::vector<std::vector<unsigned char>> stages;
+    auto pipeline = parser.parsePipeline("cat *.txt | grep x?", &stages);
+    REQUIRE(pipeline.size() == 2);
+    CHECK(stages == std::vector<std::vector<unsigned char>>{{0, WORD_GLOB}, {0, WORD_GLOB}});
+}
+
+TEST_CASE("CommandParser - Quoted glob characters in mixed words", "[glob]") {
+    CommandParser parser;
+    std::vector<unsigned char> patterns;
+
+    auto tokens = parser.parseCommand("echo \"x*\"y* 'a\\'? \"b?\"", &patterns);
+    REQUIRE(tokens == std::vector<std::string>{"echo", "x\\*y*", "a\\\\?", "b?"});
+    CHECK(patterns == std::vector<unsigned char>{0, WORD_GLOB, WORD_GLOB, 0});
+    // 不需要标志的调用方得到去掉引号后的原文
+    CHECK(parser.parseCommand("echo \"x*\"y*") == std::vector<std::string>{"echo", "x*y*"});
+
+    CHECK(GlobPattern::unescape("x\\*y*") == "x*y*");
+    CHECK(GlobPattern::unescape("a\\\\?\\$") == "a\\?\\$");
+
+    TempTree tree;
+    tree.file("x*y1");
+    tree.file("xAy1");
+    tree.file("xBy2");
+    CHECK(glob(tree, "x\\*y*") == std::vector<std::string>{"x*y1"});
+    CHECK(glob(tree, "x*y*") == std::vector<std::string>{"x*y1", "xAy1", "xBy2"});
+}
+
+TEST_CASE("expandPathname - Words are expanded exactly once", "[glob]") {
+    TempTree tree;
+    tree.file("x$(touch PWNED)");
+
+    VariableManager vm;
+    int runs = 0;
+    const VariableManager::Substituter substitute = [&](const std::string&) {
+        ++runs;
+        return std::string("out");
+    };
+    const auto expand = [&](const std::string& word) { return vm.expand(word, {}, substitute); };
+    std::vector<std::string> words;
+    const auto add = [&](std::string word) { words.push_back(std::move(word)); };
+
+    SECTION("Matched file names are never rescanned") {
+        expandPathname(tree.root() + "/x*", expand, add);
+        REQUIRE(words.size() == 1);
+        // 执行时的展开原样还原文件名，不执行其中的命令替换
+        CHECK(expand(words[0]) == tree.root() + "/x$(touch PWNED)");
+        CHECK(runs == 0);
+    }
+
+    SECTION("Substitutions run once when nothing matches") {
+        expandPathname(tree.root() + "/$(cmd)*", expand, add);
+        REQUIRE(words.size() == 1);
+        CHECK(expand(words[0]) == tree.root() + "/out*");
+        CHECK(runs == 1);
+    }
+
+    SECTION("Substitutions run once before matching") {
+        expandPathname(tree.root() + "/$(cmd)?", expand, add);
+        expandPathname(tree.root() + "/x$(cmd)", expand, add);
+        REQUIRE(words.size() == 2);
+        CHECK(expand(words[1]) == tree.root() + "/xout");
+        CHECK(runs == 2);
+    }
+}
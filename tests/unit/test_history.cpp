@@ -0,0 +1,673 @@
+#include "../catch.hpp"
+#include "history/history_file.h"
+#include "history/history_record.h"
+#include "history/history_store.h"
+#include "history/history_search.h"
+#include "history/history_suggest.h"
+#include "history/history_list.h"
+#include "history/history_archive.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace leizi;
+
+namespace {
+
+// 临时历史文件，析构时删除
+class TempHistoryPath {
+public:
+    TempHistoryPath() {
+        char pattern[] = "/tmp/leizi_history_XXXXXX";
+        int fd = mkstemp(pattern);
+        if (fd >= 0) close(fd);
+        path_ = pattern;
+    }
+    ~TempHistoryPath() { unlink(path_.c_str()); }
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+std::vector<std::string> readCommands(const std::string& path) {
+    std::vector<std::string> commands;
+    for (const auto& record : HistoryFormat::parse(readFile(path))) {
+        commands.push_back(record.command);
+    }
+    return commands;
+}
+
+HistoryRecord makeRecord(const std::string& command) {
+    HistoryRecord record;
+    record.command = command;
+    return record;
+}
+
+} // namespace
+
+TEST_CASE("History records round-trip through the binary format", "[history]") {
+    HistoryRecord record;
+    record.command = "make -j8 && ./run\nsecond line";
+    record.startTime = 1700000000;
+    record.durationMs = 1234;
+    record.exitCode = -2;
+    record.sessionId = 0x0123456789abcdefULL;
+    record.cwd = "/home/user/项目";
+
+    std::string content(HistoryFormat::MAGIC);
+    HistoryFormat::encode(record, content);
+    HistoryFormat::encode(makeRecord("ls"), content);
+
+    auto records = HistoryFormat::parse(content);
+    REQUIRE(records.size() == 2);
+    CHECK(records[0].command == record.command);
+    CHECK(records[0].startTime == record.startTime);
+    CHECK(records[0].durationMs == record.durationMs);
+    CHECK(records[0].exitCode == record.exitCode);
+    CHECK(records[0].sessionId == record.sessionId);
+    CHECK(records[0].cwd == record.cwd);
+    CHECK(records[1].command == "ls");
+
+    SECTION("a torn trailing record is ignored") {
+        const size_t complete = content.size();
+        HistoryFormat::encode(makeRecord("partial"), content);
+        content.resize(content.size() - 3);
+        CHECK(HistoryFormat::parse(content).size() == 2);
+        CHECK(HistoryFormat::validLength(content) == complete);
+    }
+}
+
+TEST_CASE("Legacy plain-text history still loads", "[history]") {
+    TempHistoryPath tmp;
+    std::ofstream(tmp.path()) << "echo one\n\nls -la\n";
+
+    HistoryStore store;
+    REQUIRE(store.load(tmp.path()));
+    REQUIRE(store.size() == 2);
+    CHECK(store.at(0).command == "echo one");
+    CHECK(store.at(1).startTime == 0);
+
+    SECTION("opening a writer converts the file") {
+        HistoryFile writer(tmp.path());
+        REQUIRE(writer.append(makeRecord("pwd")));
+        CHECK(HistoryFormat::isBinary(readFile(tmp.path())));
+        CHECK(readCommands(tmp.path()) == std::vector<std::string>{"echo one", "ls -la", "pwd"});
+    }
+}
+
+TEST_CASE("HistoryFile appends immediately", "[history]") {
+    TempHistoryPath tmp;
+
+    HistoryFile writer(tmp.path());
+    REQUIRE(writer.append(makeRecord("echo one")));
+    REQUIRE(writer.append(makeRecord("ls -la")));
+
+    // 不需要析构或 flush，文件里已经有内容
+    auto commands = readCommands(tmp.path());
+    REQUIRE(commands.size() == 2);
+    CHECK(commands[0] == "echo one");
+    CHECK(commands[1] == "ls -la");
+
+    SECTION("a torn tail is truncated on open") {
+        {
+            std::ofstream file(tmp.path(), std::ios::app | std::ios::binary);
+            file << "\x40\x00\x00";
+        }
+        HistoryFile reopened(tmp.path());
+        REQUIRE(reopened.append(makeRecord("after crash")));
+        commands = readCommands(tmp.path());
+        REQUIRE(commands.size() == 3);
+        CHECK(commands[2] == "after crash");
+    }
+}
+
+TEST_CASE("HistoryFile interleaves concurrent writers", "[history]") {
+    TempHistoryPath tmp;
+
+    HistoryFile first(tmp.path());
+    HistoryFile second(tmp.path());
+    first.append(makeRecord("from first"));
+    second.append(makeRecord("from second"));
+    first.append(makeRecord("first again"));
+
+    auto commands = readCommands(tmp.path());
+    REQUIRE(commands.size() == 3);
+    CHECK(commands[1] == "from second");
+}
+
+TEST_CASE("HistoryFile compaction keeps the newest entries", "[history]") {
+    TempHistoryPath tmp;
+
+    HistoryFile writer(tmp.path());
+    HistoryFile other(tmp.path());
+    for (int i = 0; i < 10; ++i) {
+        writer.append(makeRecord("cmd " + std::to_string(i)));
+    }
+
+    CHECK_FALSE(writer.compact(20));
+    REQUIRE(writer.compact(4));
+
+    auto commands = readCommands(tmp.path());
+    REQUIRE(commands.size() == 4);
+    CHECK(commands.front() == "cmd 6");
+    CHECK(commands.back() == "cmd 9");
+
+    SECTION("writers holding the old file reopen the replacement") {
+        REQUIRE(other.append(makeRecord("after compaction")));
+        REQUIRE(writer.append(makeRecord("and another")));
+        commands = readCommands(tmp.path());
+        REQUIRE(commands.size() == 6);
+        CHECK(commands[4] == "after compaction");
+        CHECK(commands[5] == "and another");
+    }
+
+    SECTION("background compaction") {
+        writer.setMaxEntries(2);
+        writer.maybeCompact();
+        writer.wait();
+        commands = readCommands(tmp.path());
+        REQUIRE(commands.size() == 2);
+        CHECK(commands.back() == "cmd 9");
+    }
+}
+
+TEST_CASE("HistoryStore indexes the mapped file lazily from the tail", "[history]") {
+    TempHistoryPath tmp;
+
+    std::string content(HistoryFormat::MAGIC);
+    for (int i = 0; i < 5000; ++i) {
+        HistoryRecord record = makeRecord("cmd " + std::to_string(i));
+        record.exitCode = i % 7 == 0 ? 1 : 0;
+        HistoryFormat::encode(record, content);
+    }
+    std::ofstream(tmp.path(), std::ios::binary) << content;
+
+    HistoryStore store;
+    REQUIRE(store.load(tmp.path()));
+    CHECK_FALSE(store.empty());
+
+    HistoryRecordView view;
+    REQUIRE(store.recent(0, view));
+    CHECK(view.command == "cmd 4999");
+    REQUIRE(store.recent(10, view));
+    CHECK(view.command == "cmd 4989");
+
+    store.add(makeRecord("new command"));
+    REQUIRE(store.recent(0, view));
+    CHECK(view.command == "new command");
+    REQUIRE(store.recent(1, view));
+    CHECK(view.command == "cmd 4999");
+
+    CHECK(store.size() == 5001);
+    CHECK(store.at(0).command == "cmd 0");
+    CHECK(store.at(7).exitCode == 1);
+    CHECK(store.at(5000).command == "new command");
+    CHECK_FALSE(store.recent(5001, view));
+
+    SECTION("a torn tail falls back to a forward scan") {
+        content.append("\x30\x00\x00\x00garbage", 11);
+        std::ofstream(tmp.path(), std::ios::binary) << content;
+
+        HistoryStore torn;
+        REQUIRE(torn.load(tmp.path()));
+        REQUIRE(torn.recent(0, view));
+        CHECK(view.command == "cmd 4999");
+        CHECK(torn.size() == 5000);
+    }
+}
+
+TEST_CASE("HistorySearch finds substrings through the trigram index", "[history]") {
+    HistoryStore store;
+    HistorySearch search(store);
+
+    store.add(makeRecord("git status"));
+    store.add(makeRecord("make -j8"));
+    store.add(makeRecord("git commit -m 'fix build'"));
+    store.add(makeRecord("ls build/"));
+    store.add(makeRecord("git status"));
+
+    SECTION("matches are unique and ordered by tier, then recency") {
+        auto matches = search.search("build", 10);
+        REQUIRE(matches.size() == 2);
+        CHECK(matches[0].command == "ls build/");
+        CHECK(matches[1].command == "git commit -m 'fix build'");
+
+        matches = search.search("git", 10);
+        REQUIRE(matches.size() == 2);
+        CHECK(matches[0].command == "git status");
+        CHECK(matches[0].index == 0);
+        CHECK(matches[0].uses == 2);
+    }
+
+    SECTION("trigrams alone do not make a match") {
+        store.add(makeRecord("status git"));
+        CHECK(search.search("git status", 10).size() == 1);
+        CHECK(search.search("tus git", 10).size() == 1);
+        CHECK(search.search("no such command", 10).empty());
+    }
+
+    SECTION("smart case") {
+        store.add(makeRecord("echo HELLO"));
+        CHECK(search.search("hello", 10).size() == 1);
+        CHECK(search.search("Hello", 10).empty());
+    }
+
+    SECTION("short queries and new records") {
+        CHECK(search.search("ls", 10).size() == 1);
+        store.add(makeRecord("lsblk"));
+        auto matches = search.search("ls", 10);
+        REQUIRE(matches.size() == 2);
+        CHECK(matches[0].command == "lsblk");
+        CHECK(search.search("blk", 10).size() == 1);
+        CHECK(search.search("", 3).size() == 3);
+    }
+
+    SECTION("reloading the store rebuilds the index") {
+        TempHistoryPath tmp;
+        std::ofstream(tmp.path()) << "vim notes.txt\n";
+        REQUIRE(store.load(tmp.path()));
+        CHECK(search.search("git", 10).empty());
+        CHECK(search.search("notes", 10).size() == 1);
+        CHECK(search.indexedRecords() == 1);
+    }
+}
+
+TEST_CASE("HistorySearch backfills file records newest-first", "[history]") {
+    TempHistoryPath tmp;
+    std::string content(HistoryFormat::MAGIC);
+    for (int i = 0; i < 100; ++i) {
+        HistoryFormat::encode(makeRecord("make target" + std::to_string(i % 40)), content);
+    }
+    HistoryFormat::encode(makeRecord("git push origin"), content);
+    std::ofstream(tmp.path(), std::ios::binary) << content;
+
+    HistoryStore store;
+    REQUIRE(store.load(tmp.path()));
+    HistorySearch search(store);
+    store.add(makeRecord("make install"));
+
+    CHECK(search.sync(0));
+    CHECK(search.indexedRecords() == 1);
+    CHECK(search.sync(10));
+    CHECK(search.indexedRecords() == 11);
+
+    SECTION("searching before the backfill finishes scans the older records") {
+        auto matches = search.search("target3", 10);
+        REQUIRE(matches.size() == 10);
+        CHECK(matches[0].command == "make target3");
+        CHECK(matches[0].index == 18);
+        CHECK(matches[1].command == "make target39");
+        CHECK(search.indexedRecords() == 11);
+
+        matches = search.search("push", 10);
+        REQUIRE(matches.size() == 1);
+        CHECK(matches[0].index == 1);
+    }
+
+    SECTION("the backfill ends at the oldest record") {
+        while (search.sync(7)) {}
+        CHECK(search.indexedRecords() == 102);
+        CHECK(search.distinctCommands() == 42);
+
+        auto matches = search.search("target1", 20);
+        REQUIRE(matches.size() == 11);
+        CHECK(matches[0].command == "make target19");
+        CHECK(matches[0].uses == 3);
+
+        store.add(makeRecord("make target1"));
+        matches = search.search("target1", 1);
+        REQUIRE(matches.size() == 1);
+        CHECK(matches[0].command == "make target1");
+        CHECK(matches[0].index == 0);
+        CHECK(matches[0].uses == 4);
+    }
+}
+
+TEST_CASE("HistorySuggest returns the newest command with the typed prefix", "[history]") {
+    HistoryStore store;
+    HistorySuggest suggest(store);
+    auto inDirectory = [](const std::string& command, const std::string& cwd) {
+        HistoryRecord record = makeRecord(command);
+        record.cwd = cwd;
+        return record;
+    };
+
+    store.add(inDirectory("git status", "/src"));
+    store.add(inDirectory("git stash pop", "/src"));
+    store.add(inDirectory("git stash", "/tmp"));
+    store.add(inDirectory("make test", "/src"));
+    CHECK_FALSE(suggest.sync(0));
+
+    SECTION("the prefix selects a subtree, recency and directory pick the command") {
+        CHECK(suggest.suggest("git st", "/tmp") == "git stash");
+        CHECK(suggest.suggest("git st", "/src") == "git stash pop");
+        CHECK(suggest.suggest("git st", "/elsewhere") == "git stash");
+        CHECK(suggest.suggest("git stat", "/tmp") == "git status");
+        CHECK(suggest.suggest("m", "/tmp") == "make test");
+        CHECK(suggest.distinctCommands() == 4);
+    }
+
+    SECTION("no suggestion without a longer match") {
+        CHECK(suggest.suggest("", "/src").empty());
+        CHECK(suggest.suggest("git stash pop", "/src").empty());
+        CHECK(suggest.suggest("gti", "/src").empty());
+        CHECK(suggest.suggest("make test now", "/src").empty());
+    }
+
+    SECTION("reusing a command moves it forward without duplicating it") {
+        store.add(inDirectory("git status", "/tmp"));
+        suggest.sync(0);
+        CHECK(suggest.suggest("git st", "/tmp") == "git status");
+        CHECK(suggest.distinctCommands() == 4);
+    }
+
+    SECTION("only the newest candidates are kept per prefix") {
+        for (int i = 0; i < 20; ++i) {
+            store.add(inDirectory("git log -" + std::to_string(i), "/other"));
+        }
+        suggest.sync(0);
+        CHECK(suggest.suggest("git", "/src") == "git log -19");
+        CHECK(suggest.suggest("git s", "/src") == "git stash pop");
+    }
+
+    SECTION("multi-line commands are not suggested") {
+        store.add(makeRecord("for i in 1 2\ndo echo $i; done"));
+        suggest.sync(0);
+        CHECK(suggest.suggest("for", "").empty());
+    }
+}
+
+TEST_CASE("HistorySuggest backfills file records from the newest", "[history]") {
+    TempHistoryPath tmp;
+    std::string content(HistoryFormat::MAGIC);
+    for (int i = 0; i < 100; ++i) {
+        HistoryFormat::encode(makeRecord("cmd " + std::to_string(i)), content);
+    }
+    HistoryFormat::encode(makeRecord("ssh old-host"), content);
+    HistoryFormat::encode(makeRecord("ssh new-host"), content);
+    std::ofstream(tmp.path(), std::ios::binary) << content;
+
+    HistoryStore store;
+    REQUIRE(store.load(tmp.path()));
+    HistorySuggest suggest(store);
+
+    CHECK(suggest.sync(1));
+    CHECK(suggest.suggest("ssh", "") == "ssh new-host");
+    CHECK(suggest.suggest("cmd", "").empty());
+
+    store.add(makeRecord("ssh old-host"));
+    CHECK(suggest.sync(1));
+    CHECK(suggest.suggest("ssh", "") == "ssh old-host");
+
+    // 补充的旧记录不覆盖新记录
+    CHECK_FALSE(suggest.sync(1000));
+    CHECK(suggest.suggest("ssh", "") == "ssh old-host");
+    CHECK(suggest.suggest("cmd 9", "") == "cmd 99");
+    CHECK(suggest.distinctCommands() == 102);
+
+    SECTION("reloading resets the index") {
+        std::ofstream(tmp.path()) << "ls -la\n";
+        REQUIRE(store.load(tmp.path()));
+        CHECK_FALSE(suggest.sync(10));
+        CHECK(suggest.suggest("ssh", "").empty());
+        CHECK(suggest.suggest("l", "") == "ls -la");
+    }
+}
+
+TEST_CASE("HistoryStore imports records appended by other sessions", "[history]") {
+    TempHistoryPath tmp;
+    auto fromSession = [](const std::string& command, std::uint64_t session) {
+        HistoryRecord record = makeRecord(command);
+        record.sessionId = session;
+        return record;
+    };
+
+    HistoryFile mine(tmp.path());
+    HistoryFile theirs(tmp.path());
+    mine.append(fromSession("before load", 2));
+
+    HistoryStore store;
+    REQUIRE(store.load(tmp.path()));
+    CHECK(store.importAppended(1) == 0);
+
+    mine.append(fromSession("my command", 1));
+    store.add(fromSession("my command", 1));
+    theirs.append(fromSession("their command", 2));
+
+    REQUIRE(store.importAppended(1) == 1);
+    CHECK(store.size() == 3);
+    CHECK(store.at(2).command == "their command");
+    CHECK(store.importAppended(1) == 0);
+
+    SECTION("a partially written record waits for the next import") {
+        std::string partial;
+        HistoryFormat::encode(fromSession("still writing", 2), partial);
+        {
+            std::ofstream file(tmp.path(), std::ios::app | std::ios::binary);
+            file << partial.substr(0, partial.size() - 2);
+        }
+        CHECK(store.importAppended(1) == 0);
+        {
+            std::ofstream file(tmp.path(), std::ios::app | std::ios::binary);
+            file << partial.substr(partial.size() - 2);
+        }
+        REQUIRE(store.importAppended(1) == 1);
+        CHECK(store.at(3).command == "still writing");
+    }
+
+    SECTION("compaction replaces the file") {
+        for (int i = 0; i < 5; ++i) {
+            theirs.append(fromSession("old " + std::to_string(i), 2));
+        }
+        REQUIRE(store.importAppended(1) == 5);
+        REQUIRE(mine.compact(3));
+        theirs.append(fromSession("after compaction", 2));
+
+        REQUIRE(store.importAppended(1) == 1);
+        HistoryRecordView view;
+        REQUIRE(store.recent(0, view));
+        CHECK(view.command == "after compaction");
+    }
+}
+
+TEST_CASE("HistoryStore imports after compaction removed the last seen record", "[history]") {
+    TempHistoryPath tmp;
+    auto at = [](const std::string& command, std::int64_t startTime) {
+        HistoryRecord record = makeRecord(command);
+        record.startTime = startTime;
+        record.sessionId = 2;
+        return record;
+    };
+
+    HistoryFile theirs(tmp.path());
+    theirs.append(at("make", 100));
+    HistoryStore store;
+    REQUIRE(store.load(tmp.path()));
+    theirs.append(at("git status", 200));
+    theirs.append(at("make", 300));
+    REQUIRE(store.importAppended(1) == 2);
+
+    // 压缩去重后只剩较新的 make 之外的记录，随后其它会话又追加了两条
+    std::string content(HistoryFormat::MAGIC);
+    HistoryFormat::encode(at("git status", 200), content);
+    HistoryFormat::encode(at("ls", 400), content);
+    HistoryFormat::encode(at("pwd", 500), content);
+    const std::string replacement = tmp.path() + ".new";
+    std::ofstream(replacement, std::ios::binary) << content;
+    REQUIRE(std::rename(replacement.c_str(), tmp.path().c_str()) == 0);
+
+    REQUIRE(store.importAppended(1) == 2);
+    HistoryRecordView view;
+    REQUIRE(store.recent(1, view));
+    CHECK(view.command == "ls");
+    REQUIRE(store.recent(0, view));
+    CHECK(view.command == "pwd");
+    CHECK(store.importAppended(1) == 0);
+}
+
+TEST_CASE("HistoryStore imports a history file created after load", "[history]") {
+    TempHistoryPath tmp;
+    unlink(tmp.path().c_str());
+
+    HistoryStore store;
+    CHECK_FALSE(store.load(tmp.path()));
+
+    HistoryFile writer(tmp.path());
+    HistoryRecord record = makeRecord("first");
+    record.sessionId = 7;
+    writer.append(record);
+
+    REQUIRE(store.importAppended(1) == 1);
+    CHECK(store.at(0).command == "first");
+}
+
+TEST_CASE("HistoryList moves duplicates to the end", "[history]") {
+    HistoryList list;
+
+    CHECK(list.add("make") == HistoryList::AddResult::Added);
+    CHECK(list.add("git status") == HistoryList::AddResult::Added);
+    CHECK(list.add("make") == HistoryList::AddResult::Moved);
+    CHECK(list.add(" secret --token x") == HistoryList::AddResult::Ignored);
+    CHECK(list.add("") == HistoryList::AddResult::Ignored);
+
+    CHECK(list.size() == 2);
+    REQUIRE(list.entries().size() == 3);
+    CHECK(list.entries()[0].empty());
+    CHECK(list.entries()[1] == "git status");
+    CHECK(list.entries()[2] == "make");
+
+    SECTION("tombstones are compacted") {
+        for (int i = 0; i < 500; ++i) {
+            list.add(i % 2 ? "make" : "git status");
+        }
+        CHECK(list.size() == 2);
+        CHECK(list.entries().size() < 200);
+        CHECK(list.entries().back() == "make");
+        CHECK(list.add("git status") == HistoryList::AddResult::Moved);
+    }
+
+    SECTION("options can keep duplicates and spaced commands") {
+        list.setIgnoreDuplicates(false);
+        list.setIgnoreSpace(false);
+        CHECK(list.add("make") == HistoryList::AddResult::Added);
+        CHECK(list.add(" ls") == HistoryList::AddResult::Added);
+        CHECK(list.size() == 4);
+    }
+}
+
+TEST_CASE("HistoryArchive skips segments by time and bloom filter", "[history]") {
+    TempHistoryPath tmp;
+    unlink(tmp.path().c_str());
+    HistoryArchive archive(tmp.path());
+
+    auto segment = [](const std::string& prefix, std::int64_t start, int count) {
+        std::string records;
+        for (int i = 0; i < count; ++i) {
+            HistoryRecord record = makeRecord(prefix + " " + std::to_string(i));
+            record.startTime = start + i;
+            record.cwd = "/srv/" + prefix;
+            record.exitCode = prefix == "deploy" && i == 3 ? 1 : 0;
+            HistoryFormat::encode(record, records);
+        }
+        return records;
+    };
+    REQUIRE(archive.appendSegment(segment("compile", 1000, 500)));
+    REQUIRE(archive.appendSegment(segment("deploy", 2000, 500)));
+
+    auto segments = archive.segments();
+    REQUIRE(segments.size() == 2);
+    CHECK(segments[0].count == 500);
+    CHECK(segments[1].minTime == 2000);
+    CHECK(segments[1].maxTime == 2499);
+#if LEIZI_HAVE_ZLIB
+    CHECK(segments[0].compression == HistoryArchive::COMPRESSION_ZLIB);
+    CHECK(segments[0].storedSize < segments[0].rawSize);
+#endif
+
+    std::vector<std::string> found;
+    auto collect = [&found](const HistoryRecordView& record) {
+        found.emplace_back(record.command);
+        return true;
+    };
+
+    HistoryArchive::ScanStats stats;
+    HistoryArchive::Filter filter;
+    filter.contains = "deploy 42";
+    REQUIRE(archive.scan(filter, collect, &stats));
+    CHECK(found == std::vector<std::string>{"deploy 42", "deploy 420", "deploy 421", "deploy 422", "deploy 423",
+                                            "deploy 424", "deploy 425", "deploy 426", "deploy 427", "deploy 428",
+                                            "deploy 429"});
+    CHECK(stats.segments == 2);
+    CHECK(stats.skipped == 1);
+
+    found.clear();
+    filter = {};
+    filter.since = 2400;
+    REQUIRE(archive.scan(filter, collect, &stats));
+    CHECK(found.size() == 100);
+    CHECK(stats.skipped == 1);
+
+    found.clear();
+    filter = {};
+    filter.failedOnly = true;
+    REQUIRE(archive.scan(filter, collect, &stats));
+    CHECK(found == std::vector<std::string>{"deploy 3"});
+    CHECK(stats.skipped == 1);
+
+    found.clear();
+    filter = {};
+    filter.cwd = "/srv/compile";
+    REQUIRE(archive.scan(filter, [&found](const HistoryRecordView& record) {
+        found.emplace_back(record.command);
+        return found.size() < 3;
+    }, &stats));
+    CHECK(found.size() == 3);
+
+    SECTION("a torn segment is truncated before the next append") {
+        {
+            std::ofstream file(tmp.path(), std::ios::app | std::ios::binary);
+            file << "\x10\x00\x00";
+        }
+        REQUIRE(archive.appendSegment(segment("lint", 3000, 10)));
+        CHECK(archive.segments().size() == 3);
+    }
+}
+
+TEST_CASE("HistoryFile compaction moves old records into the archive", "[history]") {
+    TempHistoryPath tmp;
+    const std::string archivePath = HistoryArchive::pathFor(tmp.path());
+    unlink(archivePath.c_str());
+
+    HistoryFile writer(tmp.path());
+    writer.setArchive(archivePath, 8);
+    for (int i = 0; i < 12; ++i) {
+        writer.append(makeRecord("cmd " + std::to_string(i)));
+    }
+
+    // 旧记录不足一段时不压缩
+    CHECK_FALSE(writer.compact(6));
+    REQUIRE(writer.compact(4));
+    CHECK(readCommands(tmp.path()).front() == "cmd 8");
+
+    std::vector<std::string> archived;
+    HistoryArchive(archivePath).scan({}, [&archived](const HistoryRecordView& record) {
+        archived.emplace_back(record.command);
+        return true;
+    });
+    REQUIRE(archived.size() == 8);
+    CHECK(archived.front() == "cmd 0");
+    CHECK(archived.back() == "cmd 7");
+    unlink(archivePath.c_str());
+}
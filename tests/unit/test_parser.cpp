@@ -71,6 +71,49 @@ TEST_CASE("CommandParser - Special characters", "[parser]") {
         REQUIRE(result[2] == ">");
     }
 
+    SECTION("Descriptor prefixes and redirection operators") {
+        auto result = parser.parseCommand("cmd <in 2>>log 3<>rw 2>&1 >|out <&- &>>all");
+        REQUIRE(result == std::vector<std::string>{"cmd", "<", "in", "2>>", "log", "3<>", "rw", "2>&", "1",
+                                                   ">|", "out", "<&", "-", "&>>", "all"});
+    }
+
+    SECTION("Only unquoted digits directly before the operator are a descriptor") {
+        REQUIRE(parser.parseCommand("echo a2>f") == std::vector<std::string>{"echo", "a2", ">", "f"});
+        REQUIRE(parser.parseCommand("echo 2 >f") == std::vector<std::string>{"echo", "2", ">", "f"});
+        REQUIRE(parser.parseCommand("echo \"2\">f") == std::vector<std::string>{"echo", "2", ">", "f"});
+    }
+
+    SECTION("Here-documents are replaced by their bodies") {
+        auto result = parser.parseCommand("cat <<EOF 2<<-'END' <<<word\nhello $X\nEOF\n\tquoted\n\tEND");
+        REQUIRE(result == std::vector<std::string>{"cat", "<<", "hello $X\n", "2<<'", "quoted\n", "<<<", "word"});
+        CHECK(parser.hereDocDelimiters("cat <<EOF\nbody\nEOF").empty());
+
+        auto pending = parser.hereDocDelimiters("cat <<EOF | diff - <<-\"END\"");
+        REQUIRE(pending.size() == 2);
+        CHECK(pending[0].word == "EOF");
+        CHECK_FALSE(pending[0].stripTabs);
+        CHECK(pending[1].word == "END");
+        CHECK(pending[1].stripTabs);
+    }
+
+    SECTION("Command substitutions stay inside one word") {
+        REQUIRE(parser.parseCommand("echo $(echo a | tr a b) `pwd`x") ==
+                std::vector<std::string>{"echo", "$(echo a | tr a b)", "`pwd`x"});
+        REQUIRE(parser.parseCommand("echo '$(a' b)") == std::vector<std::string>{"echo", "$(a", "b)"});
+    }
+
+    SECTION("Arithmetic commands are a single word") {
+        REQUIRE(parser.parseCommand("((x <<= (1 < 2)))") == std::vector<std::string>{"((x <<= (1 < 2)))"});
+        CHECK(parser.hereDocDelimiters("((x<<2))").empty());
+    }
+
+    SECTION("Array literals stay inside one word") {
+        REQUIRE(parser.parseCommand("array A=(a \"b c\" $(echo d)) B+=(e) C[2]=(f)") ==
+                std::vector<std::string>{"array", "A=(a \"b c\" $(echo d))", "B+=(e)", "C[2]=(f)"});
+        REQUIRE(parser.parseCommand("echo x=(a b)") == std::vector<std::string>{"echo", "x=(a b)"});
+        REQUIRE(parser.parseCommand("echo \"x=\"(a b)") == std::vector<std::string>{"echo", "x=(a", "b)"});
+    }
+
     SECTION("Background operator") {
         auto result = parser.parseCommand("sleep 10 &");
         REQUIRE(result.size() == 3);
@@ -0,0 +1,219 @@
+#include "../catch.hpp"
+#include "prompt/prompt.h"
+#include "prompt/segments.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// 记录渲染次数的测试段落
+class CountingSegment : public PromptSegment {
+public:
+    CountingSegment(const char* name, unsigned deps, int* counter)
+        : name_(name), deps_(deps), counter_(counter) {}
+
+    const char* name() const override { return name_; }
+    unsigned inputs() const override { return deps_; }
+    void render(const PromptContext& context, std::string& out) override {
+        ++*counter_;
+        out += name_;
+        out += ":";
+        out += std::to_string(context.lastExitCode);
+    }
+
+private:
+    const char* name_;
+    unsigned deps_;
+    int* counter_;
+};
+
+} // namespace
+
+TEST_CASE("PromptGenerator - Segment caching", "[prompt]") {
+    PromptGenerator generator;
+    generator.clearSegments();
+
+    int invariantRenders = 0;
+    int exitRenders = 0;
+    generator.addSegment(std::make_unique<CountingSegment>("host", PromptInput::NONE, &invariantRenders));
+    generator.addSegment(std::make_unique<CountingSegment>("exit", PromptInput::EXIT_CODE, &exitRenders));
+
+    PromptContext context;
+    context.currentDirectory = "/tmp";
+    context.lastExitCode = 0;
+
+    SECTION("Unchanged inputs reuse rendered bytes") {
+        REQUIRE(generator.generate(context) == "host:0 exit:0");
+        REQUIRE(generator.generate(context) == "host:0 exit:0");
+        REQUIRE(invariantRenders == 1);
+        REQUIRE(exitRenders == 1);
+    }
+
+    SECTION("Changed input re-renders only dependent segments") {
+        generator.generate(context);
+        context.lastExitCode = 2;
+        context.currentDirectory = "/var";
+        REQUIRE(generator.generate(context) == "host:0 exit:2");
+        REQUIRE(invariantRenders == 1);
+        REQUIRE(exitRenders == 2);
+    }
+
+    SECTION("Timing breakdown covers every segment") {
+        generator.generate(context);
+        generator.generate(context);
+        const auto& timings = generator.lastTimings();
+        REQUIRE(timings.size() == 2);
+        REQUIRE(std::string(timings[0].name) == "host");
+        REQUIRE(timings[0].cached);
+        REQUIRE(timings[1].cached);
+    }
+
+    SECTION("Invalidate forces a full render") {
+        generator.generate(context);
+        generator.invalidate();
+        generator.generate(context);
+        REQUIRE(invariantRenders == 2);
+    }
+}
+
+TEST_CASE("PromptGenerator - Options", "[prompt]") {
+    PromptGenerator generator;
+    PromptContext context;
+    context.currentDirectory = "/home/test/project";
+    context.homeDirectory = "/home/test";
+
+    SECTION("Custom symbol is used") {
+        PromptOptions options;
+        options.showUser = false;
+        options.showGit = false;
+        options.showTime = false;
+        options.symbol = ">>";
+        generator.setOptions(options);
+
+        std::string prompt = generator.generate(context);
+        REQUIRE(prompt.find("~/project") != std::string::npos);
+        REQUIRE(prompt.find('@') == std::string::npos);
+        REQUIRE(prompt.find(">>") != std::string::npos);
+    }
+
+    SECTION("Hidden segments are not rendered") {
+        PromptOptions options;
+        options.showUser = false;
+        options.showGit = false;
+        options.showTime = false;
+        generator.setOptions(options);
+
+        generator.generate(context);
+        for (const auto& timing : generator.lastTimings()) {
+            REQUIRE(std::string(timing.name) != "user");
+            REQUIRE(std::string(timing.name) != "time");
+            REQUIRE(std::string(timing.name) != "git");
+        }
+    }
+}
+
+TEST_CASE("PromptGenerator - Right and transient prompt", "[prompt]") {
+    PromptGenerator generator;
+    generator.clearSegments();
+
+    int renders = 0;
+    generator.addSegment(std::make_unique<CountingSegment>("left", PromptInput::NONE, &renders));
+    generator.addSegment(std::make_unique<CountingSegment>("right", PromptInput::NONE, &renders),
+                         SegmentAlign::RIGHT);
+
+    PromptContext context;
+
+    SECTION("Right segments are positioned with a cursor move") {
+        context.columns = 40;
+        const std::string& prompt = generator.generate(context);
+        REQUIRE(prompt == "left:0\033[34Gright:0");
+        REQUIRE(PromptGenerator::displayWidth(prompt) == 13);
+    }
+
+    SECTION("Right segments are dropped when the width is unknown") {
+        REQUIRE(generator.generate(context) == "left:0");
+    }
+
+    SECTION("Right segments are dropped when they do not fit") {
+        context.columns = 10;
+        REQUIRE(generator.generate(context) == "left:0");
+    }
+
+    SECTION("Transient line moves up over the prompt rows only") {
+        context.columns = 40;
+        generator.generate(context);
+        std::string redraw = generator.transientLine("ls -la");
+        REQUIRE(redraw.rfind("\033[1A\r\033[J", 0) == 0);
+        REQUIRE(redraw.find("ls -la\n") != std::string::npos);
+    }
+
+    SECTION("Display width ignores escapes and readline markers") {
+        REQUIRE(PromptGenerator::displayWidth("\001\033[1m\002ab\033[0m❯") == 3);
+    }
+}
+
+TEST_CASE("CommandTimer - Pipeline stages are kept separately", "[prompt]") {
+    CommandTimer timer;
+    timer.start();
+
+    pid_t first = fork();
+    REQUIRE(first >= 0);
+    if (first == 0) _exit(0);
+    pid_t second = fork();
+    REQUIRE(second >= 0);
+    if (second == 0) {
+        usleep(50 * 1000);
+        _exit(3);
+    }
+
+    // 按结束的先后回收，各段按位置保存
+    int status = 0;
+    REQUIRE(timer.waitStage(1, second, &status) == second);
+    CHECK(WEXITSTATUS(status) == 3);
+    REQUIRE(timer.waitStage(0, first, &status) == first);
+    const CommandStats& total = timer.stop();
+
+    REQUIRE(timer.stages().size() == 2);
+    CHECK(timer.stages()[0].processes == 1);
+    CHECK(timer.stages()[1].processes == 1);
+    CHECK(timer.stages()[1].wallTime >= std::chrono::milliseconds(50));
+    CHECK(total.processes == 2);
+    CHECK(total.cpuTime() == timer.stages()[0].cpuTime() + timer.stages()[1].cpuTime());
+    CHECK(total.maxRssKb == std::max(timer.stages()[0].maxRssKb, timer.stages()[1].maxRssKb));
+    CHECK(total.wallTime >= timer.stages()[1].wallTime);
+
+    timer.start();
+    CHECK(timer.stages().empty());
+}
+
+TEST_CASE("DurationSegment - Threshold and formatting", "[prompt]") {
+    SECTION("Durations are formatted compactly") {
+        using namespace std::chrono;
+        REQUIRE(DurationSegment::formatDuration(milliseconds(850)) == "850ms");
+        REQUIRE(DurationSegment::formatDuration(milliseconds(3200)) == "3.2s");
+        REQUIRE(DurationSegment::formatDuration(seconds(125)) == "2m05s");
+        REQUIRE(DurationSegment::formatDuration(minutes(62)) == "1h02m");
+    }
+
+    SECTION("Segment only renders above the threshold") {
+        CommandStats stats;
+        stats.wallTime = std::chrono::milliseconds(500);
+
+        PromptContext context;
+        context.commandNumber = 1;
+        context.lastCommand = &stats;
+
+        DurationSegment segment(1000);
+        std::string out;
+        segment.render(context, out);
+        REQUIRE(out.empty());
+
+        stats.wallTime = std::chrono::milliseconds(1500);
+        segment.render(context, out);
+        REQUIRE(out.find("1.5s") != std::string::npos);
+    }
+}
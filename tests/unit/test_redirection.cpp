@@ -0,0 +1,166 @@
+#include "../catch.hpp"
+#include "core/parser.h"
+#include "core/redirection.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+TEST_CASE("RedirectionPlan collects every redirection in order", "[redirection]") {
+    RedirectionPlan plan;
+    std::string error;
+    std::vector<std::string> tokens {"cmd", "<", "in", "arg", ">", "$OUT", "2>&", "1", "3<&", "-", "4>&", "5-"};
+    auto expand = [](const std::string& word) { return word == "$OUT" ? std::string("out.txt") : word; };
+
+    REQUIRE(plan.parse(tokens, expand, error));
+    CHECK(tokens == std::vector<std::string>{"cmd", "arg"});
+
+    const auto& actions = plan.actions();
+    REQUIRE(actions.size() == 6);
+    CHECK(actions[0].type == FdAction::Type::Open);
+    CHECK(actions[0].fd == 0);
+    CHECK(actions[0].path == "in");
+    CHECK(actions[0].flags == O_RDONLY);
+    CHECK(actions[1].fd == 1);
+    CHECK(actions[1].path == "out.txt");
+    CHECK(actions[2].type == FdAction::Type::Dup);
+    CHECK(actions[2].fd == 2);
+    CHECK(actions[2].source == 1);
+    CHECK(actions[3].type == FdAction::Type::Close);
+    CHECK(actions[3].fd == 3);
+    CHECK(actions[4].type == FdAction::Type::Dup);
+    CHECK(actions[4].source == 5);
+    CHECK(actions[5].type == FdAction::Type::Close);
+    CHECK(actions[5].fd == 5);
+
+    SECTION("&> and >&file write both streams") {
+        for (const char* op : {"&>", ">&"}) {
+            RedirectionPlan both;
+            std::vector<std::string> words {"cmd", op, "log"};
+            REQUIRE(both.parse(words, nullptr, error));
+            REQUIRE(both.actions().size() == 2);
+            CHECK(both.actions()[0].fd == 1);
+            CHECK(both.actions()[1].fd == 2);
+            CHECK(both.actions()[1].source == 1);
+        }
+    }
+
+    SECTION("syntax errors") {
+        RedirectionPlan bad;
+        std::vector<std::string> missing {"cmd", ">"};
+        CHECK_FALSE(bad.parse(missing, nullptr, error));
+        CHECK(error == "syntax error near unexpected token `newline'");
+
+        std::vector<std::string> ambiguous {"cmd", "2>&", "file"};
+        CHECK_FALSE(bad.parse(ambiguous, nullptr, error));
+        CHECK(error == "file: ambiguous redirect");
+
+        std::vector<std::string> empty {"cmd", ">", "$UNSET"};
+        CHECK_FALSE(bad.parse(empty, [](const std::string&) { return std::string(); }, error));
+        CHECK(error == "$UNSET: ambiguous redirect");
+    }
+}
+
+TEST_CASE("RedirectionPlan opens files up front and feeds posix_spawn", "[redirection]") {
+    char pattern[] = "/tmp/leizi_redirect_XXXXXX";
+    REQUIRE(mkdtemp(pattern) != nullptr);
+    const std::string dir = pattern;
+    const std::string out = dir + "/out.txt";
+
+    std::string error;
+    RedirectionPlan plan;
+    std::vector<std::string> tokens {"sh", ">", dir + "/missing/x", "<", dir + "/none"};
+    REQUIRE(plan.parse(tokens, nullptr, error));
+    CHECK_FALSE(plan.open(error));
+    CHECK(error == dir + "/missing/x: No such file or directory");
+
+    RedirectionPlan spawnPlan;
+    tokens = {"sh", "-c", "echo out; echo err >&2", ">", out, "2>&", "1"};
+    REQUIRE(spawnPlan.parse(tokens, nullptr, error));
+    REQUIRE(spawnPlan.open(error));
+    for (const auto& action : spawnPlan.actions()) {
+        if (action.type == FdAction::Type::Open) {
+            CHECK(action.source >= 10);
+        }
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    REQUIRE(spawnPlan.addSpawnActions(&actions));
+
+    std::vector<char*> argv;
+    for (auto& token : tokens) argv.push_back(token.data());
+    argv.push_back(nullptr);
+
+    pid_t pid = -1;
+    REQUIRE(posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ) == 0);
+    posix_spawn_file_actions_destroy(&actions);
+    spawnPlan.release();
+
+    int status = 0;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status));
+    CHECK(readFile(out) == "out\nerr\n");
+
+    unlink(out.c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("RedirectionPlan feeds here-documents without temporary files", "[redirection]") {
+    auto readAll = [](int fd) {
+        std::string content;
+        char buf[65536];
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) content.append(buf, static_cast<size_t>(n));
+        return content;
+    };
+    auto expand = [](const std::string& text) {
+        std::string out = text;
+        auto at = out.find("$X");
+        if (at != std::string::npos) out.replace(at, 2, "value");
+        return out;
+    };
+
+    CommandParser parser;
+    std::string error;
+    RedirectionPlan plan;
+    auto tokens = parser.parseCommand("cat <<EOF 3<<'EOF' 4<<< $X\nx=$X\nEOF\nx=$X\nEOF");
+    REQUIRE(plan.parse(tokens, expand, error));
+    CHECK(tokens == std::vector<std::string>{"cat"});
+    REQUIRE(plan.actions().size() == 3);
+    CHECK(plan.actions()[0].type == FdAction::Type::Data);
+    CHECK(plan.actions()[0].data == "x=value\n");
+    CHECK(plan.actions()[1].fd == 3);
+    CHECK(plan.actions()[1].data == "x=$X\n");
+    CHECK(plan.actions()[2].data == "value\n");
+
+    REQUIRE(plan.open(error));
+    CHECK(readAll(plan.actions()[0].source) == "x=value\n");
+    CHECK(readAll(plan.actions()[1].source) == "x=$X\n");
+
+    SECTION("bodies larger than a pipe buffer") {
+        const std::string body(1 << 20, 'z');
+        RedirectionPlan large;
+        std::vector<std::string> words {"cat", "<<'", body};
+        REQUIRE(large.parse(words, nullptr, error));
+        REQUIRE(large.open(error));
+        CHECK(readAll(large.actions()[0].source) == body);
+    }
+}
@@ -0,0 +1,95 @@
+#include "../catch.hpp"
+#include "utils/string_array.h"
+#include "utils/variables.h"
+
+#include <string>
+#include <vector>
+
+TEST_CASE("StringArray - Chunked storage", "[array]") {
+    StringArray array;
+    const size_t count = StringArray::CHUNK_SIZE * 3 + 7;
+    for (size_t i = 0; i < count; ++i) {
+        array.push_back(std::to_string(i));
+    }
+    REQUIRE(array.size() == count);
+    CHECK(array.front() == "0");
+    CHECK(array[StringArray::CHUNK_SIZE] == std::to_string(StringArray::CHUNK_SIZE));
+    CHECK(array.back() == std::to_string(count - 1));
+
+    size_t seen = 0;
+    for (const auto& element : array) {
+        CHECK(element == std::to_string(seen++));
+    }
+    CHECK(seen == count);
+
+    array.resize(StringArray::CHUNK_SIZE + 1);
+    CHECK(array.size() == StringArray::CHUNK_SIZE + 1);
+    CHECK(array.back() == std::to_string(StringArray::CHUNK_SIZE));
+    array.resize(StringArray::CHUNK_SIZE + 3);
+    CHECK(array.back().empty());
+
+    StringArray fromVector(std::vector<std::string>{"a", "b", "c"});
+    CHECK(fromVector.toVector() == std::vector<std::string>{"a", "b", "c"});
+    fromVector.clear();
+    CHECK(fromVector.empty());
+}
+
+TEST_CASE("StringArray - Copies share chunks until written", "[array]") {
+    StringArray original;
+    for (size_t i = 0; i < StringArray::CHUNK_SIZE * 2; ++i) {
+        original.push_back("v" + std::to_string(i));
+    }
+    REQUIRE(original.unique());
+
+    StringArray copy = original;
+    CHECK_FALSE(original.unique());
+    CHECK(copy == original);
+
+    copy.set(0, "changed");
+    copy.push_back("appended");
+    CHECK(original[0] == "v0");
+    CHECK(original.size() == StringArray::CHUNK_SIZE * 2);
+    CHECK(copy[0] == "changed");
+    CHECK(copy.back() == "appended");
+    CHECK(copy[StringArray::CHUNK_SIZE] == "v" + std::to_string(StringArray::CHUNK_SIZE));
+    CHECK_FALSE(copy == original);
+}
+
+TEST_CASE("StringArray - Appending a million elements", "[array]") {
+    StringArray array;
+    for (int i = 0; i < 1000000; ++i) {
+        array.push_back("line");
+    }
+    CHECK(array.size() == 1000000);
+    CHECK(array[999999] == "line");
+}
+
+TEST_CASE("VariableManager - Arrays expand into separate words", "[array]") {
+    VariableManager vm;
+    vm.setArray("A", {"one", "two three", "four", "five"});
+    vm.setString("S", "scalar");
+
+    std::vector<std::string> words{"cmd"};
+    REQUIRE(vm.expandArray("${A[@]}", words));
+    CHECK(words == std::vector<std::string>{"cmd", "one", "two three", "four", "five"});
+
+    words.clear();
+    REQUIRE(vm.expandArray("${A[2,3]}", words));
+    CHECK(words == std::vector<std::string>{"two three", "four"});
+    words.clear();
+    REQUIRE(vm.expandArray("${A[-2,-1]}", words));
+    CHECK(words == std::vector<std::string>{"four", "five"});
+    words.clear();
+    REQUIRE(vm.expandArray("${A[3,2]}", words));
+    CHECK(words.empty());
+
+    CHECK_FALSE(vm.expandArray("${S[@]}", words));
+    CHECK_FALSE(vm.expandArray("${NONE[@]}", words));
+    CHECK_FALSE(vm.expandArray("x${A[@]}", words));
+    CHECK_FALSE(vm.expandArray("${A[1]}", words));
+    CHECK(words.empty());
+
+    CHECK(vm.expand("${A[2,3]}") == "two three four");
+    CHECK(vm.expand("${A[0,1]}") == "one");
+    CHECK(vm.expand("${#A[@]}") == "4");
+}
@@ -0,0 +1,146 @@
+#include "../catch.hpp"
+#include "utils/string_map.h"
+#include "utils/variables.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> keysOf(const StringMap& map) {
+    std::vector<std::string> keys;
+    for (const auto& entry : map) keys.push_back(entry.key);
+    return keys;
+}
+
+} // namespace
+
+TEST_CASE("StringMap - Lookup keeps insertion order", "[assoc]") {
+    StringMap map;
+    CHECK(map.empty());
+    CHECK(map.find("missing") == nullptr);
+    CHECK(map.begin() == map.end());
+
+    map.set("prod", "10.0.0.1");
+    map.set("dev", "127.0.0.1");
+    map.set("stage", "10.0.0.2");
+    map.set("prod", "10.0.0.9");  // 覆盖时保持原来的位置
+
+    REQUIRE(map.size() == 3);
+    CHECK(*map.find("prod") == "10.0.0.9");
+    CHECK(*map.find("dev") == "127.0.0.1");
+    CHECK(keysOf(map) == std::vector<std::string>{"prod", "dev", "stage"});
+
+    CHECK(map.erase("dev"));
+    CHECK_FALSE(map.erase("dev"));
+    CHECK(map.find("dev") == nullptr);
+    CHECK(map.size() == 2);
+    map.set("dev", "::1");  // 删除后重新插入排在最后
+    CHECK(keysOf(map) == std::vector<std::string>{"prod", "stage", "dev"});
+}
+
+TEST_CASE("StringMap - Growth and tombstones", "[assoc]") {
+    StringMap map;
+    for (int i = 0; i < 10000; ++i) {
+        map.set("key" + std::to_string(i), std::to_string(i));
+    }
+    for (int i = 0; i < 10000; i += 2) {
+        REQUIRE(map.erase("key" + std::to_string(i)));
+    }
+    // 反复插入删除不会让探测链失去空槽
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 1000; ++i) map.set("tmp" + std::to_string(i), "x");
+        for (int i = 0; i < 1000; ++i) REQUIRE(map.erase("tmp" + std::to_string(i)));
+    }
+
+    REQUIRE(map.size() == 5000);
+    for (int i = 0; i < 10000; ++i) {
+        const std::string* value = map.find("key" + std::to_string(i));
+        if (i % 2 == 0) {
+            CHECK(value == nullptr);
+        } else {
+            REQUIRE(value != nullptr);
+            CHECK(*value == std::to_string(i));
+        }
+    }
+    CHECK(map.begin()->key == "key1");
+}
+
+TEST_CASE("StringMap - Copies share the table until written", "[assoc]") {
+    StringMap original;
+    original.set("a", "1");
+    original.set("b", "2");
+    REQUIRE(original.unique());
+
+    StringMap copy = original;
+    CHECK_FALSE(original.unique());
+    CHECK(copy == original);
+    CHECK_FALSE(copy.erase("missing"));
+    CHECK_FALSE(copy.unique());
+
+    copy.set("a", "changed");
+    copy.erase("b");
+    CHECK(*original.find("a") == "1");
+    CHECK(*original.find("b") == "2");
+    CHECK(*copy.find("a") == "changed");
+    CHECK(copy.find("b") == nullptr);
+    CHECK(original.unique());
+    CHECK_FALSE(copy == original);
+}
+
+TEST_CASE("VariableManager - Associative array expansion", "[assoc]") {
+    VariableManager vm;
+    StringMap hosts;
+    hosts.set("prod", "10.0.0.1");
+    hosts.set("dev", "127.0.0.1");
+    hosts.set("my env", "10.9.9.9");
+    vm.set("hosts", Variable(std::move(hosts)));
+    vm.setString("env", "dev");
+
+    const Variable* variable = vm.get("hosts");
+    REQUIRE(variable->type() == VarType::ASSOC);
+    CHECK(variable->view() == "10.0.0.1");
+    CHECK(sizeof(Variable) <= sizeof(std::string) + 16);
+
+    CHECK(vm.expand("${hosts[prod]}") == "10.0.0.1");
+    CHECK(vm.expand("${hosts[$env]}") == "127.0.0.1");
+    CHECK(vm.expand("${hosts[my env]}") == "10.9.9.9");
+    CHECK(vm.expand("[${hosts[none]}]") == "[]");
+    CHECK(vm.expand("${hosts[none]:-fallback}") == "fallback");
+    CHECK(vm.expand("${#hosts}") == "3");
+    CHECK(vm.expand("${#hosts[prod]}") == "8");
+    CHECK(vm.expand("${(k)hosts}") == "prod dev my env");
+    CHECK(vm.expand("${(v)hosts}") == "10.0.0.1 127.0.0.1 10.9.9.9");
+    CHECK(vm.expand("${hosts[@]}") == "10.0.0.1 127.0.0.1 10.9.9.9");
+    CHECK(vm.expand("${(kv)hosts}") == "prod 10.0.0.1 dev 127.0.0.1 my env 10.9.9.9");
+    CHECK(vm.expand("${(k)hosts/e/E}") == "prod dEv my Env");
+
+    std::vector<std::string> words;
+    REQUIRE(vm.expandArray("${(k)hosts}", words));
+    CHECK(words == std::vector<std::string>{"prod", "dev", "my env"});
+    words.clear();
+    REQUIRE(vm.expandArray("${(kv)hosts}", words));
+    CHECK(words.size() == 6);
+    words.clear();
+    REQUIRE(vm.expandArray("${hosts[@]}", words));
+    CHECK(words.back() == "10.9.9.9");
+    words.clear();
+    CHECK_FALSE(vm.expandArray("${hosts[prod]}", words));
+    CHECK_FALSE(vm.expandArray("${(x)hosts}", words));
+    CHECK_FALSE(vm.expandArray("${(k)env}", words));
+    CHECK(words.empty());
+}
+
+TEST_CASE("VariableManager - Associative arrays in snapshots", "[assoc]") {
+    VariableManager vm;
+    StringMap config;
+    config.set("retries", "3");
+    vm.set("config", Variable(std::move(config)));
+
+    VariableManager child = vm.snapshot();
+    child.get("config")->mapValue().set("retries", "5");
+    child.get("config")->mapValue().set("timeout", "30");
+
+    CHECK(vm.expand("${(kv)config}") == "retries 3");
+    CHECK(child.expand("${(kv)config}") == "retries 5 timeout 30");
+}
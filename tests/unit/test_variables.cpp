@@ -1,5 +1,11 @@
 #include "../catch.hpp"
 #include "utils/variables.h"
+#include "core/capture.h"
+
+#include <iostream>
+#include <optional>
+#include <sys/wait.h>
+#include <unistd.h>
 
 TEST_CASE("VariableManager - Basic operations", "[variables]") {
     VariableManager vm;
@@ -8,7 +14,7 @@ TEST_CASE("VariableManager - Basic operations", "[variables]") {
         vm.setString("TEST", "hello");
         auto* var = vm.get("TEST");
         REQUIRE(var != nullptr);
-        REQUIRE(var->type == VarType::STRING);
+        REQUIRE(var->type() == VarType::STRING);
         REQUIRE(var->toString() == "hello");
     }
 
@@ -17,9 +23,9 @@ TEST_CASE("VariableManager - Basic operations", "[variables]") {
         vm.setArray("ARR", arr);
         auto* var = vm.get("ARR");
         REQUIRE(var != nullptr);
-        REQUIRE(var->type == VarType::ARRAY);
-        REQUIRE(var->arrayValue.size() == 3);
-        REQUIRE(var->arrayValue[0] == "a");
+        REQUIRE(var->type() == VarType::ARRAY);
+        REQUIRE(var->arrayValue().size() == 3);
+        REQUIRE(var->arrayValue()[0] == "a");
     }
 
     SECTION("Erase variable") {
@@ -35,6 +41,27 @@ TEST_CASE("VariableManager - Basic operations", "[variables]") {
     }
 }
 
+TEST_CASE("Variable - Compact representation", "[variables]") {
+    // 只保存一种值，不再同时带有字符串、数组与整数三份成员
+    CHECK(sizeof(Variable) <= sizeof(std::string) + 16);
+
+    Variable integer(std::int64_t(-9223372036854775807LL - 1));
+    REQUIRE(integer.type() == VarType::INTEGER);
+    CHECK(integer.view() == "-9223372036854775808");
+    CHECK(Variable(std::int64_t(0)).view() == "0");
+    CHECK(integer.toString() == "-9223372036854775808");
+
+    Variable text(std::string("short"), true);
+    CHECK(text.type() == VarType::STRING);
+    CHECK(text.isReadonly);
+    CHECK(text.view().data() == text.stringValue().data());
+    CHECK_THROWS_AS(text.intValue(), std::bad_variant_access);
+
+    Variable array(std::vector<std::string>{"first", "second"});
+    CHECK(array.view() == "first");
+    CHECK(Variable(std::vector<std::string>{}).view().empty());
+}
+
 TEST_CASE("VariableManager - String operations", "[variables]") {
     VariableManager vm;
 
@@ -42,7 +69,7 @@ TEST_CASE("VariableManager - String operations", "[variables]") {
         vm.setString("TEST_VAR", "test_value");
         auto* var = vm.get("TEST_VAR");
         REQUIRE(var != nullptr);
-        REQUIRE(var->type == VarType::STRING);
+        REQUIRE(var->type() == VarType::STRING);
         REQUIRE(var->toString() == "test_value");
     }
 
@@ -69,9 +96,247 @@ TEST_CASE("VariableManager - Array operations", "[variables]") {
 
         auto* var = vm.get("MY_ARRAY");
         REQUIRE(var != nullptr);
-        REQUIRE(var->type == VarType::ARRAY);
-        REQUIRE(var->arrayValue.size() == 3);
-        REQUIRE(var->arrayValue[0] == "one");
-        REQUIRE(var->arrayValue[2] == "three");
+        REQUIRE(var->type() == VarType::ARRAY);
+        REQUIRE(var->arrayValue().size() == 3);
+        REQUIRE(var->arrayValue()[0] == "one");
+        REQUIRE(var->arrayValue()[2] == "three");
+    }
+}
+
+TEST_CASE("VariableManager - Scopes and snapshots", "[variables]") {
+    VariableManager vm;
+    vm.setString("G", "global");
+    vm.setString("X", "outer");
+
+    SECTION("locals shadow outer variables until the scope is left") {
+        vm.pushScope();
+        REQUIRE(vm.scopeDepth() == 2);
+        vm.setLocal("X", Variable(std::string("inner")));
+        vm.set("G", Variable(std::string("changed")));
+        vm.set("NEW", Variable(std::string("created")));
+        CHECK(vm.expand("$X $G $NEW") == "inner changed created");
+
+        vm.pushScope();
+        vm.set("X", Variable(std::string("assigned")));
+        CHECK(vm.erase("G"));
+        CHECK_FALSE(vm.contains("G"));
+        vm.popScope();
+        CHECK(vm.get("X")->toString() == "assigned");
+
+        vm.popScope();
+        vm.popScope();
+        CHECK(vm.scopeDepth() == 1);
+        CHECK(vm.expand("$X $G $NEW") == "outer  created");
+    }
+
+    SECTION("an unset local stays local") {
+        vm.pushScope();
+        vm.setLocal("X", Variable(std::string("inner")));
+        CHECK(vm.erase("X"));
+        CHECK(vm.get("X") == nullptr);
+        vm.set("X", Variable(std::string("again")));
+        vm.popScope();
+        CHECK(vm.get("X")->toString() == "outer");
+    }
+
+    SECTION("snapshots share entries but not later writes") {
+        VariableManager child = vm.snapshot();
+        CHECK(child.get("X")->toString() == "outer");
+
+        child.setString("X", "child");
+        child.erase("G");
+        vm.setString("ONLY_PARENT", "1");
+        vm.get("X")->stringValue() += "!";
+
+        CHECK(vm.expand("$X $G") == "outer! global");
+        CHECK(child.expand("$X $G $ONLY_PARENT") == "child  ");
+
+        VariableManager grandchild = child.snapshot();
+        child.setString("X", "child2");
+        CHECK(grandchild.get("X")->toString() == "child");
+        CHECK_FALSE(grandchild.contains("G"));
+    }
+
+    SECTION("long snapshot chains stay correct after compaction") {
+        std::vector<VariableManager> held;
+        for (int i = 0; i < 40; ++i) {
+            vm.setInteger("N" + std::to_string(i % 3), i);
+            if (i % 5 == 0) vm.erase("X");
+            if (i % 5 == 1) vm.setString("X", std::to_string(i));
+            held.push_back(vm.snapshot());
+        }
+        CHECK(vm.expand("$N0 $N1 $N2 $X $G") == "39 37 38 36 global");
+        CHECK(held[20].expand("$N0 $N1 $N2 [$X]") == "18 19 20 []");
+        CHECK(held[21].expand("$X") == "21");
+    }
+}
+
+TEST_CASE("NameTable - Interned variable names", "[variables]") {
+    NameTable& names = NameTable::instance();
+    const NameId id = names.intern("LEIZI_TEST_INTERNED");
+    CHECK(names.intern(std::string("LEIZI_TEST_") + "INTERNED") == id);
+    CHECK(names.name(id) == "LEIZI_TEST_INTERNED");
+    CHECK(names.find("LEIZI_TEST_INTERNED") == id);
+
+    const size_t size = names.size();
+    CHECK_FALSE(names.find("LEIZI_TEST_NEVER_SEEN").has_value());
+    VariableManager vm;
+    CHECK(vm.get("LEIZI_TEST_NEVER_SEEN") == nullptr);
+    CHECK_FALSE(vm.erase("LEIZI_TEST_NEVER_SEEN"));
+    CHECK(vm.expand("[$LEIZI_TEST_NEVER_SEEN]") == "[]");
+    CHECK(names.size() == size);
+
+    vm.set(id, Variable(std::string("by id")));
+    CHECK(vm.get("LEIZI_TEST_INTERNED")->toString() == "by id");
+    vm.setString("LEIZI_TEST_INTERNED", "by name");
+    CHECK(vm.get(id)->toString() == "by name");
+}
+
+TEST_CASE("VariableManager - Command substitution", "[variables]") {
+    VariableManager vm;
+    std::vector<std::string> seen;
+    auto substitute = [&](const std::string& command) {
+        seen.push_back(command);
+        return "<" + command + ">";
+    };
+
+    SECTION("$(...) and backticks call the substituter once, output is not rescanned") {
+        CHECK(vm.expand("a $(echo $HOME) `pwd`b", {}, substitute) == "a <echo $HOME> <pwd>b");
+        CHECK(seen == std::vector<std::string>{"echo $HOME", "pwd"});
+    }
+
+    SECTION("nesting, quotes and arithmetic") {
+        CHECK(vm.expand("$(echo $(date) \")\")", {}, substitute) == "<echo $(date) \")\">");
+        CHECK(substitutionEnd("$(a (b) c) d", 0) == 9);
+        CHECK(substitutionEnd("`a` b", 0) == 2);
+        CHECK(substitutionEnd("$(open", 0) == std::string::npos);
+        CHECK(vm.expand("$((1+2))", {}, substitute) == "$((1+2))");
+        CHECK(vm.expand("$(a)", {}, {}) == "$(a)");
+        CHECK(seen.size() == 1);
+    }
+
+    SECTION("escaped $ and backticks stay literal") {
+        vm.setString("X", "1");
+        CHECK(vm.expand("\\$X \\$(cmd) \\`cmd\\` $X\\", {}, substitute) == "$X $(cmd) `cmd` 1\\");
+        CHECK(vm.expand(escapeExpansion("a$(b)`c`$X"), {}, substitute) == "a$(b)`c`$X");
+        CHECK(vm.expand("a`b", {}, {}) == "a`b");
+        CHECK(seen.empty());
+    }
+}
+
+TEST_CASE("VariableManager - Parameter expansion operators", "[variables]") {
+    VariableManager vm;
+    vm.setString("FILE", "src/core/parser.tar.gz");
+    vm.setString("EMPTY", "");
+    vm.setString("N", "2");
+    vm.setInteger("COUNT", 42);
+    vm.setArray("ARR", {"alpha", "beta", "gamma", "delta"});
+    auto env = [](const std::string& name) -> std::optional<std::string> {
+        if (name == "HOME") return std::string("/home/leizi");
+        return std::nullopt;
+    };
+
+    SECTION("defaults and alternatives") {
+        CHECK(vm.expand("${UNSET:-fallback}") == "fallback");
+        CHECK(vm.expand("${EMPTY:-fallback}") == "fallback");
+        CHECK(vm.expand("${EMPTY-fallback}").empty());
+        CHECK(vm.expand("${UNSET:-$FILE}") == "src/core/parser.tar.gz");
+        CHECK(vm.expand("${UNSET:-${EMPTY:-nested}}") == "nested");
+        CHECK(vm.expand("${COUNT:+set}") == "set");
+        CHECK(vm.expand("${EMPTY:+set}").empty());
+        CHECK(vm.expand("${EMPTY+set}") == "set");
+        CHECK(vm.expand("${HOME:-none}", env) == "/home/leizi");
+    }
+
+    SECTION("length, trimming and replacement") {
+        CHECK(vm.expand("${#FILE}") == "22");
+        CHECK(vm.expand("${#COUNT}") == "2");
+        CHECK(vm.expand("${FILE#*/}") == "core/parser.tar.gz");
+        CHECK(vm.expand("${FILE##*/}") == "parser.tar.gz");
+        CHECK(vm.expand("${FILE%.*}") == "src/core/parser.tar");
+        CHECK(vm.expand("${FILE%%.*}") == "src/core/parser");
+        CHECK(vm.expand("${FILE#src/}") == "core/parser.tar.gz");
+        CHECK(vm.expand("${FILE%.zip}") == "src/core/parser.tar.gz");
+        CHECK(vm.expand("${FILE/r/R}") == "sRc/core/parser.tar.gz");
+        CHECK(vm.expand("${FILE//r/R}") == "sRc/coRe/paRseR.taR.gz");
+        CHECK(vm.expand("${FILE//[aeiou]}") == "src/cr/prsr.tr.gz");
+        CHECK(vm.expand("${FILE/#src/lib}") == "lib/core/parser.tar.gz");
+        CHECK(vm.expand("${FILE/%.gz/.xz}") == "src/core/parser.tar.xz");
+        CHECK(vm.expand("${FILE/c*\\//}") == "srparser.tar.gz");
+    }
+
+    SECTION("substrings") {
+        CHECK(vm.expand("${FILE:4}") == "core/parser.tar.gz");
+        CHECK(vm.expand("${FILE:4:4}") == "core");
+        CHECK(vm.expand("${FILE: -2}") == "gz");
+        CHECK(vm.expand("${FILE:0:-7}") == "src/core/parser");
+        CHECK(vm.expand("${FILE:$N:1}") == "c");
+        CHECK(vm.expand("${FILE:100}").empty());
+    }
+
+    SECTION("arrays") {
+        CHECK(vm.expand("${ARR}") == "alpha");
+        CHECK(vm.expand("${ARR[@]}") == "alpha beta gamma delta");
+        CHECK(vm.expand("${ARR[1]} ${ARR[-1]} ${ARR[$N]}") == "alpha delta beta");
+        CHECK(vm.expand("${ARR[9]:-none}") == "none");
+        CHECK(vm.expand("${#ARR} ${#ARR[@]} ${#ARR[2]}") == "4 4 4");
+        CHECK(vm.expand("${ARR[@]:1:2}") == "beta gamma");
+        CHECK(vm.expand("${ARR[@]%a}") == "alph bet gamm delt");
+        CHECK(vm.expand("${ARR[@]/a/A}") == "Alpha betA gAmma deltA");
+    }
+
+    SECTION("special parameters go to the resolver") {
+        auto special = [](const std::string& name) -> std::optional<std::string> {
+            if (name == "?") return std::string("3");
+            if (name == "$") return std::string("4242");
+            if (name == "0") return std::string("leizi");
+            return std::nullopt;
+        };
+        CHECK(vm.expand("${?} ${$} ${0}", special) == "3 4242 leizi");
+        CHECK(vm.expand("${#?} ${?:+failed} ${!:-none}", special) == "1 failed none");
+        CHECK(vm.expand("[${#}]", special) == "[]");
+    }
+
+    SECTION("malformed forms") {
+        CHECK(vm.expand("${FILE") == "${FILE");
+        CHECK(vm.expand("$ ${}x") == "$ x");
+        CHECK(vm.expand("cost: $") == "cost: $");
+    }
+}
+
+TEST_CASE("Output capture helpers", "[variables]") {
+    SECTION("ScopedOutputCapture swaps the stream buffer") {
+        std::string output;
+        {
+            ScopedOutputCapture capture(std::cout, output);
+            std::cout << "captured " << 42 << '\n';
+        }
+        CHECK(output == "captured 42\n");
+    }
+
+    SECTION("readToEnd drains a pipe and trimTrailingNewlines trims in place") {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        const std::string payload(100000, 'x');
+        pid_t pid = fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            close(fds[0]);
+            std::string data = payload + "\n\n";
+            for (size_t done = 0; done < data.size();) {
+                ssize_t n = write(fds[1], data.data() + done, data.size() - done);
+                if (n <= 0) _exit(1);
+                done += static_cast<size_t>(n);
+            }
+            _exit(0);
+        }
+        close(fds[1]);
+        std::string buffer;
+        CHECK(readToEnd(fds[0], buffer));
+        close(fds[0]);
+        waitpid(pid, nullptr, 0);
+
+        trimTrailingNewlines(buffer);
+        CHECK(buffer == payload);
     }
 }